@@ -1,860 +1,3252 @@
-/**
- * @file syamfp.hpp
- * @author KATOI (y.yagi@gmail.com)
- * @brief Mathmatical Function Parser with Shunting Yard Algorithm
- * @version 1.0
- * @date 2024-12-02
- *
- * @copyright Copyright (c) 2024
- *
- */
-
-#ifndef __SYAMFP_HPP__
-#define __SYAMFP_HPP__
-
-#include <algorithm>
-#include <charconv>
-#include <concepts>
-#include <complex>
-#include <cstdint>
-#include <deque>
-#include <errno.h>
-#include <functional>
-#include <iostream>
-#include <mutex>
-#include <numbers>
-#include <regex>
-#include <stdexcept>
-#include <string>
-#include <string_view>
-#include <type_traits>
-#include <unordered_map>
-#include <unordered_set>
-#include <vector>
-
-namespace SYAMFP
-{
-
-	/** @note usually, you need not to use this namespace */
-	namespace Details
-	{
-		/** @brief value type used in constance value
-		 *  @note  You developer can change the type if you want to use other type like float128_t in C++23. */
-		using ValueType = double;
-
-		template <typename Type>
-		concept MathConcept
-			 = std::is_convertible_v<ValueType, Type> /* This means T is required to be able to be rleated by ValueType. */
-			&& requires(Type a, Type b) {
-				/* and support functions bellow: */
-				{ std::sin(a) }         -> std::convertible_to<Type>;
-				{ std::cos(a) }         -> std::convertible_to<Type>;
-				{ std::tan(a) }         -> std::convertible_to<Type>;
-				{ std::asin(a) }        -> std::convertible_to<Type>;
-				{ std::acos(a) }        -> std::convertible_to<Type>;
-				{ std::atan(a) }        -> std::convertible_to<Type>;
-				{ std::sinh(a) }        -> std::convertible_to<Type>;
-				{ std::cosh(a) }        -> std::convertible_to<Type>;
-				{ std::tanh(a) }        -> std::convertible_to<Type>;
-				{ std::asinh(a) }       -> std::convertible_to<Type>;
-				{ std::acosh(a) }       -> std::convertible_to<Type>;
-				{ std::atanh(a) }       -> std::convertible_to<Type>;
-				{ std::exp(a) }         -> std::convertible_to<Type>;
-				{ std::log(a) }         -> std::convertible_to<Type>;
-				{ std::log10(a) }       -> std::convertible_to<Type>;
-				{ std::sqrt(a) }        -> std::convertible_to<Type>;
-				{ std::pow(a, b) }      -> std::convertible_to<Type>;
-
-				/* and support operators bellow: */
-				{ a + b } -> std::convertible_to<Type>;
-				{ a - b } -> std::convertible_to<Type>;
-				{ a * b } -> std::convertible_to<Type>;
-				{ a / b } -> std::convertible_to<Type>;
-			};
-
-
-		template <MathConcept Type>
-		using Func = Type (*)(const std::vector<Type>&);
-
-		enum class TokenType
-		{
-			Variable,   /* x, z, a, etc. */
-			Constant,   /* pi, e, sqrt2, etc. */
-			Real,       /* 0, -5, 3.14, etc. */
-			Imaginary,  /* i, 3i, -2.5i, etc. */
-			Operator,   /* only +, -, *, /, ^ */
-			Func1,      /* sin, cos, exp, etc. */
-			Func2,      /* pow, Bessel, etc. */
-			Func3,      /* laguerre, etc. */
-			LParen,     /* ( */
-			RParen,     /* )*/
-			Comma,      /* , */
-		};
-
-
-		template <MathConcept Type>
-		struct Token
-		{
-			std::string str;
-			TokenType   type;
-			int         arg_num;
-			Type        value;
-			Func<Type>  func;
-
-			Token() = default;
-			Token(const std::string& str);
-			Token(const std::string& str, TokenType type, int arg_num, const Type& val, Func<Type> func)
-				: str(str), type(type), arg_num(arg_num), value(val), func(func) {}
-		};
-
-		template <MathConcept Type>
-		bool operator==(const Token<Type>& T1, const Token<Type>& T2)
-		{
-			return (T1.str == T2.str) && (T1.type == T2.type) && (T1.arg_num == T2.arg_num)
-				&& (T1.value == T2.value) && (T1.func == T2.func);
-		}
-
-		template <MathConcept Type>
-		bool operator!=(const Token<Type>& T1, const Token<Type>& T2) { return !(T1 == T2); }
-
-
-		template <MathConcept Type>
-		std::unordered_map<std::string, Token<Type>>
-		RESERVED_TOKEN =
-		{
-			/* Operator */
-			{ "+", Token<Type>{ "+", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return args[0] + args[1]; } } },
-			{ "-", Token<Type>{ "-", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return args[0] - args[1]; } } },
-			{ "*", Token<Type>{ "*", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return args[0] * args[1]; } } },
-			{ "/", Token<Type>{ "/", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return args[0] / args[1]; } } },
-			{ "^", Token<Type>{ "/", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return std::pow(args[0], args[1]); } } },
-
-			{ "(", Token<Type>{ "(", TokenType::LParen, 0, 0, nullptr } },
-			{ ")", Token<Type>{ ")", TokenType::RParen, 0, 0, nullptr } },
-			{ ",", Token<Type>{ ",", TokenType::Comma,  0, 0, nullptr } },
-
-			/* Constant */
-			{	"pi",
-				Token<Type>{ "pi", TokenType::Constant, 0, std::numbers::pi_v<ValueType>, nullptr }
-			},
-			{	"inv_pi",
-				Token<Type>{ "inv_pi", TokenType::Constant, 0, std::numbers::inv_pi_v<ValueType>, nullptr }
-			},
-			{	"inv_sqrtpi",
-				Token<Type>{ "inv_sqrtpi", TokenType::Constant, 0, std::numbers::inv_sqrtpi_v<ValueType>, nullptr }
-			},
-			{	"e",
-				Token<Type>{ "e", TokenType::Constant, 0, std::numbers::e_v<ValueType>, nullptr }
-			},
-			{	"sqrt2",
-				Token<Type>{ "sqrt2", TokenType::Constant, 0, std::numbers::sqrt2_v<ValueType>, nullptr }
-			},
-			{	"sqrt3",
-				Token<Type>{ "sqrt3", TokenType::Constant, 0, std::numbers::sqrt3_v<ValueType>, nullptr }
-			},
-			{	"ln2",
-				Token<Type>{ "ln2", TokenType::Constant, 0, std::numbers::ln2_v<ValueType>, nullptr }
-			},
-			{	"ln10",
-				Token<Type>{ "ln10", TokenType::Constant, 0, std::numbers::ln10_v<ValueType>, nullptr }
-			},
-			{	"log2e",
-				Token<Type>{ "log2e", TokenType::Constant, 0, std::numbers::log2e_v<ValueType>, nullptr }
-			},
-			{	"log10e",
-				Token<Type>{ "log10e", TokenType::Constant, 0, std::numbers::log10e_v<ValueType>, nullptr }
-			},
-			{	"egamma",
-				Token<Type>{ "egamma", TokenType::Constant, 0, std::numbers::egamma_v<ValueType>, nullptr }
-			},
-			{	"phi",
-				Token<Type>{ "phi", TokenType::Constant, 0, std::numbers::phi_v<ValueType>, nullptr }
-			},
-
-			/* Func1 */
-			{	"sin",
-				Token<Type>{
-					"sin", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::sin(args[0]); }
-				}
-			},
-			{	"cos",
-				Token<Type>{
-					"cos", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::cos(args[0]); }
-				}
-			},
-			{	"tan",
-				Token<Type>{
-					"tan", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::tan(args[0]); }
-				}
-			},
-			{	"asin",
-				Token<Type>{
-					"asin", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::asin(args[0]); }
-				}
-			},
-			{	"acos",
-				Token<Type>{
-					"acos", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::acos(args[0]); }
-				}
-			},
-			{	"atan",
-				Token<Type>{
-					"atan", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::atan(args[0]); }
-				}
-			},
-			{	"sinh",
-				Token<Type>{
-					"sinh", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::sinh(args[0]); }
-				}
-			},
-			{	"cosh",
-				Token<Type>{
-					"cosh", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::cosh(args[0]); }
-				}
-			},
-			{	"tanh",
-				Token<Type>{
-					"tanh", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::tanh(args[0]); }
-				}
-			},
-			{	"asinh",
-				Token<Type>{
-					"asinh", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::asinh(args[0]); }
-				}
-			},
-			{	"acosh",
-				Token<Type>{
-					"acosh", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::acosh(args[0]); }
-				}
-			},
-			{	"atanh",
-				Token<Type>{
-					"atanh", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::atanh(args[0]); }
-				}
-			},
-			{	"exp",
-				Token<Type>{
-					"exp", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::exp(args[0]); }
-				}
-			},
-			{	"log",
-				Token<Type>{
-					"log", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::log(args[0]); }
-				}
-			},
-			{	"log10",
-				Token<Type>{
-					"log10", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::log10(args[0]); }
-				}
-			},
-			{	"ln",
-				Token<Type>{
-					"ln", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::log(args[0]); }
-				}
-			},
-			{	"sqrt",
-				Token<Type>{
-					"sqrt", TokenType::Func1, 1, 0,
-					[](const std::vector<Type>& args){ return std::sqrt(args[0]); }
-				}
-			},
-
-			/* Func2 */
-			{	"pow",
-				Token<Type>{
-					"pow", TokenType::Func2, 2, 0,
-					[](const std::vector<Type>& args){ return std::pow(args[0], args[1]); }
-				}
-			},
-		};
-
-		template <MathConcept Type>
-		const Token<Type>* LPAREN_p = &RESERVED_TOKEN<Type>.at("(");
-
-		inline bool is_real(const std::string& token)
-		{
-			static const std::regex Real(R"(^[+-]?\d+(\.\d*)?([eE][+-]?\d+)?$)");
-			return std::regex_match(token, Real);
-		}
-
-		inline bool is_imaginary(const std::string& token)
-		{
-			static const std::regex Imag(R"(^[+-]?\d*(\.\d*)?([eE][+-]?\d+)?i$)");
-			return std::regex_match(token, Imag);
-		}
-
-		inline bool is_left_assoc(const std::string& Operator)
-		{
-			static const std::unordered_map<std::string, bool>
-			LEFT_ASSOC_LIST =
-			{
-				{ "+",	true },
-				{ "-",	true },
-				{ "*",	true },
-				{ "/",	true },
-				{ "^",	false},
-			};
-
-			return LEFT_ASSOC_LIST.at(Operator);
-		}
-
-		inline int ret_preced(const std::string& Operator)
-		{
-			static const std::unordered_map<std::string, int>
-			PRECED =
-			{
-				{ "+",	0 },
-				{ "-",	0 },
-				{ "*",	1 },
-				{ "/",	1 },
-				{ "^",	2 },
-			};
-
-			return PRECED.at(Operator);
-		}
-
-
-		template <MathConcept Type>
-		Token<Type>::Token(const std::string& str)
-			: str(str), type(TokenType::Variable), arg_num(0), value(0), func(nullptr)
-		{
-			using namespace std::literals::complex_literals;
-
-			auto pair = RESERVED_TOKEN<Type>.find(str);
-			if (pair != RESERVED_TOKEN<Type>.end()) {
-				type    = pair->second.type;
-				arg_num = pair->second.arg_num;
-				value   = pair->second.value;
-				func    = pair->second.func;
-				return;
-			}
-
-			ValueType val;
-			if (is_real(str)) {
-				type = TokenType::Real;
-				auto [ptr, err] = std::from_chars(str.c_str(), str.c_str() + str.length(), val);
-				value = static_cast<Type>(val);
-			} else if (is_imaginary(str)) {
-				type = TokenType::Imaginary;
-				auto [ptr, err] = std::from_chars(str.c_str(), str.c_str() + str.length() - 1, val);
-				if (str.length() == 1) {
-					val = 1.0;
-				}
-				value = static_cast<Type>(val * 1.0i);
-			} else {
-				type = TokenType::Variable;
-			}
-		}
-
-		template <typename Type>
-		using Tokens = std::deque<Token<Type>>;
-
-		template <typename Type>
-		Tokens<Type> devide_to_tokens(const std::string& formula)
-		{
-			Tokens<Type> tokens;
-			std::string_view str;
-
-			auto is_operator = [](const std::string_view& str) -> bool
-			{
-				auto pair = RESERVED_TOKEN<Type>.find(std::string(str));
-				if (pair == RESERVED_TOKEN<Type>.end())
-					return false;
-
-				TokenType type = pair->second.type;
-				return type == TokenType::Operator
-					|| type == TokenType::LParen
-					|| type == TokenType::RParen
-					|| type == TokenType::Comma;
-			};
-
-			for (const char& c : formula) {
-				if (std::isspace(c)) {
-					if (!str.empty()) {
-						tokens.push_back(Token<Type>(std::string(str)));
-						str = {};
-					}
-					/* ignore spaces */
-					continue;
-				}
-
-				if (str.empty()) {
-					str = {&c, 1};
-					continue;
-				}
-
-				if (is_operator(std::string_view{str.data(), str.length() + 1})) {
-					str = {str.data(), str.length() + 1};
-					continue;
-				}
-
-				if (is_operator(str) || is_operator(std::string_view{&c, 1})) {
-					tokens.emplace_back(Token<Type>(std::string(str)));
-					str = {&c, 1};
-					continue;
-				}
-
-				str = {str.data(), str.length() + 1};
-			}
-
-			if (!str.empty()) {
-				tokens.emplace_back(Token<Type>(std::string(str)));
-			}
-
-			return tokens;
-		}
-
-
-		template <MathConcept Type>
-		using RPNs = std::vector<Token<Type>>;
-
-
-		template <MathConcept Type>
-		bool has_LParen(const RPNs<Type>& stack)
-		{
-			return std::ranges::find(stack, *LPAREN_p<Type>) != stack.end();
-		}
-
-		template <MathConcept Type>
-		bool case_of_RParen(RPNs<Type>& rpn, RPNs<Type>& stack)
-		{
-			if (!has_LParen(stack))
-				return false;
-
-			while (true) {
-				Token<Type> poped = stack.back();
-				stack.pop_back();
-
-				if (poped.type == TokenType::LParen)
-					break;
-
-				rpn.emplace_back(poped);
-			}
-
-			if (stack.empty())
-				return true;
-
-			Token<Type> token_before_RParen = stack.back();
-
-			/* judge whether a token befor "(" is function or not by func pointer:
-			 * only func type onjects have function */
-			if (token_before_RParen.func != nullptr) {
-				rpn.emplace_back(token_before_RParen);
-				stack.pop_back();
-			}
-
-			return true;
-		}
-
-		template <MathConcept Type>
-		bool case_of_Comma(RPNs<Type>& rpn, RPNs<Type>& stack)
-		{
-			if (!has_LParen(stack))
-				return false;
-
-			while (stack.back() != *LPAREN_p<Type>) {
-				rpn.emplace_back(stack.back());
-				stack.pop_back();
-			}
-
-			return true;
-		}
-
-		template <MathConcept Type>
-		void case_of_Operator(RPNs<Type>& rpn, RPNs<Type>& stack, Token<Type> token,
-		                      bool is_prev_token_operator)
-		{
-			if (is_prev_token_operator) {
-				if (token.str == "+") {
-					/* Delete the plus operator to convert "+x" --> "x".
-					 * So token is not pushed into any stack. */
-					return;
-				}
-
-				if (token.str == "-") {
-					/* Convert "-X" --> "-1 * X", considering the case where X is a function */
-					rpn.emplace_back(Token<Type>("-1"));
-					token = Token<Type>("*"); /* The token becomes "-1 * X" from "-X", and this token is parsed in later process. */
-				}
-			}
-
-			while (!stack.empty()) {
-				Token<Type> poped = stack.back();
-				if (poped.type != TokenType::Operator)
-					break;
-
-				int preced_t = ret_preced(token.str);
-				int preced_p = ret_preced(poped.str);
-
-				if (is_left_assoc(token.str)) {
-					if (preced_t > preced_p) break;
-				} else {
-					if (preced_t >= preced_p) break;
-				}
-
-				rpn.emplace_back(poped);
-				stack.pop_back();
-			}
-
-			stack.emplace_back(token);
-		}
-
-		template <MathConcept Type>
-		const RPNs<Type> BAD_RPNs = RPNs<Type>();
-
-		template <MathConcept Type>
-		RPNs<Type> make_rpn(const std::string& formula)
-		{
-			Tokens<Type> tokens = devide_to_tokens<Type>(formula);
-			RPNs<Type> rpn;
-			RPNs<Type> stack;
-			bool is_prev_token_operator = true;
-			bool retval = true;
-
-			while (!tokens.empty()) {
-				Token<Type> token = tokens.front();
-				tokens.pop_front();
-
-				switch (token.type)
-				{
-				case TokenType::Variable :
-				case TokenType::Constant :
-				case TokenType::Real :
-				case TokenType::Imaginary :
-					is_prev_token_operator = false;
-					rpn.emplace_back(token);
-					break;
-
-				case TokenType::Func1 :
-				case TokenType::Func2 :
-				case TokenType::Func3 :
-					is_prev_token_operator = false;
-					stack.emplace_back(token);
-					break;
-
-				case TokenType::LParen :
-					is_prev_token_operator = true;
-					stack.emplace_back(token);
-					break;
-
-				case TokenType::RParen :
-					is_prev_token_operator = false;
-					retval = case_of_RParen<Type>(rpn, stack);
-					break;
-
-				case TokenType::Comma :
-					is_prev_token_operator = false;
-					retval = case_of_Comma<Type>(rpn, stack);
-					break;
-
-				case TokenType::Operator :
-					case_of_Operator<Type>(rpn, stack, token, is_prev_token_operator);
-					is_prev_token_operator = true;
-					break;
-				}
-
-				if (retval != true) {
-					return BAD_RPNs<Type>;
-				}
-			}
-
-			/* Push the remaining operators in thg stacks */
-			while (!stack.empty()) {
-				if (has_LParen<Type>(stack)) {
-					return BAD_RPNs<Type>;
-				}
-				rpn.emplace_back(stack.back());
-				stack.pop_back();
-			}
-
-			return rpn;
-		}
-	}
-
-	template <Details::MathConcept Type>
-	class VariableTable
-	{
-	private:
-		std::unordered_map< std::string, Type > variables;
-
-		template <typename STR, typename VAL>
-		void insert_variable(const STR& str, const VAL& val)
-		{
-			variables[std::string(str)] = static_cast<Type>(val);
-		}
-
-		template <typename STR, typename VAL, typename... REST>
-		void insert_variable(const STR& str, const VAL& val, const REST&... rest)
-		{
-			variables[std::string(str)] = static_cast<Type>(val);
-			insert_variable(rest...); /* recursive call for the remaining argumets */
-		}
-
-	public:
-		VariableTable() = default;
-		VariableTable(const std::string& str, const Type& val)
-		{
-			variables[str] = val;
-		}
-
-		/**
-		 * @brief Variadic constructor to create a VariableTable object with multiple variable name-value pairs.
-		 *
-		 * This constructor initializes the table with multiple variable name-value pairs provided as arguments.
-		 *
-		 * @tparam `STRING` The type of the std::string input.
-		 * @tparam `TYPE` The type of the value input.
-		 * @tparam `REST` Variadic arguments for additional variable name-value pairs.
-		 * @param str1 The name of the first variable.
-		 * @param val1 The value of the first variable.
-		 * @param rest Subsequent variable name-value pairs.
-		 */
-		template <typename STRING, typename TYPE, typename... REST>
-		VariableTable(const STRING& str1, const TYPE& val1, const REST&... rest)
-		{
-			insert_variable(str1, val1, rest...);
-		}
-
-		~VariableTable() = default;
-
-		bool contains(const std::string& str) const noexcept
-		{
-			return variables.contains(str);
-		}
-
-		Type at(const std::string& str) const
-		{
-			return variables.at(str);
-		}
-
-		void add(const std::string& str, const Type& val)
-		{
-			insert_variable(str, val);
-		}
-
-		void clear_all(void)
-		{
-			variables->clear();
-		}
-
-		VariableTable<Type> operator+=(const std::pair<std::string, Type>& pair)
-		{
-			insert_variable(pair.first, pair.second);
-			return *this;
-		}
-
-		Type& operator[](const std::string& str)
-		{
-			return variables[str];
-		}
-
-		/** @return `auto` return iterator of the first variable in this table */
-		auto begin(void) const
-		{
-			return variables.begin();
-		}
-
-		/** @return `auto` return iterator of the end variable in this table */
-		auto end(void) const
-		{
-			return variables.end();
-		}
-	};
-
-
-	namespace Details
-	{
-		template <MathConcept Type>
-		using Stack = std::deque<Type>;
-
-		template <MathConcept Type>
-		using CompiledFunc = std::function<void(Stack<Type>&, const VariableTable<Type>&)>;
-
-		template <MathConcept Type>
-		using CompiledRPN = std::vector<CompiledFunc<Type>>;
-
-		using VariableList = std::unordered_set<std::string>;
-
-		/**
-		 * @brief parse rpn and make function object list
-		 *
-		 * @tparam `Type` MathConcept type
-		 * @param[in] rpn
-		 * @param[out] var_list this is inserted variable strings used in rpn. use it to check variable table.
-		 * @return `CompiledRPN<Type>`
-		 * @throw `std::invalid_argument` if the number of function argument is invalid
-		 */
-		template <MathConcept Type>
-		CompiledRPN<Type> compile_RPN(const RPNs<Type>& rpn, VariableList& var_list)
-		{
-			int var_cnt = 0; /* for format check */
-			CompiledRPN<Type> crpn;
-			var_list.clear();
-
-			for (const Details::Token<Type>& token : rpn) {
-				switch (token.type)
-				{
-				case TokenType::Variable :
-					var_list.insert(token.str);
-					crpn.emplace_back([token](Stack<Type>& stack, const VariableTable<Type>& table)
-					{
-						stack.emplace_back(table.at(token.str));
-					});
-					break;
-				case TokenType::Constant :
-				case TokenType::Real :
-				case TokenType::Imaginary :
-					crpn.emplace_back([token](Stack<Type>& stack, const VariableTable<Type>& table)
-					{
-						stack.emplace_back(token.value);
-					});
-					break;
-				case TokenType::Operator :
-				case TokenType::Func1 :
-				case TokenType::Func2 :
-				case TokenType::Func3 :
-					var_cnt -= token.arg_num;
-					if (var_cnt < 0) {
-						throw std::invalid_argument("Invalid formula: missing number of argument for " + token.str);
-					}
-					crpn.emplace_back([token](Stack<Type>& stack, const VariableTable<Type>& table)
-					{
-						std::vector<Type> args(token.arg_num);
-						for (int n = token.arg_num - 1; n >= 0; --n) {
-							args[n] = stack.back();
-							stack.pop_back();
-						}
-						stack.emplace_back(token.func(args));
-					});
-					break;
-				}
-				var_cnt++;
-			}
-
-			if (var_cnt != 1) {
-				throw std::invalid_argument("Invalid formula: some functions have too many arguments");
-			}
-
-			return crpn; /* return value equal to BAD_CRPN if rpn is BAD_RPNs */
-		}
-	}
-
-
-	template <Details::MathConcept Type>
-	class Syamfp
-	{
-	private:
-		std::string formula;
-		VariableTable<Type> table;
-		Details::VariableList vars;
-		Details::CompiledRPN<Type> crpn;
-
-	public:
-		Syamfp() = default;
-
-		Syamfp(const std::string& formula, const VariableTable<Type>& table = VariableTable<Type>())
-			: formula(formula), table(table), vars(), crpn() {};
-
-		~Syamfp() = default;
-
-		/**
-		 * @brief parse and compile formula
-		 * @param formula compiled formula
-		 * @return `int` `0`:Success, `negative`:Error
-		 */
-		int parse(const std::string& formula)
-		{
-			auto rpn = Details::make_rpn<Type>(formula);
-			if (rpn == Details::BAD_RPNs<Type>) {
-				return -EINVAL;
-			}
-
-			try {
-				auto crpn = Details::compile_RPN<Type>(rpn, vars);
-				this->crpn = crpn;
-				this->formula = formula;
-				return 0;
-			} catch (const std::exception& e) {
-				return -EINVAL;
-			}
-		}
-
-		/**
-		 * @brief parse and compile formula
-		 * @param formula compiled formula
-		 * @param table used variable table
-		 * @return `int` `0`:Success, `negative`:Error
-		 */
-		int parse(const std::string& formula, const VariableTable<Type>& table)
-		{
-			this->table = table;
-			return parse(formula);
-		}
-
-		/** @brief register variable table */
-		void regist(const VariableTable<Type>& table)
-		{
-			this->table = table;
-		}
-
-		/**
-		 * @brief return functional object
-		 *
-		 * @param[in] variable_string variable string used as variable like "x", "z", etc.
-		 * @return `auto` functional object
-		 * @throw `std::runtime_error` if unknown variable is included in function
-		 */
-		auto ret_func(const std::string& variable_string) -> std::function<Type(const Type&)>
-		{
-			/* check variable list */
-			for (const std::string& str : vars) {
-				if (!table.contains(str) && (str != variable_string)) {
-					throw std::runtime_error("Invalid function: some variable are not determined");
-				}
-			}
-
-			/* copy member variable to use in lambda function */
-			VariableTable<Type> Table = table;
-			Details::CompiledRPN<Type> CRPN = crpn;
-			return [Table, CRPN, variable_string](const Type& value) -> Type
-			{
-				Details::Stack<Type> stack;
-				VariableTable<Type> table(Table);
-				table += {variable_string, value};
-
-				for (const Details::CompiledFunc<Type>& func : CRPN) {
-					func(stack, table);
-				}
-
-				return stack.front();
-			};
-		}
-	};
-
-	template <Details::MathConcept Type>
-	void add_custom_function(const std::string& name, Details::TokenType type, int arg_num, Details::Func<Type> lambda)
-	{
-		Details::RESERVED_TOKEN<Type>.insert({
-			name,
-			Details::Token<Type>(name, type, arg_num, static_cast<Details::ValueType>(0.0), lambda)
-		});
-	}
-}
-
-#endif /* end of __SYAMFP_HPP__ */
+/**
+ * @file syamfp.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Mathmatical Function Parser with Shunting Yard Algorithm
+ * @version 1.0
+ * @date 2024-12-02
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_HPP__
+#define __SYAMFP_HPP__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <concepts>
+#include <complex>
+#include <cstdint>
+#include <deque>
+#include <errno.h>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace SYAMFP
+{
+	/** @brief interpolation of data tables */
+	enum class Interpolation
+	{
+		Linear,
+		Cubic,   /* cubic Hermite with the slopes by central differences (Catmull-Rom on uniform grids) */
+	};
+
+	/** @note usually, you need not to use this namespace */
+	namespace Details
+	{
+		/** @brief value type used in constance value
+		 *  @note  You developer can change the type if you want to use other type like float128_t in C++23. */
+		using ValueType = double;
+
+		/**
+		 * @brief functions of the types found by argument-dependent lookup, and those of std for the builtin types
+		 * @note  functions of user-defined types (e.g. dd_real) are declared in their own namespace, not in std.
+		 */
+		namespace Math
+		{
+			using std::sin;
+			using std::cos;
+			using std::tan;
+			using std::asin;
+			using std::acos;
+			using std::atan;
+			using std::sinh;
+			using std::cosh;
+			using std::tanh;
+			using std::asinh;
+			using std::acosh;
+			using std::atanh;
+			using std::exp;
+			using std::log;
+			using std::log10;
+			using std::sqrt;
+			using std::pow;
+
+			template <typename Type>
+			concept Functions = requires(Type a, Type b) {
+				{ sin(a) }        -> std::convertible_to<Type>;
+				{ cos(a) }        -> std::convertible_to<Type>;
+				{ tan(a) }        -> std::convertible_to<Type>;
+				{ asin(a) }       -> std::convertible_to<Type>;
+				{ acos(a) }       -> std::convertible_to<Type>;
+				{ atan(a) }       -> std::convertible_to<Type>;
+				{ sinh(a) }       -> std::convertible_to<Type>;
+				{ cosh(a) }       -> std::convertible_to<Type>;
+				{ tanh(a) }       -> std::convertible_to<Type>;
+				{ asinh(a) }      -> std::convertible_to<Type>;
+				{ acosh(a) }      -> std::convertible_to<Type>;
+				{ atanh(a) }      -> std::convertible_to<Type>;
+				{ exp(a) }        -> std::convertible_to<Type>;
+				{ log(a) }        -> std::convertible_to<Type>;
+				{ log10(a) }      -> std::convertible_to<Type>;
+				{ sqrt(a) }       -> std::convertible_to<Type>;
+				{ pow(a, b) }     -> std::convertible_to<Type>;
+			};
+		}
+
+		template <typename Type>
+		concept MathConcept
+			 = std::is_convertible_v<ValueType, Type> /* This means T is required to be able to be rleated by ValueType. */
+			&& Math::Functions<Type> /* and support functions sin, cos, ..., sqrt and pow */
+			&& requires(Type a, Type b) {
+				/* and support operators bellow: */
+				{ a + b } -> std::convertible_to<Type>;
+				{ a - b } -> std::convertible_to<Type>;
+				{ a * b } -> std::convertible_to<Type>;
+				{ a / b } -> std::convertible_to<Type>;
+			};
+
+
+		/** @return `Type` the number of double converted through ValueType */
+		template <MathConcept Type>
+		Type num(double value)
+		{
+			return static_cast<Type>(static_cast<ValueType>(value));
+		}
+
+		template <MathConcept Type>
+		using Func = Type (*)(const std::vector<Type>&);
+
+		enum class TokenType
+		{
+			Variable,   /* x, z, a, etc. */
+			Constant,   /* pi, e, sqrt2, etc. */
+			Real,       /* 0, -5, 3.14, etc. */
+			Imaginary,  /* i, 3i, -2.5i, etc. */
+			Operator,   /* only +, -, *, /, ^ */
+			Func0,      /* randu, randn */
+			Func1,      /* sin, cos, exp, etc. */
+			Func2,      /* pow, Bessel, etc. */
+			Func3,      /* laguerre, etc. */
+			Table,      /* data table added by add_data_table() */
+			LParen,     /* ( */
+			RParen,     /* )*/
+			Comma,      /* , */
+		};
+
+
+		template <MathConcept Type>
+		struct Token
+		{
+			std::string str;
+			TokenType   type;
+			int         arg_num;
+			Type        value;
+			Func<Type>  func;
+
+			Token() = default;
+			Token(const std::string& str);
+			Token(const std::string& str, TokenType type, int arg_num, const Type& val, Func<Type> func)
+				: str(str), type(type), arg_num(arg_num), value(val), func(func) {}
+		};
+
+		template <MathConcept Type>
+		bool operator==(const Token<Type>& T1, const Token<Type>& T2)
+		{
+			return (T1.str == T2.str) && (T1.type == T2.type) && (T1.arg_num == T2.arg_num)
+				&& (T1.value == T2.value) && (T1.func == T2.func);
+		}
+
+		template <MathConcept Type>
+		bool operator!=(const Token<Type>& T1, const Token<Type>& T2) { return !(T1 == T2); }
+
+
+		/**
+		 * @brief Philox4x32-10 counter based random number generator
+		 *
+		 * The output depends only on (counter, key), so that any element of any stream can be
+		 * generated independently. This makes threaded and batch generation reproducible.
+		 */
+		inline std::array<std::uint32_t, 4> philox(std::array<std::uint32_t, 4> ctr, std::array<std::uint32_t, 2> key)
+		{
+			constexpr std::uint32_t M0 = 0xD2511F53;
+			constexpr std::uint32_t M1 = 0xCD9E8D57;
+			constexpr std::uint32_t W0 = 0x9E3779B9;
+			constexpr std::uint32_t W1 = 0xBB67AE85;
+
+			for (int round = 0; round < 10; ++round) {
+				const std::uint64_t p0 = static_cast<std::uint64_t>(M0) * ctr[0];
+				const std::uint64_t p1 = static_cast<std::uint64_t>(M1) * ctr[2];
+				ctr = {
+					static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+					static_cast<std::uint32_t>(p1),
+					static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+					static_cast<std::uint32_t>(p0),
+				};
+				key[0] += W0;
+				key[1] += W1;
+			}
+			return ctr;
+		}
+
+		/** @return `double` uniform random number in (0, 1) made of 53 bits */
+		inline double to_uniform(std::uint32_t hi, std::uint32_t lo)
+		{
+			const std::uint64_t bits = ((static_cast<std::uint64_t>(hi) << 32) | lo) >> 11;
+			return (static_cast<double>(bits) + 0.5) * 0x1.0p-53;
+		}
+
+		/** @brief stream of uniform random numbers identified by (seed, stream) */
+		class CounterRNG
+		{
+		private:
+			std::uint64_t seed;
+			std::uint64_t stream;
+			std::uint64_t counter = 0;
+			std::array<std::uint32_t, 4> buffer;
+			int used = 2; /* one block makes two doubles */
+
+		public:
+			CounterRNG(std::uint64_t seed, std::uint64_t stream)
+				: seed(seed), stream(stream) {}
+
+			/** @return `double` uniform random number in (0, 1) */
+			double uniform(void)
+			{
+				if (used == 2) {
+					buffer = philox(
+						{ static_cast<std::uint32_t>(counter), static_cast<std::uint32_t>(counter >> 32),
+						  static_cast<std::uint32_t>(stream),  static_cast<std::uint32_t>(stream >> 32) },
+						{ static_cast<std::uint32_t>(seed),    static_cast<std::uint32_t>(seed >> 32) });
+					counter++;
+					used = 0;
+				}
+				const double u = to_uniform(buffer[2 * used], buffer[2 * used + 1]);
+				used++;
+				return u;
+			}
+		};
+
+		/** @return `CounterRNG&` random number generator of the thread used by functions of ret_func() */
+		inline CounterRNG& thread_random(void)
+		{
+			static std::atomic<std::uint64_t> streams = 0;
+			thread_local CounterRNG rng(0, streams++);
+			return rng;
+		}
+
+
+		/** @return `double` coordinate of the value, which is the real part for complex numbers */
+		template <MathConcept Type>
+		double coordinate(const Type& value)
+		{
+			if constexpr (requires { static_cast<double>(value.real()); })
+				return static_cast<double>(value.real());
+			else
+				return static_cast<double>(value);
+		}
+
+		/**
+		 * @brief numeric table of one or two variables interpolated on its grid
+		 *
+		 * The grid may be non-uniform. The cell of a variable is found by a bucket index made at the
+		 * registration, so no binary search is done at each evaluation. The variables out of the grid are clamped.
+		 */
+		template <MathConcept Type>
+		class DataTable
+		{
+		private:
+			struct Axis
+			{
+				std::vector<double>        knots;
+				std::vector<std::uint32_t> bucket;  /* bucket[b] is the cell of knots[0] + b / inv_width */
+				double                     inv_width = 0.0;
+			};
+
+			std::array<Axis, 2> axes;
+			std::size_t         dim = 1;
+			std::vector<Type>   values;  /* values[j * nx + i] */
+			Interpolation       interpolation = Interpolation::Linear;
+
+			static Axis make_axis(const std::vector<double>& knots)
+			{
+				if (knots.size() < 2) {
+					throw std::invalid_argument("DataTable: axis must have two points at least");
+				}
+				for (std::size_t i = 1; i < knots.size(); ++i) {
+					if (!(knots[i - 1] < knots[i])) {
+						throw std::invalid_argument("DataTable: axis must be strictly increasing");
+					}
+				}
+
+				Axis axis;
+				axis.knots = knots;
+				const std::size_t buckets = knots.size();
+				axis.inv_width = static_cast<double>(buckets) / (knots.back() - knots.front());
+				std::uint32_t cell = 0;
+				for (std::size_t b = 0; b < buckets; ++b) {
+					const double x = knots.front() + static_cast<double>(b) / axis.inv_width;
+					while (cell + 2 < knots.size() && knots[cell + 1] <= x) {
+						cell++;
+					}
+					axis.bucket.push_back(cell);
+				}
+				return axis;
+			}
+
+			/** @return `bool` false if the value is out of the grid (and clamped) */
+			static bool locate(const Axis& axis, double x, std::size_t& cell, double& t)
+			{
+				const std::vector<double>& k = axis.knots;
+				const bool inside = k.front() <= x && x <= k.back();
+				x = std::clamp(x, k.front(), k.back());
+
+				const double u = (x - k.front()) * axis.inv_width;
+				cell = axis.bucket[std::min(static_cast<std::size_t>(u), axis.bucket.size() - 1)];
+				while (cell + 2 < k.size() && k[cell + 1] <= x) {
+					cell++;
+				}
+				t = (x - k[cell]) / (k[cell + 1] - k[cell]);
+				return inside;
+			}
+
+			/**
+			 * @brief interpolate the nodes `node(0)`, ..., `node(n - 1)` at t of the cell
+			 * @param[out] slope derivative by the coordinate
+			 */
+			template <typename Node>
+			Type interpolate(const Axis& axis, std::size_t cell, double t, Node&& node, Type& slope) const
+			{
+				const std::vector<double>& k = axis.knots;
+				const double h  = k[cell + 1] - k[cell];
+				const Type   v0 = node(cell);
+				const Type   v1 = node(cell + 1);
+
+				if (interpolation == Interpolation::Linear) {
+					slope = (v1 - v0) / static_cast<Type>(h);
+					return v0 + static_cast<Type>(t) * (v1 - v0);
+				}
+
+				/* slopes at the nodes by central differences, and one-sided at the ends */
+				const std::size_t last = k.size() - 1;
+				const Type m0 = (cell == 0) ? (v1 - v0) / static_cast<Type>(h)
+				              : (v1 - node(cell - 1)) / static_cast<Type>(k[cell + 1] - k[cell - 1]);
+				const Type m1 = (cell + 1 == last) ? (v1 - v0) / static_cast<Type>(h)
+				              : (node(cell + 2) - v0) / static_cast<Type>(k[cell + 2] - k[cell]);
+
+				const double t2 = t * t, t3 = t2 * t;
+				const Type hm0 = static_cast<Type>(h) * m0;
+				const Type hm1 = static_cast<Type>(h) * m1;
+				slope = (static_cast<Type>(6.0 * t2 - 6.0 * t) * v0 + static_cast<Type>(3.0 * t2 - 4.0 * t + 1.0) * hm0
+				       + static_cast<Type>(6.0 * t - 6.0 * t2) * v1 + static_cast<Type>(3.0 * t2 - 2.0 * t) * hm1) / static_cast<Type>(h);
+				return static_cast<Type>(2.0 * t3 - 3.0 * t2 + 1.0) * v0 + static_cast<Type>(t3 - 2.0 * t2 + t) * hm0
+				     + static_cast<Type>(3.0 * t2 - 2.0 * t3) * v1 + static_cast<Type>(t3 - t2) * hm1;
+			}
+
+		public:
+			/**
+			 * @param x             grid of the variable
+			 * @param values        `values[i]` is the value at x[i]
+			 * @param interpolation linear or cubic
+			 * @throw `std::invalid_argument` if the grid is not strictly increasing or the sizes are not equal
+			 */
+			DataTable(const std::vector<double>& x, const std::vector<Type>& values, Interpolation interpolation)
+				: dim(1), values(values), interpolation(interpolation)
+			{
+				axes[0] = make_axis(x);
+				if (values.size() != x.size()) {
+					throw std::invalid_argument("DataTable: the number of values must be the number of grid points");
+				}
+			}
+
+			/**
+			 * @param x, y          grid of the variables
+			 * @param values        `values[j * x.size() + i]` is the value at (x[i], y[j])
+			 * @param interpolation linear or bicubic
+			 * @throw `std::invalid_argument` if the grid is not strictly increasing or the sizes are not equal
+			 */
+			DataTable(const std::vector<double>& x, const std::vector<double>& y, const std::vector<Type>& values,
+			          Interpolation interpolation)
+				: dim(2), values(values), interpolation(interpolation)
+			{
+				axes[0] = make_axis(x);
+				axes[1] = make_axis(y);
+				if (values.size() != x.size() * y.size()) {
+					throw std::invalid_argument("DataTable: the number of values must be the number of grid points");
+				}
+			}
+
+			/** @return `std::size_t` the number of variables */
+			std::size_t dimension(void) const noexcept { return dim; }
+
+			/**
+			 * @brief interpolate the table
+			 * @param[out] dx, dy derivatives by the variables. they are zero out of the grid.
+			 */
+			Type eval(double x, double y, Type& dx, Type& dy) const
+			{
+				const Type zero = static_cast<Type>(static_cast<ValueType>(0.0));
+				std::size_t i;
+				double tx;
+				const bool in_x = locate(axes[0], x, i, tx);
+
+				if (dim == 1) {
+					const Type r = interpolate(axes[0], i, tx, [&](std::size_t k) { return values[k]; }, dx);
+					if (!in_x)
+						dx = zero;
+					dy = zero;
+					return r;
+				}
+
+				std::size_t j;
+				double ty;
+				const bool in_y = locate(axes[1], y, j, ty);
+				const std::size_t nx = axes[0].knots.size();
+
+				/* rows j - 1, ..., j + 2 interpolated along x, and then along y */
+				std::array<Type, 4> row{}, row_dx{};
+				const std::size_t first = (j == 0) ? 0 : j - 1;
+				const std::size_t last  = std::min(j + 2, axes[1].knots.size() - 1);
+				for (std::size_t r = first; r <= last; ++r) {
+					row[r - first] = interpolate(axes[0], i, tx, [&](std::size_t k) { return values[r * nx + k]; }, row_dx[r - first]);
+				}
+				Type unused;
+				const Type result = interpolate(axes[1], j, ty, [&](std::size_t k) { return row[k - first]; }, dy);
+				dx = interpolate(axes[1], j, ty, [&](std::size_t k) { return row_dx[k - first]; }, unused);
+				if (!in_x)
+					dx = zero;
+				if (!in_y)
+					dy = zero;
+				return result;
+			}
+
+			/** @brief interpolate the table */
+			Type eval(double x, double y = 0.0) const
+			{
+				Type dx, dy;
+				return eval(x, y, dx, dy);
+			}
+		};
+
+		/**
+		 * @brief data tables added by add_data_table()
+		 *
+		 * Each name has one id, which is the value of TokenType::Table. The table replaced by the other table of
+		 * the same name is released, unless a Program keeps it.
+		 */
+		template <MathConcept Type>
+		struct DataTableRegistry
+		{
+			std::mutex                                          mtx;
+			std::vector<std::shared_ptr<const DataTable<Type>>> tables;  /* tables[id] */
+		};
+
+		template <MathConcept Type>
+		DataTableRegistry<Type> DATA_TABLE;
+
+		/** @return `std::shared_ptr<const DataTable<Type>>` data table of the value of TokenType::Table */
+		template <MathConcept Type>
+		std::shared_ptr<const DataTable<Type>> data_table(const Type& id)
+		{
+			const double index = coordinate(id);
+			std::lock_guard<std::mutex> lock(DATA_TABLE<Type>.mtx);
+			if (!(index >= 0.0) || static_cast<std::size_t>(index) >= DATA_TABLE<Type>.tables.size()) {
+				throw std::invalid_argument("Invalid formula: the first argument of tab1 and tab2 must be a data table");
+			}
+			return DATA_TABLE<Type>.tables[static_cast<std::size_t>(index)];
+		}
+
+
+		template <MathConcept Type>
+		std::unordered_map<std::string, Token<Type>>
+		RESERVED_TOKEN =
+		{
+			/* Operator */
+			{ "+", Token<Type>{ "+", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return args[0] + args[1]; } } },
+			{ "-", Token<Type>{ "-", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return args[0] - args[1]; } } },
+			{ "*", Token<Type>{ "*", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return args[0] * args[1]; } } },
+			{ "/", Token<Type>{ "/", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ return args[0] / args[1]; } } },
+			{ "^", Token<Type>{ "/", TokenType::Operator, 2, 0, [](const std::vector<Type>& args){ using std::pow; return pow(args[0], args[1]); } } },
+
+			{ "(", Token<Type>{ "(", TokenType::LParen, 0, 0, nullptr } },
+			{ ")", Token<Type>{ ")", TokenType::RParen, 0, 0, nullptr } },
+			{ ",", Token<Type>{ ",", TokenType::Comma,  0, 0, nullptr } },
+
+			/* Constant */
+			{	"pi",
+				Token<Type>{ "pi", TokenType::Constant, 0, std::numbers::pi_v<ValueType>, nullptr }
+			},
+			{	"inv_pi",
+				Token<Type>{ "inv_pi", TokenType::Constant, 0, std::numbers::inv_pi_v<ValueType>, nullptr }
+			},
+			{	"inv_sqrtpi",
+				Token<Type>{ "inv_sqrtpi", TokenType::Constant, 0, std::numbers::inv_sqrtpi_v<ValueType>, nullptr }
+			},
+			{	"e",
+				Token<Type>{ "e", TokenType::Constant, 0, std::numbers::e_v<ValueType>, nullptr }
+			},
+			{	"sqrt2",
+				Token<Type>{ "sqrt2", TokenType::Constant, 0, std::numbers::sqrt2_v<ValueType>, nullptr }
+			},
+			{	"sqrt3",
+				Token<Type>{ "sqrt3", TokenType::Constant, 0, std::numbers::sqrt3_v<ValueType>, nullptr }
+			},
+			{	"ln2",
+				Token<Type>{ "ln2", TokenType::Constant, 0, std::numbers::ln2_v<ValueType>, nullptr }
+			},
+			{	"ln10",
+				Token<Type>{ "ln10", TokenType::Constant, 0, std::numbers::ln10_v<ValueType>, nullptr }
+			},
+			{	"log2e",
+				Token<Type>{ "log2e", TokenType::Constant, 0, std::numbers::log2e_v<ValueType>, nullptr }
+			},
+			{	"log10e",
+				Token<Type>{ "log10e", TokenType::Constant, 0, std::numbers::log10e_v<ValueType>, nullptr }
+			},
+			{	"egamma",
+				Token<Type>{ "egamma", TokenType::Constant, 0, std::numbers::egamma_v<ValueType>, nullptr }
+			},
+			{	"phi",
+				Token<Type>{ "phi", TokenType::Constant, 0, std::numbers::phi_v<ValueType>, nullptr }
+			},
+
+			/* Func1 */
+			{	"sin",
+				Token<Type>{
+					"sin", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::sin; return sin(args[0]); }
+				}
+			},
+			{	"cos",
+				Token<Type>{
+					"cos", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::cos; return cos(args[0]); }
+				}
+			},
+			{	"tan",
+				Token<Type>{
+					"tan", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::tan; return tan(args[0]); }
+				}
+			},
+			{	"asin",
+				Token<Type>{
+					"asin", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::asin; return asin(args[0]); }
+				}
+			},
+			{	"acos",
+				Token<Type>{
+					"acos", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::acos; return acos(args[0]); }
+				}
+			},
+			{	"atan",
+				Token<Type>{
+					"atan", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::atan; return atan(args[0]); }
+				}
+			},
+			{	"sinh",
+				Token<Type>{
+					"sinh", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::sinh; return sinh(args[0]); }
+				}
+			},
+			{	"cosh",
+				Token<Type>{
+					"cosh", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::cosh; return cosh(args[0]); }
+				}
+			},
+			{	"tanh",
+				Token<Type>{
+					"tanh", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::tanh; return tanh(args[0]); }
+				}
+			},
+			{	"asinh",
+				Token<Type>{
+					"asinh", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::asinh; return asinh(args[0]); }
+				}
+			},
+			{	"acosh",
+				Token<Type>{
+					"acosh", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::acosh; return acosh(args[0]); }
+				}
+			},
+			{	"atanh",
+				Token<Type>{
+					"atanh", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::atanh; return atanh(args[0]); }
+				}
+			},
+			{	"exp",
+				Token<Type>{
+					"exp", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::exp; return exp(args[0]); }
+				}
+			},
+			{	"log",
+				Token<Type>{
+					"log", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::log; return log(args[0]); }
+				}
+			},
+			{	"log10",
+				Token<Type>{
+					"log10", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::log10; return log10(args[0]); }
+				}
+			},
+			{	"ln",
+				Token<Type>{
+					"ln", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::log; return log(args[0]); }
+				}
+			},
+			{	"sqrt",
+				Token<Type>{
+					"sqrt", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args){ using std::sqrt; return sqrt(args[0]); }
+				}
+			},
+
+			/* Func2 */
+			{	"pow",
+				Token<Type>{
+					"pow", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>& args){ using std::pow; return pow(args[0], args[1]); }
+				}
+			},
+
+			/* random numbers: Program draws them from counter based streams, and these are used by ret_func() */
+			{	"randu",
+				Token<Type>{
+					"randu", TokenType::Func0, 0, 0,
+					[](const std::vector<Type>&) { return static_cast<Type>(static_cast<ValueType>(thread_random().uniform())); }
+				}
+			},
+			{	"randn",
+				Token<Type>{
+					"randn", TokenType::Func0, 0, 0,
+					[](const std::vector<Type>&)
+					{
+						const double u1 = thread_random().uniform();
+						const double u2 = thread_random().uniform();
+						return static_cast<Type>(static_cast<ValueType>(std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * std::numbers::pi * u2)));
+					}
+				}
+			},
+			{	"rande",
+				Token<Type>{
+					"rande", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args) { return static_cast<Type>(static_cast<ValueType>(-std::log(thread_random().uniform()))) / args[0]; }
+				}
+			},
+
+			/* data tables: Program binds the table at compilation, and these are used by ret_func() */
+			{	"tab1",
+				Token<Type>{
+					"tab1", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>& args)
+					{
+						const auto table = data_table(args[0]);
+						if (table->dimension() != 1) {
+							throw std::invalid_argument("Invalid formula: tab1 needs a data table of one variable");
+						}
+						return table->eval(coordinate(args[1]));
+					}
+				}
+			},
+			{	"tab2",
+				Token<Type>{
+					"tab2", TokenType::Func3, 3, 0,
+					[](const std::vector<Type>& args)
+					{
+						const auto table = data_table(args[0]);
+						if (table->dimension() != 2) {
+							throw std::invalid_argument("Invalid formula: tab2 needs a data table of two variables");
+						}
+						return table->eval(coordinate(args[1]), coordinate(args[2]));
+					}
+				}
+			},
+
+			/* reductions of array variables: Program compiles them into loops, and a scalar is an array of length 1 */
+			{	"sum",
+				Token<Type>{
+					"sum", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args) { return args[0]; }
+				}
+			},
+			{	"dot",
+				Token<Type>{
+					"dot", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>& args) { return args[0] * args[1]; }
+				}
+			},
+			{	"norm2",
+				Token<Type>{
+					"norm2", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args) -> Type
+					{
+						if constexpr (std::totally_ordered<Type>) {
+							return (args[0] < static_cast<Type>(static_cast<ValueType>(0.0))) ? -args[0] : args[0];
+						} else {
+							throw std::invalid_argument("Invalid formula: norm2 needs real numbers");
+						}
+					}
+				}
+			},
+			{	"max",
+				Token<Type>{
+					"max", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args) -> Type
+					{
+						if constexpr (std::totally_ordered<Type>) {
+							return args[0];
+						} else {
+							throw std::invalid_argument("Invalid formula: max needs real numbers");
+						}
+					}
+				}
+			},
+
+			/* small vectors: they are supported by Program only */
+			{	"vec2",
+				Token<Type>{
+					"vec2", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>&) -> Type { throw std::invalid_argument("Invalid formula: vectors are supported by Program only"); }
+				}
+			},
+			{	"vec3",
+				Token<Type>{
+					"vec3", TokenType::Func3, 3, 0,
+					[](const std::vector<Type>&) -> Type { throw std::invalid_argument("Invalid formula: vectors are supported by Program only"); }
+				}
+			},
+			{	"vec4",
+				Token<Type>{
+					"vec4", TokenType::Func3, 4, 0,
+					[](const std::vector<Type>&) -> Type { throw std::invalid_argument("Invalid formula: vectors are supported by Program only"); }
+				}
+			},
+			{	"cross",
+				Token<Type>{
+					"cross", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>&) -> Type { throw std::invalid_argument("Invalid formula: vectors are supported by Program only"); }
+				}
+			},
+			{	"vx",
+				Token<Type>{
+					"vx", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>&) -> Type { throw std::invalid_argument("Invalid formula: vectors are supported by Program only"); }
+				}
+			},
+			{	"vy",
+				Token<Type>{
+					"vy", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>&) -> Type { throw std::invalid_argument("Invalid formula: vectors are supported by Program only"); }
+				}
+			},
+			{	"vz",
+				Token<Type>{
+					"vz", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>&) -> Type { throw std::invalid_argument("Invalid formula: vectors are supported by Program only"); }
+				}
+			},
+			{	"vw",
+				Token<Type>{
+					"vw", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>&) -> Type { throw std::invalid_argument("Invalid formula: vectors are supported by Program only"); }
+				}
+			},
+			{	"length",
+				Token<Type>{
+					"length", TokenType::Func1, 1, 0,
+					[](const std::vector<Type>& args) -> Type
+					{
+						if constexpr (std::totally_ordered<Type>) {
+							return (args[0] < static_cast<Type>(static_cast<ValueType>(0.0))) ? -args[0] : args[0];
+						} else {
+							throw std::invalid_argument("Invalid formula: length needs real numbers");
+						}
+					}
+				}
+			},
+
+			/* rolling-window functions: they are replaced by stateful functions in StreamEvaluator, and rejected by the others */
+			{	"sma",
+				Token<Type>{
+					"sma", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>&) -> Type { throw std::runtime_error("sma is available only in StreamEvaluator"); }
+				}
+			},
+			{	"ema",
+				Token<Type>{
+					"ema", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>&) -> Type { throw std::runtime_error("ema is available only in StreamEvaluator"); }
+				}
+			},
+			{	"wmin",
+				Token<Type>{
+					"wmin", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>&) -> Type { throw std::runtime_error("wmin is available only in StreamEvaluator"); }
+				}
+			},
+			{	"wmax",
+				Token<Type>{
+					"wmax", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>&) -> Type { throw std::runtime_error("wmax is available only in StreamEvaluator"); }
+				}
+			},
+			{	"wstd",
+				Token<Type>{
+					"wstd", TokenType::Func2, 2, 0,
+					[](const std::vector<Type>&) -> Type { throw std::runtime_error("wstd is available only in StreamEvaluator"); }
+				}
+			},
+		};
+
+		template <MathConcept Type>
+		const Token<Type>* LPAREN_p = &RESERVED_TOKEN<Type>.at("(");
+
+		/** @brief names added by add_custom_function(), which may be replaced */
+		template <MathConcept Type>
+		std::unordered_set<std::string> CUSTOM_FUNCTION;
+
+		/**
+		 * @brief throw if the token is a rolling-window function, which is available only in StreamEvaluator
+		 * @throw `std::invalid_argument` if the token is sma, ema, wmin, wmax or wstd
+		 */
+		template <MathConcept Type>
+		void reject_window_function(const Token<Type>& token)
+		{
+			if (token.type != TokenType::Func2)
+				return;
+			if (token.str == "sma" || token.str == "ema" || token.str == "wmin" || token.str == "wmax" || token.str == "wstd") {
+				throw std::invalid_argument("Invalid formula: " + token.str + " is available only in StreamEvaluator");
+			}
+		}
+
+		/**
+		 * @brief register the data table by the name. the table of the same name is replaced, and keeps its id
+		 * @throw `std::invalid_argument` if the name is used by a function, a constant or an operator
+		 */
+		template <MathConcept Type>
+		void add_data_table(const std::string& name, std::shared_ptr<const DataTable<Type>> table)
+		{
+			std::lock_guard<std::mutex> lock(DATA_TABLE<Type>.mtx);
+			auto pair = RESERVED_TOKEN<Type>.find(name);
+			if (pair == RESERVED_TOKEN<Type>.end()) {
+				const auto id = static_cast<ValueType>(DATA_TABLE<Type>.tables.size());
+				DATA_TABLE<Type>.tables.push_back(std::move(table));
+				RESERVED_TOKEN<Type>.insert({ name, Token<Type>(name, TokenType::Table, 0, id, nullptr) });
+			} else if (pair->second.type == TokenType::Table) {
+				DATA_TABLE<Type>.tables[static_cast<std::size_t>(coordinate(pair->second.value))] = std::move(table);
+			} else {
+				throw std::invalid_argument("add_data_table: " + name + " is already used by a function, a constant or an operator");
+			}
+		}
+
+		inline bool is_real(const std::string& token)
+		{
+			static const std::regex Real(R"(^[+-]?\d+(\.\d*)?([eE][+-]?\d+)?$)");
+			return std::regex_match(token, Real);
+		}
+
+		inline bool is_imaginary(const std::string& token)
+		{
+			static const std::regex Imag(R"(^[+-]?\d*(\.\d*)?([eE][+-]?\d+)?i$)");
+			return std::regex_match(token, Imag);
+		}
+
+		inline bool is_left_assoc(const std::string& Operator)
+		{
+			static const std::unordered_map<std::string, bool>
+			LEFT_ASSOC_LIST =
+			{
+				{ "+",	true },
+				{ "-",	true },
+				{ "*",	true },
+				{ "/",	true },
+				{ "^",	false},
+			};
+
+			return LEFT_ASSOC_LIST.at(Operator);
+		}
+
+		inline int ret_preced(const std::string& Operator)
+		{
+			static const std::unordered_map<std::string, int>
+			PRECED =
+			{
+				{ "+",	0 },
+				{ "-",	0 },
+				{ "*",	1 },
+				{ "/",	1 },
+				{ "^",	2 },
+			};
+
+			return PRECED.at(Operator);
+		}
+
+
+		template <MathConcept Type>
+		Token<Type>::Token(const std::string& str)
+			: str(str), type(TokenType::Variable), arg_num(0), value(0), func(nullptr)
+		{
+			using namespace std::literals::complex_literals;
+
+			auto pair = RESERVED_TOKEN<Type>.find(str);
+			if (pair != RESERVED_TOKEN<Type>.end()) {
+				type    = pair->second.type;
+				arg_num = pair->second.arg_num;
+				value   = pair->second.value;
+				func    = pair->second.func;
+				return;
+			}
+
+			ValueType val;
+			if (is_real(str)) {
+				type = TokenType::Real;
+				auto [ptr, err] = std::from_chars(str.c_str(), str.c_str() + str.length(), val);
+				value = static_cast<Type>(val);
+			} else if (is_imaginary(str)) {
+				if constexpr (std::is_constructible_v<Type, std::complex<ValueType>>) {
+					type = TokenType::Imaginary;
+					auto [ptr, err] = std::from_chars(str.c_str(), str.c_str() + str.length() - 1, val);
+					if (str.length() == 1) {
+						val = 1.0;
+					}
+					value = static_cast<Type>(val * 1.0i);
+				} else {
+					/* real number type: "i" is an usual variable */
+					type = TokenType::Variable;
+				}
+			} else {
+				type = TokenType::Variable;
+			}
+		}
+
+		template <typename Type>
+		using Tokens = std::deque<Token<Type>>;
+
+		template <typename Type>
+		Tokens<Type> devide_to_tokens(const std::string& formula)
+		{
+			Tokens<Type> tokens;
+			std::string_view str;
+
+			auto is_operator = [](const std::string_view& str) -> bool
+			{
+				auto pair = RESERVED_TOKEN<Type>.find(std::string(str));
+				if (pair == RESERVED_TOKEN<Type>.end())
+					return false;
+
+				TokenType type = pair->second.type;
+				return type == TokenType::Operator
+					|| type == TokenType::LParen
+					|| type == TokenType::RParen
+					|| type == TokenType::Comma;
+			};
+
+			std::string label;      /* time-series reference like "x[-1]" */
+			bool in_index = false;
+
+			for (const char& c : formula) {
+				if (in_index) {
+					/* the index is a part of the variable token, and spaces in it are ignored */
+					if (!std::isspace(c))
+						label += c;
+					if (c == ']') {
+						tokens.emplace_back(Token<Type>(label));
+						in_index = false;
+					}
+					continue;
+				}
+
+				if (c == '[' && !str.empty() && !is_operator(str)) {
+					label = std::string(str) + c;
+					in_index = true;
+					str = {};
+					continue;
+				}
+
+				if (std::isspace(c)) {
+					if (!str.empty()) {
+						tokens.push_back(Token<Type>(std::string(str)));
+						str = {};
+					}
+					/* ignore spaces */
+					continue;
+				}
+
+				if (str.empty()) {
+					str = {&c, 1};
+					continue;
+				}
+
+				if (is_operator(std::string_view{str.data(), str.length() + 1})) {
+					str = {str.data(), str.length() + 1};
+					continue;
+				}
+
+				if (is_operator(str) || is_operator(std::string_view{&c, 1})) {
+					tokens.emplace_back(Token<Type>(std::string(str)));
+					str = {&c, 1};
+					continue;
+				}
+
+				str = {str.data(), str.length() + 1};
+			}
+
+			if (!str.empty()) {
+				tokens.emplace_back(Token<Type>(std::string(str)));
+			}
+			if (in_index) {
+				/* unterminated index is left as an unknown variable */
+				tokens.emplace_back(Token<Type>(label));
+			}
+
+			/* a function name not followed by "(" is a variable, so that names like "max" or "vx" can be variables */
+			for (std::size_t k = 0; k < tokens.size(); ++k) {
+				const TokenType type = tokens[k].type;
+				const bool is_func = type == TokenType::Func0 || type == TokenType::Func1 || type == TokenType::Func2 || type == TokenType::Func3;
+				if (is_func && (k + 1 == tokens.size() || tokens[k + 1].type != TokenType::LParen)) {
+					tokens[k].type    = TokenType::Variable;
+					tokens[k].arg_num = 0;
+					tokens[k].value   = 0;
+					tokens[k].func    = nullptr;
+				}
+			}
+
+			return tokens;
+		}
+
+
+		template <MathConcept Type>
+		using RPNs = std::vector<Token<Type>>;
+
+
+		template <MathConcept Type>
+		bool has_LParen(const RPNs<Type>& stack)
+		{
+			return std::ranges::find(stack, *LPAREN_p<Type>) != stack.end();
+		}
+
+		template <MathConcept Type>
+		bool case_of_RParen(RPNs<Type>& rpn, RPNs<Type>& stack)
+		{
+			if (!has_LParen(stack))
+				return false;
+
+			while (true) {
+				Token<Type> poped = stack.back();
+				stack.pop_back();
+
+				if (poped.type == TokenType::LParen)
+					break;
+
+				rpn.emplace_back(poped);
+			}
+
+			if (stack.empty())
+				return true;
+
+			Token<Type> token_before_RParen = stack.back();
+
+			/* judge whether a token befor "(" is function or not by its type:
+			 * operators also have function, like "+" of "a + (b)^2" */
+			const TokenType type = token_before_RParen.type;
+			if (type == TokenType::Func0 || type == TokenType::Func1 || type == TokenType::Func2 || type == TokenType::Func3) {
+				rpn.emplace_back(token_before_RParen);
+				stack.pop_back();
+			}
+
+			return true;
+		}
+
+		template <MathConcept Type>
+		bool case_of_Comma(RPNs<Type>& rpn, RPNs<Type>& stack)
+		{
+			if (!has_LParen(stack))
+				return false;
+
+			while (stack.back() != *LPAREN_p<Type>) {
+				rpn.emplace_back(stack.back());
+				stack.pop_back();
+			}
+
+			return true;
+		}
+
+		template <MathConcept Type>
+		void case_of_Operator(RPNs<Type>& rpn, RPNs<Type>& stack, Token<Type> token,
+		                      bool is_prev_token_operator)
+		{
+			if (is_prev_token_operator) {
+				if (token.str == "+") {
+					/* Delete the plus operator to convert "+x" --> "x".
+					 * So token is not pushed into any stack. */
+					return;
+				}
+
+				if (token.str == "-") {
+					/* Convert "-X" --> "-1 * X", considering the case where X is a function */
+					rpn.emplace_back(Token<Type>("-1"));
+					token = Token<Type>("*"); /* The token becomes "-1 * X" from "-X", and this token is parsed in later process. */
+				}
+			}
+
+			while (!stack.empty()) {
+				Token<Type> poped = stack.back();
+				if (poped.type != TokenType::Operator)
+					break;
+
+				int preced_t = ret_preced(token.str);
+				int preced_p = ret_preced(poped.str);
+
+				if (is_left_assoc(token.str)) {
+					if (preced_t > preced_p) break;
+				} else {
+					if (preced_t >= preced_p) break;
+				}
+
+				rpn.emplace_back(poped);
+				stack.pop_back();
+			}
+
+			stack.emplace_back(token);
+		}
+
+		template <MathConcept Type>
+		const RPNs<Type> BAD_RPNs = RPNs<Type>();
+
+		template <MathConcept Type>
+		RPNs<Type> make_rpn(const std::string& formula)
+		{
+			Tokens<Type> tokens = devide_to_tokens<Type>(formula);
+			RPNs<Type> rpn;
+			RPNs<Type> stack;
+			bool is_prev_token_operator = true;
+			bool retval = true;
+
+			while (!tokens.empty()) {
+				Token<Type> token = tokens.front();
+				tokens.pop_front();
+
+				switch (token.type)
+				{
+				case TokenType::Variable :
+				case TokenType::Constant :
+				case TokenType::Table :
+				case TokenType::Real :
+				case TokenType::Imaginary :
+					is_prev_token_operator = false;
+					rpn.emplace_back(token);
+					break;
+
+				case TokenType::Func0 :
+				case TokenType::Func1 :
+				case TokenType::Func2 :
+				case TokenType::Func3 :
+					is_prev_token_operator = false;
+					stack.emplace_back(token);
+					break;
+
+				case TokenType::LParen :
+					is_prev_token_operator = true;
+					stack.emplace_back(token);
+					break;
+
+				case TokenType::RParen :
+					is_prev_token_operator = false;
+					retval = case_of_RParen<Type>(rpn, stack);
+					break;
+
+				case TokenType::Comma :
+					is_prev_token_operator = false;
+					retval = case_of_Comma<Type>(rpn, stack);
+					break;
+
+				case TokenType::Operator :
+					case_of_Operator<Type>(rpn, stack, token, is_prev_token_operator);
+					is_prev_token_operator = true;
+					break;
+				}
+
+				if (retval != true) {
+					return BAD_RPNs<Type>;
+				}
+			}
+
+			/* Push the remaining operators in thg stacks */
+			while (!stack.empty()) {
+				if (has_LParen<Type>(stack)) {
+					return BAD_RPNs<Type>;
+				}
+				rpn.emplace_back(stack.back());
+				stack.pop_back();
+			}
+
+			return rpn;
+		}
+	}
+
+	template <Details::MathConcept Type>
+	class VariableTable
+	{
+	private:
+		std::unordered_map< std::string, Type > variables;
+		std::unordered_map< std::string, std::vector<Type> > arrays;
+
+		template <typename STR, typename VAL>
+		void insert_variable(const STR& str, const VAL& val)
+		{
+			variables[std::string(str)] = static_cast<Type>(val);
+		}
+
+		template <typename STR, typename VAL, typename... REST>
+		void insert_variable(const STR& str, const VAL& val, const REST&... rest)
+		{
+			variables[std::string(str)] = static_cast<Type>(val);
+			insert_variable(rest...); /* recursive call for the remaining argumets */
+		}
+
+	public:
+		VariableTable() = default;
+		VariableTable(const std::string& str, const Type& val)
+		{
+			variables[str] = val;
+		}
+
+		/**
+		 * @brief Variadic constructor to create a VariableTable object with multiple variable name-value pairs.
+		 *
+		 * This constructor initializes the table with multiple variable name-value pairs provided as arguments.
+		 *
+		 * @tparam `STRING` The type of the std::string input.
+		 * @tparam `TYPE` The type of the value input.
+		 * @tparam `REST` Variadic arguments for additional variable name-value pairs.
+		 * @param str1 The name of the first variable.
+		 * @param val1 The value of the first variable.
+		 * @param rest Subsequent variable name-value pairs.
+		 */
+		template <typename STRING, typename TYPE, typename... REST>
+		VariableTable(const STRING& str1, const TYPE& val1, const REST&... rest)
+		{
+			insert_variable(str1, val1, rest...);
+		}
+
+		~VariableTable() = default;
+
+		bool contains(const std::string& str) const noexcept
+		{
+			return variables.contains(str);
+		}
+
+		Type at(const std::string& str) const
+		{
+			return variables.at(str);
+		}
+
+		void add(const std::string& str, const Type& val)
+		{
+			insert_variable(str, val);
+		}
+
+		/**
+		 * @brief add array variable used by reductions like `sum(v)` and element-wise arithmetic
+		 * @note  array variables are supported by Program only.
+		 */
+		void add_array(const std::string& str, const std::vector<Type>& values)
+		{
+			arrays[str] = values;
+		}
+
+		bool contains_array(const std::string& str) const noexcept
+		{
+			return arrays.contains(str);
+		}
+
+		const std::vector<Type>& array_at(const std::string& str) const
+		{
+			return arrays.at(str);
+		}
+
+		void clear_all(void)
+		{
+			variables.clear();
+			arrays.clear();
+		}
+
+		VariableTable<Type> operator+=(const std::pair<std::string, Type>& pair)
+		{
+			insert_variable(pair.first, pair.second);
+			return *this;
+		}
+
+		Type& operator[](const std::string& str)
+		{
+			return variables[str];
+		}
+
+		/** @return `auto` return iterator of the first variable in this table */
+		auto begin(void) const
+		{
+			return variables.begin();
+		}
+
+		/** @return `auto` return iterator of the end variable in this table */
+		auto end(void) const
+		{
+			return variables.end();
+		}
+	};
+
+
+	namespace Details
+	{
+		template <MathConcept Type>
+		using Stack = std::deque<Type>;
+
+		template <MathConcept Type>
+		using CompiledFunc = std::function<void(Stack<Type>&, const VariableTable<Type>&)>;
+
+		template <MathConcept Type>
+		using CompiledRPN = std::vector<CompiledFunc<Type>>;
+
+		using VariableList = std::unordered_set<std::string>;
+
+		/**
+		 * @brief parse rpn and make function object list
+		 *
+		 * @tparam `Type` MathConcept type
+		 * @param[in] rpn
+		 * @param[out] var_list this is inserted variable strings used in rpn. use it to check variable table.
+		 * @return `CompiledRPN<Type>`
+		 * @throw `std::invalid_argument` if the number of function argument is invalid
+		 */
+		template <MathConcept Type>
+		CompiledRPN<Type> compile_RPN(const RPNs<Type>& rpn, VariableList& var_list)
+		{
+			int var_cnt = 0; /* for format check */
+			CompiledRPN<Type> crpn;
+			var_list.clear();
+
+			for (const Details::Token<Type>& token : rpn) {
+				switch (token.type)
+				{
+				case TokenType::Variable :
+					var_list.insert(token.str);
+					crpn.emplace_back([token](Stack<Type>& stack, const VariableTable<Type>& table)
+					{
+						stack.emplace_back(table.at(token.str));
+					});
+					break;
+				case TokenType::Constant :
+				case TokenType::Real :
+				case TokenType::Imaginary :
+				case TokenType::Table :       /* the value is the index of the data table */
+					crpn.emplace_back([token](Stack<Type>& stack, const VariableTable<Type>& table)
+					{
+						stack.emplace_back(token.value);
+					});
+					break;
+				case TokenType::Operator :
+				case TokenType::Func0 :
+				case TokenType::Func1 :
+				case TokenType::Func2 :
+				case TokenType::Func3 :
+					var_cnt -= token.arg_num;
+					if (var_cnt < 0) {
+						throw std::invalid_argument("Invalid formula: missing number of argument for " + token.str);
+					}
+					crpn.emplace_back([token](Stack<Type>& stack, const VariableTable<Type>& table)
+					{
+						std::vector<Type> args(token.arg_num);
+						for (int n = token.arg_num - 1; n >= 0; --n) {
+							args[n] = stack.back();
+							stack.pop_back();
+						}
+						stack.emplace_back(token.func(args));
+					});
+					break;
+				}
+				var_cnt++;
+			}
+
+			if (var_cnt != 1) {
+				throw std::invalid_argument("Invalid formula: some functions have too many arguments");
+			}
+
+			return crpn; /* return value equal to BAD_CRPN if rpn is BAD_RPNs */
+		}
+	}
+
+
+	namespace Details
+	{
+		/** @brief identifier of the random numbers drawn in one evaluation */
+		struct RandomKey
+		{
+			std::uint64_t seed   = 0;
+			std::uint64_t stream = 0;  /* element of the evaluation */
+		};
+
+		/** @return `std::array<std::uint32_t, 4>` random bits of the draw-th random instruction */
+		inline std::array<std::uint32_t, 4> random_bits(const RandomKey& key, int draw)
+		{
+			return philox(
+				{ static_cast<std::uint32_t>(key.stream), static_cast<std::uint32_t>(key.stream >> 32),
+				  static_cast<std::uint32_t>(draw), 0x52414E44 },
+				{ static_cast<std::uint32_t>(key.seed),   static_cast<std::uint32_t>(key.seed >> 32) });
+		}
+
+		/** @return `double` uniform random number in (0, 1) */
+		inline double random_uniform(const RandomKey& key, int draw)
+		{
+			const std::array<std::uint32_t, 4> bits = random_bits(key, draw);
+			return to_uniform(bits[0], bits[1]);
+		}
+
+		/** @return `double` standard normal random number by Box-Muller transform */
+		inline double random_normal(const RandomKey& key, int draw)
+		{
+			const std::array<std::uint32_t, 4> bits = random_bits(key, draw);
+			const double u1 = to_uniform(bits[0], bits[1]);
+			const double u2 = to_uniform(bits[2], bits[3]);
+			return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * std::numbers::pi * u2);
+		}
+
+		/** @brief operation of compiled instruction */
+		enum class OpCode
+		{
+			Load,   /* free variable given at each evaluation */
+			Param,  /* variable registered in VariableTable */
+			Const,  /* pi, 3.14, 2i, etc. */
+			Add,
+			Sub,
+			Mul,
+			Div,
+			Pow,
+			PowInt, /* power with constant integer exponent like z^2 */
+			Sin,
+			Cos,
+			Tan,
+			Asin,
+			Acos,
+			Atan,
+			Sinh,
+			Cosh,
+			Tanh,
+			Asinh,
+			Acosh,
+			Atanh,
+			Exp,
+			Log,
+			Log10,
+			Sqrt,
+			RandU,  /* uniform random number in (0, 1) */
+			RandN,  /* standard normal random number */
+			RandE,  /* exponential random number of the rate */
+			Tab1,   /* data table of one variable */
+			Tab2,   /* data table of two variables */
+			AMap,   /* element-wise operation of arrays */
+			Sum,    /* reductions of an array */
+			Dot,
+			Norm2,
+			Max,
+			Vec,    /* vector of the scalar arguments */
+			Comp,   /* component of a vector */
+			Cross,  /* cross product of vectors of length 3 */
+			Call,   /* custom function added by add_custom_function() */
+		};
+
+		/** @return `bool` true if the operation draws a random number */
+		inline bool is_random(OpCode code)
+		{
+			return code == OpCode::RandU || code == OpCode::RandN || code == OpCode::RandE;
+		}
+
+		/** @return `bool` true if the operation reads or writes arrays */
+		inline bool is_array(OpCode code)
+		{
+			return code == OpCode::AMap || code == OpCode::Sum || code == OpCode::Dot
+			    || code == OpCode::Norm2 || code == OpCode::Max
+			    || code == OpCode::Vec || code == OpCode::Comp || code == OpCode::Cross;
+		}
+
+		/** @return `bool` true if the array operation returns a scalar */
+		inline bool is_reduction(OpCode code)
+		{
+			return code == OpCode::Sum || code == OpCode::Dot || code == OpCode::Norm2 || code == OpCode::Max
+			    || code == OpCode::Comp;
+		}
+
+		/** @return `bool` true if the operation interpolates a data table */
+		inline bool is_table(OpCode code)
+		{
+			return code == OpCode::Tab1 || code == OpCode::Tab2;
+		}
+
+		/** @return `OpCode` operation of the reserved function, or `OpCode::Call` for custom function */
+		inline OpCode ret_opcode(const std::string& str)
+		{
+			static const std::unordered_map<std::string, OpCode>
+			OPCODE =
+			{
+				{ "+",     OpCode::Add },
+				{ "-",     OpCode::Sub },
+				{ "*",     OpCode::Mul },
+				{ "/",     OpCode::Div },
+				{ "^",     OpCode::Pow },
+				{ "pow",   OpCode::Pow },
+				{ "sin",   OpCode::Sin },
+				{ "cos",   OpCode::Cos },
+				{ "tan",   OpCode::Tan },
+				{ "asin",  OpCode::Asin },
+				{ "acos",  OpCode::Acos },
+				{ "atan",  OpCode::Atan },
+				{ "sinh",  OpCode::Sinh },
+				{ "cosh",  OpCode::Cosh },
+				{ "tanh",  OpCode::Tanh },
+				{ "asinh", OpCode::Asinh },
+				{ "acosh", OpCode::Acosh },
+				{ "atanh", OpCode::Atanh },
+				{ "exp",   OpCode::Exp },
+				{ "log",   OpCode::Log },
+				{ "ln",    OpCode::Log },
+				{ "log10", OpCode::Log10 },
+				{ "sqrt",  OpCode::Sqrt },
+				{ "randu", OpCode::RandU },
+				{ "randn", OpCode::RandN },
+				{ "rande", OpCode::RandE },
+				{ "tab1",  OpCode::Tab1 },
+				{ "tab2",  OpCode::Tab2 },
+				{ "sum",   OpCode::Sum },
+				{ "dot",   OpCode::Dot },
+				{ "norm2", OpCode::Norm2 },
+				{ "max",   OpCode::Max },
+				{ "length", OpCode::Norm2 },
+				{ "vec2",  OpCode::Vec },
+				{ "vec3",  OpCode::Vec },
+				{ "vec4",  OpCode::Vec },
+				{ "vx",    OpCode::Comp },
+				{ "vy",    OpCode::Comp },
+				{ "vz",    OpCode::Comp },
+				{ "vw",    OpCode::Comp },
+				{ "cross", OpCode::Cross },
+			};
+
+			auto pair = OPCODE.find(str);
+			return (pair != OPCODE.end()) ? pair->second : OpCode::Call;
+		}
+
+		/** @brief the largest exponent converted to OpCode::PowInt */
+		constexpr int POW_INT_MAX = 64;
+
+		/** @return `Type` a^n calculated by repeated squaring */
+		template <MathConcept Type>
+		Type pow_int(const Type& a, int n)
+		{
+			if (n < 0)
+				return static_cast<Type>(static_cast<ValueType>(1.0)) / pow_int(a, -n);
+
+			Type result = static_cast<Type>(static_cast<ValueType>(1.0));
+			Type base   = a;
+			while (n != 0) {
+				if (n & 1)
+					result = result * base;
+				n >>= 1;
+				if (n != 0)
+					base = base * base;
+			}
+			return result;
+		}
+
+		/**
+		 * @brief check whether the value is an integer usable as exponent of OpCode::PowInt
+		 * @param[out] n integer value
+		 */
+		template <MathConcept Type>
+		bool is_int_exponent(const Type& value, int& n)
+		{
+			ValueType re, im = 0;
+			if constexpr (requires { static_cast<ValueType>(value.real()); static_cast<ValueType>(value.imag()); }) {
+				re = static_cast<ValueType>(value.real());
+				im = static_cast<ValueType>(value.imag());
+			} else if constexpr (requires { static_cast<ValueType>(value); }) {
+				re = static_cast<ValueType>(value);
+			} else {
+				return false;
+			}
+
+			if (im != 0 || re != static_cast<ValueType>(static_cast<int>(re)) || std::abs(re) > POW_INT_MAX)
+				return false;
+
+			n = static_cast<int>(re);
+			return true;
+		}
+
+		/** @brief evaluate arithmetic operation `Code` (OpCode::Add ... OpCode::Sqrt) */
+		template <OpCode Code, MathConcept Type>
+		inline Type operate(const Type& a, const Type& b, int index)
+		{
+			using std::pow, std::sin, std::cos, std::tan, std::asin, std::acos, std::atan, std::sinh, std::cosh, std::tanh;
+			using std::asinh, std::acosh, std::atanh, std::exp, std::log, std::log10, std::sqrt;
+
+			if constexpr (Code == OpCode::Add)         return a + b;
+			else if constexpr (Code == OpCode::Sub)    return a - b;
+			else if constexpr (Code == OpCode::Mul)    return a * b;
+			else if constexpr (Code == OpCode::Div)    return a / b;
+			else if constexpr (Code == OpCode::Pow)    return pow(a, b);
+			else if constexpr (Code == OpCode::PowInt) return pow_int(a, index);
+			else if constexpr (Code == OpCode::Sin)    return sin(a);
+			else if constexpr (Code == OpCode::Cos)    return cos(a);
+			else if constexpr (Code == OpCode::Tan)    return tan(a);
+			else if constexpr (Code == OpCode::Asin)   return asin(a);
+			else if constexpr (Code == OpCode::Acos)   return acos(a);
+			else if constexpr (Code == OpCode::Atan)   return atan(a);
+			else if constexpr (Code == OpCode::Sinh)   return sinh(a);
+			else if constexpr (Code == OpCode::Cosh)   return cosh(a);
+			else if constexpr (Code == OpCode::Tanh)   return tanh(a);
+			else if constexpr (Code == OpCode::Asinh)  return asinh(a);
+			else if constexpr (Code == OpCode::Acosh)  return acosh(a);
+			else if constexpr (Code == OpCode::Atanh)  return atanh(a);
+			else if constexpr (Code == OpCode::Exp)    return exp(a);
+			else if constexpr (Code == OpCode::Log)    return log(a);
+			else if constexpr (Code == OpCode::Log10)  return log10(a);
+			else if constexpr (Code == OpCode::Sqrt)   return sqrt(a);
+			else static_assert(Code == OpCode::Add, "operate() is called with non arithmetic OpCode");
+		}
+
+		/**
+		 * @brief call `visitor(std::integral_constant<OpCode, code>{})` for arithmetic operation
+		 * @note  this makes the switch of OpCode outside of the loops in the visitor.
+		 * @throw `std::invalid_argument` if code is not arithmetic operation
+		 */
+		template <typename Visitor>
+		decltype(auto) dispatch(OpCode code, Visitor&& visitor)
+		{
+			switch (code)
+			{
+			case OpCode::Add :    return visitor(std::integral_constant<OpCode, OpCode::Add>{});
+			case OpCode::Sub :    return visitor(std::integral_constant<OpCode, OpCode::Sub>{});
+			case OpCode::Mul :    return visitor(std::integral_constant<OpCode, OpCode::Mul>{});
+			case OpCode::Div :    return visitor(std::integral_constant<OpCode, OpCode::Div>{});
+			case OpCode::Pow :    return visitor(std::integral_constant<OpCode, OpCode::Pow>{});
+			case OpCode::PowInt : return visitor(std::integral_constant<OpCode, OpCode::PowInt>{});
+			case OpCode::Sin :    return visitor(std::integral_constant<OpCode, OpCode::Sin>{});
+			case OpCode::Cos :    return visitor(std::integral_constant<OpCode, OpCode::Cos>{});
+			case OpCode::Tan :    return visitor(std::integral_constant<OpCode, OpCode::Tan>{});
+			case OpCode::Asin :   return visitor(std::integral_constant<OpCode, OpCode::Asin>{});
+			case OpCode::Acos :   return visitor(std::integral_constant<OpCode, OpCode::Acos>{});
+			case OpCode::Atan :   return visitor(std::integral_constant<OpCode, OpCode::Atan>{});
+			case OpCode::Sinh :   return visitor(std::integral_constant<OpCode, OpCode::Sinh>{});
+			case OpCode::Cosh :   return visitor(std::integral_constant<OpCode, OpCode::Cosh>{});
+			case OpCode::Tanh :   return visitor(std::integral_constant<OpCode, OpCode::Tanh>{});
+			case OpCode::Asinh :  return visitor(std::integral_constant<OpCode, OpCode::Asinh>{});
+			case OpCode::Acosh :  return visitor(std::integral_constant<OpCode, OpCode::Acosh>{});
+			case OpCode::Atanh :  return visitor(std::integral_constant<OpCode, OpCode::Atanh>{});
+			case OpCode::Exp :    return visitor(std::integral_constant<OpCode, OpCode::Exp>{});
+			case OpCode::Log :    return visitor(std::integral_constant<OpCode, OpCode::Log>{});
+			case OpCode::Log10 :  return visitor(std::integral_constant<OpCode, OpCode::Log10>{});
+			case OpCode::Sqrt :   return visitor(std::integral_constant<OpCode, OpCode::Sqrt>{});
+			default :
+				throw std::invalid_argument("dispatch(): OpCode is not arithmetic operation");
+			}
+		}
+
+		/** @return `Type` result of arithmetic operation */
+		template <MathConcept Type>
+		Type apply(OpCode code, const Type& a, const Type& b, int index)
+		{
+			return dispatch(code, [&](auto Code) -> Type { return operate<Code(), Type>(a, b, index); });
+		}
+
+		/**
+		 * @brief derivative of arithmetic operation `Code` by forward mode automatic differentiation
+		 *
+		 * @param a, b   operands
+		 * @param r      result of the operation
+		 * @param da, db derivatives of operands
+		 * @return `Type` derivative of the result
+		 */
+		template <OpCode Code, MathConcept Type>
+		inline Type differentiate(const Type& a, const Type& b, const Type& r, const Type& da, const Type& db, int index)
+		{
+			using std::pow, std::log, std::sin, std::cos, std::sinh, std::cosh, std::sqrt;
+
+			const Type zero = static_cast<Type>(static_cast<ValueType>(0.0));
+			const Type one  = static_cast<Type>(static_cast<ValueType>(1.0));
+
+			if constexpr (Code == OpCode::Add)         return da + db;
+			else if constexpr (Code == OpCode::Sub)    return da - db;
+			else if constexpr (Code == OpCode::Mul)    return da * b + a * db;
+			else if constexpr (Code == OpCode::Div)    return (da - r * db) / b;
+			else if constexpr (Code == OpCode::Pow) {
+				/* the terms are skipped if the derivatives are zero, because a^(b-1) or log(a) may be invalid */
+				Type result = zero;
+				if (da != zero)
+					result = result + b * pow(a, b - one) * da;
+				if (db != zero)
+					result = result + r * log(a) * db;
+				return result;
+			}
+			else if constexpr (Code == OpCode::PowInt) {
+				/* a^0 is constant, and 0 * a^-1 would be NaN at a = 0 */
+				if (index == 0)
+					return zero;
+				return static_cast<Type>(static_cast<ValueType>(index)) * pow_int(a, index - 1) * da;
+			}
+			else if constexpr (Code == OpCode::Sin)    return cos(a) * da;
+			else if constexpr (Code == OpCode::Cos)    return zero - sin(a) * da;
+			else if constexpr (Code == OpCode::Tan)    return (one + r * r) * da;
+			else if constexpr (Code == OpCode::Asin)   return da / sqrt(one - a * a);
+			else if constexpr (Code == OpCode::Acos)   return zero - da / sqrt(one - a * a);
+			else if constexpr (Code == OpCode::Atan)   return da / (one + a * a);
+			else if constexpr (Code == OpCode::Sinh)   return cosh(a) * da;
+			else if constexpr (Code == OpCode::Cosh)   return sinh(a) * da;
+			else if constexpr (Code == OpCode::Tanh)   return (one - r * r) * da;
+			else if constexpr (Code == OpCode::Asinh)  return da / sqrt(a * a + one);
+			else if constexpr (Code == OpCode::Acosh)  return da / (sqrt(a - one) * sqrt(a + one));
+			else if constexpr (Code == OpCode::Atanh)  return da / (one - a * a);
+			else if constexpr (Code == OpCode::Exp)    return r * da;
+			else if constexpr (Code == OpCode::Log)    return da / a;
+			else if constexpr (Code == OpCode::Log10)  return da / (a * static_cast<Type>(std::numbers::ln10_v<ValueType>));
+			else if constexpr (Code == OpCode::Sqrt)   return da / (r + r);
+			else static_assert(Code == OpCode::Add, "differentiate() is called with non arithmetic OpCode");
+		}
+
+		/** @return `ValueType` rough magnitude of the value used for the step of numerical differentiation */
+		template <MathConcept Type>
+		ValueType magnitude(const Type& value)
+		{
+			using std::abs;
+			if constexpr (requires { static_cast<ValueType>(abs(value)); })
+				return static_cast<ValueType>(abs(value));
+			else
+				return static_cast<ValueType>(1.0);
+		}
+
+		/**
+		 * @brief derivative of custom function by central difference
+		 * @note  custom function is given as a function pointer, so its derivative is not known symbolically.
+		 */
+		template <MathConcept Type>
+		Type call_tangent(Func<Type> func, int arg_num, const Type* values, const Type* tangents, std::vector<Type>& args)
+		{
+			const Type zero = static_cast<Type>(static_cast<ValueType>(0.0));
+			Type result = zero;
+
+			for (int j = 0; j < arg_num; ++j) {
+				if (tangents[j] == zero)
+					continue;
+
+				const ValueType h = static_cast<ValueType>(6.0e-6) * (static_cast<ValueType>(1.0) + magnitude(values[j]));
+				args.assign(values, values + arg_num);
+				args[j] = values[j] + static_cast<Type>(h);
+				const Type f1 = func(args);
+				args[j] = values[j] - static_cast<Type>(h);
+				const Type f2 = func(args);
+				result = result + (f1 - f2) / static_cast<Type>(h + h) * tangents[j];
+			}
+			return result;
+		}
+
+		/** @brief kind of the operands of array instructions */
+		enum class Operand
+		{
+			Scalar,  /* scalar register, broadcast to every element */
+			Array,   /* array register */
+			Param,   /* array variable of Program. src is the index of the array */
+		};
+
+		/**
+		 * @brief compiled instruction.
+		 * @note  operands of arithmetic operation are `src[0]` (and `src[1]`),
+		 *        and arguments of OpCode::Call are registers `src[0]`, `src[0] + 1`, ..., `src[0] + arg_num - 1`.
+		 *        OpCode::Tab1 and OpCode::Tab2 have the coordinates as operands, and the table is bound to `table`.
+		 *        operands of array instructions are scalar registers, array registers or arrays of Program (see `kind`),
+		 *        and arguments of OpCode::Vec are the scalar registers like OpCode::Call.
+		 */
+		template <MathConcept Type>
+		struct Instruction
+		{
+			OpCode             code;
+			int                dst;     /* destination register */
+			std::array<int, 3> src;     /* operand registers */
+			int                arg_num;
+			int                index;   /* slot index of Load and Param, exponent of PowInt, draw index of random, id of table, component of Comp */
+			Type               value;   /* value of Const */
+			Func<Type>         func;    /* function of Call */
+			const DataTable<Type>* table = nullptr;  /* data table of Tab1 and Tab2 */
+			OpCode             op     = OpCode::Const;  /* element operation of AMap */
+			std::array<Operand, 2> kind = {};           /* operands of array instructions */
+			int                length = 0;              /* length of the arrays of array instructions */
+		};
+
+		/** @return `Type` value of the data table at the coordinates. `dx` and `dy` are its derivatives */
+		template <MathConcept Type>
+		inline Type lookup(const Instruction<Type>& inst, const Type& x, const Type& y, Type& dx, Type& dy)
+		{
+			return inst.table->eval(coordinate(x), (inst.code == OpCode::Tab2) ? coordinate(y) : 0.0, dx, dy);
+		}
+
+		/** @return `Type` sum of `term(0)`, ..., `term(n - 1)` by four partial sums, which the compiler can vectorize */
+		template <MathConcept Type, typename Term>
+		inline Type reduce_sum(std::size_t n, Term&& term)
+		{
+			const Type zero = static_cast<Type>(static_cast<ValueType>(0.0));
+			Type s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				s0 += term(i);
+				s1 += term(i + 1);
+				s2 += term(i + 2);
+				s3 += term(i + 3);
+			}
+			for (; i < n; ++i) {
+				s0 += term(i);
+			}
+			return (s0 + s1) + (s2 + s3);
+		}
+
+		/** @return `std::array<Type, 3>` cross product of (ax, ay, az) and (bx, by, bz) */
+		template <MathConcept Type>
+		inline std::array<Type, 3> cross(const Type& ax, const Type& ay, const Type& az, const Type& bx, const Type& by, const Type& bz)
+		{
+			return { ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx };
+		}
+
+		/** @return `Type` random number drawn by the instruction. `a` is the rate of RandE */
+		template <MathConcept Type>
+		inline Type draw(const Instruction<Type>& inst, const Type& a, const RandomKey& key)
+		{
+			switch (inst.code)
+			{
+			case OpCode::RandU :
+				return static_cast<Type>(static_cast<ValueType>(random_uniform(key, inst.index)));
+			case OpCode::RandN :
+				return static_cast<Type>(static_cast<ValueType>(random_normal(key, inst.index)));
+			default :
+				return static_cast<Type>(static_cast<ValueType>(-std::log(random_uniform(key, inst.index)))) / a;
+			}
+		}
+
+		/** @brief execute one instruction with scalar registers */
+		template <MathConcept Type>
+		inline void execute(const Instruction<Type>& inst, Type* reg, const Type* vars, const Type* params, std::vector<Type>& args,
+		                    const RandomKey& key = RandomKey())
+		{
+			switch (inst.code)
+			{
+			case OpCode::RandU :
+			case OpCode::RandN :
+			case OpCode::RandE :
+				reg[inst.dst] = draw(inst, reg[inst.src[0] < 0 ? inst.dst : inst.src[0]], key);
+				break;
+			case OpCode::Load :
+				reg[inst.dst] = vars[inst.index];
+				break;
+			case OpCode::Param :
+				reg[inst.dst] = params[inst.index];
+				break;
+			case OpCode::Const :
+				reg[inst.dst] = inst.value;
+				break;
+			case OpCode::Call :
+				args.resize(inst.arg_num); /* never allocates if capacity is reserved */
+				for (int n = 0; n < inst.arg_num; ++n) {
+					args[n] = reg[inst.src[0] + n];
+				}
+				reg[inst.dst] = inst.func(args);
+				break;
+			case OpCode::Tab1 :
+			case OpCode::Tab2 :
+			{
+				Type dx, dy;
+				reg[inst.dst] = lookup(inst, reg[inst.src[0]], reg[inst.src[inst.arg_num - 1]], dx, dy);
+				break;
+			}
+			default :
+				reg[inst.dst] = apply(inst.code, reg[inst.src[0]], (inst.arg_num > 1) ? reg[inst.src[1]] : reg[inst.src[0]], inst.index);
+				break;
+			}
+		}
+
+		/** @return `std::size_t` the number of threads. `0` means the number of hardware threads. */
+		inline std::size_t ret_thread_num(std::size_t threads)
+		{
+			if (threads != 0)
+				return threads;
+
+			unsigned int hw = std::thread::hardware_concurrency();
+			return (hw != 0) ? hw : 1;
+		}
+
+		/**
+		 * @brief call `fn(begin, end, worker)` for every chunk [begin, end) of [0, n) with worker threads
+		 *
+		 * @param n       the number of elements
+		 * @param grain   the number of elements in one chunk
+		 * @param threads the number of threads. `0` means the number of hardware threads.
+		 * @param fn      `void(std::size_t begin, std::size_t end, std::size_t worker)`. `worker` is in [0, threads).
+		 * @note  chunks are handed out dynamically, so `worker` is not related to the position of the chunk.
+		 * @throw rethrow the first exception thrown by `fn`
+		 */
+		template <typename Fn>
+		void parallel_for(std::size_t n, std::size_t grain, std::size_t threads, Fn&& fn)
+		{
+			if (n == 0)
+				return;
+
+			grain   = std::max<std::size_t>(grain, 1);
+			threads = std::min(ret_thread_num(threads), (n + grain - 1) / grain);
+
+			std::atomic<std::size_t> next = 0;
+			std::exception_ptr       error;
+			std::mutex               mtx;
+
+			auto worker = [&](std::size_t id)
+			{
+				try {
+					while (true) {
+						std::size_t begin = next.fetch_add(grain);
+						if (begin >= n)
+							break;
+						fn(begin, std::min(begin + grain, n), id);
+					}
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(mtx);
+					if (!error)
+						error = std::current_exception();
+					next = n; /* stop the other workers */
+				}
+			};
+
+			std::vector<std::thread> pool;
+			for (std::size_t id = 1; id < threads; ++id) {
+				pool.emplace_back(worker, id);
+			}
+			worker(0);
+			for (std::thread& th : pool) {
+				th.join();
+			}
+
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		/**
+		 * @brief orbit period detection by Brent's algorithm
+		 *
+		 * The orbit is compared with the value saved at the last power of two iteration,
+		 * so that the cycle is found within about twice its period after the orbit is caught in it.
+		 */
+		template <MathConcept Type>
+		class PeriodDetector
+		{
+		private:
+			Type        saved;
+			std::size_t power = 1;
+			std::size_t lam   = 0;
+			double      tol2;
+			double      rel2;
+
+		public:
+			/**
+			 * @param tolerance the orbit is periodic if |z_n - z_m| < tolerance
+			 * @param relative  floor of the tolerance relative to |z_n|, e.g. the resolution of the type of z
+			 */
+			PeriodDetector(const Type& z0, double tolerance, double relative = 0.0)
+				: saved(z0), tol2(tolerance * tolerance), rel2(relative * relative) {}
+
+			/** @return `std::size_t` the detected period, or `0` if the cycle is not found yet */
+			std::size_t check(const Type& z)
+			{
+				++lam;
+				using std::norm;
+				const double nz = static_cast<double>(norm(z));
+				if (static_cast<double>(norm(z - saved)) < std::max(tol2, rel2 * nz))
+					return lam;
+
+				if (lam == power) {
+					saved = z;
+					power *= 2;
+					lam = 0;
+				}
+				return 0;
+			}
+		};
+	}
+
+
+	/**
+	 * @brief register based program compiled from a formula
+	 *
+	 * Variables given at each evaluation ("free variables") are passed as an array in the order of
+	 * the constructor argument, and the other variables are read from the VariableTable ("parameters").
+	 * Evaluation with a Workspace never allocates memory, and batch evaluation processes
+	 * `BLOCK` elements at once for each instruction so that the inner loops are vectorized.
+	 */
+	template <Details::MathConcept Type>
+	class Program
+	{
+	public:
+		/** @brief the number of elements processed at once in batch evaluation */
+		static constexpr std::size_t BLOCK = 64;
+
+		/** @brief the longest array evaluated by blocks in batch evaluation, like vec4 */
+		static constexpr std::size_t VECTOR_MAX = 4;
+
+		/** @brief buffers used in evaluation. Prepare one for each thread. */
+		struct Workspace
+		{
+			std::vector<Type> reg;
+			std::vector<Type> args;
+			std::vector<Type> block;
+			std::vector<Type> tangent;  /* derivatives of registers */
+			std::vector<Type> tblock;   /* derivatives of registers in batch evaluation */
+			std::vector<Type> targs;
+			std::vector<Type> array;    /* array registers */
+			std::vector<Type> tarray;   /* derivatives of array registers */
+			std::vector<Type> ablock;   /* array registers in batch evaluation: component c of register r is the column r * length + c */
+			std::vector<Type> vars;     /* free variables of one element in batch evaluation of array instructions */
+			std::uint64_t     stream = 0;  /* random stream of the next element. advanced by each evaluation */
+		};
+
+	private:
+		std::vector<Details::Instruction<Type>> code;
+		std::vector<std::string> names;  /* free variables, and then parameters */
+		std::vector<Type> params;
+		std::size_t free_num = 0;
+		std::size_t reg_num  = 1;
+		int max_arg = 0;
+		int random_num = 0;       /* the number of random instructions */
+		std::uint64_t seed = 0;   /* seed of random numbers */
+		std::vector<std::shared_ptr<const Details::DataTable<Type>>> tables;  /* keeps the bound tables alive */
+		std::vector<std::vector<Type>> arrays;  /* array variables */
+		std::vector<std::string> array_names;
+		std::size_t array_len = 0;  /* the longest array, which is the size of each array register */
+		int array_num = 0;          /* the number of array instructions */
+
+		/** @brief register at compilation which may hold an array */
+		struct ArraySlot
+		{
+			Details::Operand kind = Details::Operand::Scalar;
+			int              src  = 0;  /* index of the array variable, or the register */
+			int              length = 0;
+		};
+
+		int find_name(const std::string& str) const noexcept
+		{
+			auto it = std::ranges::find(names, str);
+			return (it != names.end()) ? static_cast<int>(it - names.begin()) : -1;
+		}
+
+		/** @brief replace the last instructions by Const if all operands are constant */
+		void fold_constant(void)
+		{
+			Details::Instruction<Type>& inst = code.back();
+			if (inst.code == Details::OpCode::Call || Details::is_random(inst.code) || Details::is_table(inst.code)
+			    || Details::is_array(inst.code))
+				return;
+
+			std::size_t n = static_cast<std::size_t>(inst.arg_num);
+			if (code.size() < n + 1)
+				return;
+			for (std::size_t k = 2; k <= n + 1; ++k) {
+				if (code[code.size() - k].code != Details::OpCode::Const)
+					return;
+			}
+
+			Type a = code[code.size() - n - 1].value;
+			Type b = (n > 1) ? code[code.size() - n].value : a;
+			Type value = Details::apply(inst.code, a, b, inst.index);
+			int dst = inst.dst;
+
+			code.resize(code.size() - n - 1);
+			code.push_back({ Details::OpCode::Const, dst, { -1, -1, -1 }, 0, 0, value, nullptr });
+		}
+
+		/** @brief compile the operation of which some operands are arrays, or the reduction of an array */
+		void compile_array(Details::OpCode op, const Details::Token<Type>& token, int depth, std::vector<ArraySlot>& slots)
+		{
+			using Details::OpCode;
+			using Details::Operand;
+
+			const bool reduction = Details::is_reduction(op);
+			if (!Details::is_array(op) && (op == OpCode::Call || Details::is_random(op) || Details::is_table(op))) {
+				throw std::invalid_argument("Invalid formula: arrays can be used only in arithmetic and reductions, not in " + token.str);
+			}
+
+			if (op == OpCode::Vec) {
+				for (int k = 0; k < token.arg_num; ++k) {
+					if (slots[depth + k].kind != Operand::Scalar) {
+						throw std::invalid_argument("Invalid formula: arguments of " + token.str + " must be scalars");
+					}
+				}
+				code.push_back({ op, depth, { depth, -1, -1 }, token.arg_num, 0, 0, nullptr, nullptr, op, {}, token.arg_num });
+				array_len = std::max(array_len, static_cast<std::size_t>(token.arg_num));
+				slots[depth] = { Operand::Array, depth, token.arg_num };
+				array_num++;
+				return;
+			}
+			if constexpr (!std::totally_ordered<Type>) {
+				if (op == OpCode::Norm2 || op == OpCode::Max) {
+					throw std::invalid_argument("Invalid formula: " + token.str + " needs real numbers");
+				}
+			}
+
+			Details::Instruction<Type> inst{ op, depth, { -1, -1, -1 }, token.arg_num, 0, 0, nullptr };
+			int exponent = 0;
+			if (op == OpCode::Pow && slots[depth + 1].kind == Operand::Scalar && code.back().code == OpCode::Const
+			    && Details::is_int_exponent(code.back().value, exponent)) {
+				code.pop_back(); /* the exponent is not needed as register */
+				inst.op      = OpCode::PowInt;
+				inst.arg_num = 1;
+				inst.index   = exponent;
+			}
+
+			for (int k = 0; k < inst.arg_num; ++k) {
+				const ArraySlot& slot = slots[depth + k];
+				inst.kind[k] = slot.kind;
+				inst.src[k]  = (slot.kind == Operand::Param) ? slot.src : depth + k;
+				if (slot.kind == Operand::Scalar)
+					continue;
+				if (inst.length != 0 && slot.length != inst.length) {
+					throw std::invalid_argument("Invalid formula: arrays of " + token.str + " have different lengths");
+				}
+				inst.length = slot.length;
+			}
+
+			if (inst.length == 0) {
+				throw std::invalid_argument("Invalid formula: " + token.str + " needs arrays or vectors");
+			}
+			if (op == OpCode::Comp) {
+				inst.index = static_cast<int>(std::string("xyzw").find(token.str[1]));
+				if (inst.index >= inst.length) {
+					throw std::invalid_argument("Invalid formula: the vector of " + token.str + " is too short");
+				}
+			}
+			if (op == OpCode::Cross && (inst.length != 3 || inst.kind[0] == Operand::Scalar || inst.kind[1] == Operand::Scalar)) {
+				throw std::invalid_argument("Invalid formula: cross needs two vectors of length 3");
+			}
+
+			if (reduction) {
+				slots[depth] = ArraySlot();
+			} else if (op == OpCode::Cross) {
+				slots[depth] = { Operand::Array, depth, 3 };
+			} else {
+				inst.code = OpCode::AMap;
+				inst.op   = (inst.op == OpCode::PowInt) ? OpCode::PowInt : op;
+				slots[depth] = { Operand::Array, depth, inst.length };
+			}
+			code.push_back(inst);
+			array_num++;
+		}
+
+		/** @return `const Type*` elements of k-th operand of the array instruction, or `nullptr` for scalar */
+		const Type* array_operand(const Details::Instruction<Type>& inst, int k, const std::vector<Type>& registers) const
+		{
+			switch (inst.kind[k])
+			{
+			case Details::Operand::Param :
+				return arrays[inst.src[k]].data();
+			case Details::Operand::Array :
+				return registers.data() + inst.src[k] * array_len;
+			default :
+				return nullptr;
+			}
+		}
+
+		/**
+		 * @brief execute the array instruction
+		 * @param tan derivatives of the scalar registers. the derivatives are not calculated if it is `nullptr`.
+		 */
+		void execute_array(const Details::Instruction<Type>& inst, Type* reg, Type* tan, Workspace& ws) const
+		{
+			using Details::OpCode;
+			using Details::Operand;
+			const Type zero = static_cast<Type>(static_cast<Details::ValueType>(0.0));
+			const std::size_t n = static_cast<std::size_t>(inst.length);
+			const bool binary = inst.arg_num > 1 && inst.code != OpCode::Vec;  /* arguments of Vec are read below */
+
+			const Type* a  = array_operand(inst, 0, ws.array);
+			const Type* b  = binary ? array_operand(inst, 1, ws.array) : a;
+			const Type  av = (a == nullptr) ? reg[inst.src[0]] : zero;
+			const Type  bv = (b == nullptr) ? reg[inst.src[1]] : av;
+
+			/* derivatives of the operands: array variables are constant */
+			const Type* ta  = (inst.kind[0] == Operand::Array) ? ws.tarray.data() + inst.src[0] * array_len : nullptr;
+			const Type* tb  = !binary ? ta : (inst.kind[1] == Operand::Array) ? ws.tarray.data() + inst.src[1] * array_len : nullptr;
+			const Type  tav = (tan != nullptr && inst.kind[0] == Operand::Scalar) ? tan[inst.src[0]] : zero;
+			const Type  tbv = !binary ? tav : (tan != nullptr && inst.kind[1] == Operand::Scalar) ? tan[inst.src[1]] : zero;
+			auto value      = [&](const Type* p, const Type& v, std::size_t i) { return (p != nullptr) ? p[i] : v; };
+
+			switch (inst.code)
+			{
+			case OpCode::AMap :
+			{
+				Type* d  = ws.array.data() + inst.dst * array_len;
+				Type* td = ws.tarray.data() + inst.dst * array_len;
+				const int index = inst.index;
+				Details::dispatch(inst.op, [&](auto Code)
+				{
+					if (tan != nullptr) {
+						for (std::size_t i = 0; i < n; ++i) {
+							const Type x = value(a, av, i);
+							const Type y = value(b, bv, i);
+							const Type r = Details::operate<Code(), Type>(x, y, index);
+							td[i] = Details::differentiate<Code(), Type>(x, y, r, value(ta, tav, i), binary ? value(tb, tbv, i) : zero, index);
+							d[i]  = r;
+						}
+					} else if (a == nullptr) {
+						for (std::size_t i = 0; i < n; ++i) {
+							d[i] = Details::operate<Code(), Type>(av, b[i], index);
+						}
+					} else if (b == nullptr) {
+						for (std::size_t i = 0; i < n; ++i) {
+							d[i] = Details::operate<Code(), Type>(a[i], bv, index);
+						}
+					} else {
+						for (std::size_t i = 0; i < n; ++i) {
+							d[i] = Details::operate<Code(), Type>(a[i], b[i], index);
+						}
+					}
+				});
+				break;
+			}
+			case OpCode::Sum :
+				reg[inst.dst] = Details::reduce_sum<Type>(n, [&](std::size_t i) { return a[i]; });
+				if (tan != nullptr)
+					tan[inst.dst] = Details::reduce_sum<Type>(n, [&](std::size_t i) { return value(ta, tav, i); });
+				break;
+			case OpCode::Dot :
+				if (a != nullptr && b != nullptr) {
+					reg[inst.dst] = Details::reduce_sum<Type>(n, [&](std::size_t i) { return a[i] * b[i]; });
+				} else {
+					const Type* p = (a != nullptr) ? a : b;
+					reg[inst.dst] = Details::reduce_sum<Type>(n, [&](std::size_t i) { return p[i]; }) * ((a != nullptr) ? bv : av);
+				}
+				if (tan != nullptr) {
+					tan[inst.dst] = Details::reduce_sum<Type>(n, [&](std::size_t i)
+					{
+						return value(ta, tav, i) * value(b, bv, i) + value(a, av, i) * value(tb, tbv, i);
+					});
+				}
+				break;
+			case OpCode::Norm2 :
+			{
+				using std::sqrt;
+				const Type r = sqrt(Details::reduce_sum<Type>(n, [&](std::size_t i) { return a[i] * a[i]; }));
+				reg[inst.dst] = r;
+				if (tan != nullptr) {
+					const Type t = Details::reduce_sum<Type>(n, [&](std::size_t i) { return a[i] * value(ta, tav, i); });
+					tan[inst.dst] = (r == zero) ? zero : t / r;
+				}
+				break;
+			}
+			case OpCode::Max :
+				if constexpr (std::totally_ordered<Type>) {
+					std::size_t k = 0;
+					for (std::size_t i = 1; i < n; ++i) {
+						if (a[i] > a[k])
+							k = i;
+					}
+					reg[inst.dst] = a[k];
+					if (tan != nullptr)
+						tan[inst.dst] = value(ta, tav, k);
+				}
+				break;
+			case OpCode::Vec :
+			{
+				Type* d  = ws.array.data() + inst.dst * array_len;
+				Type* td = ws.tarray.data() + inst.dst * array_len;
+				for (std::size_t c = 0; c < n; ++c) {
+					d[c] = reg[inst.src[0] + c];
+					if (tan != nullptr)
+						td[c] = tan[inst.src[0] + c];
+				}
+				break;
+			}
+			case OpCode::Comp :
+				reg[inst.dst] = a[inst.index];
+				if (tan != nullptr)
+					tan[inst.dst] = value(ta, tav, inst.index);
+				break;
+			case OpCode::Cross :
+			{
+				/* the destination may be the register of the first operand */
+				const std::array<Type, 3> r = Details::cross(a[0], a[1], a[2], b[0], b[1], b[2]);
+				std::array<Type, 3> t;
+				if (tan != nullptr) {
+					const std::array<Type, 3> u = Details::cross(value(ta, zero, 0), value(ta, zero, 1), value(ta, zero, 2), b[0], b[1], b[2]);
+					const std::array<Type, 3> v = Details::cross(a[0], a[1], a[2], value(tb, zero, 0), value(tb, zero, 1), value(tb, zero, 2));
+					t = { u[0] + v[0], u[1] + v[1], u[2] + v[2] };
+				}
+				std::copy(r.begin(), r.end(), ws.array.data() + inst.dst * array_len);
+				if (tan != nullptr)
+					std::copy(t.begin(), t.end(), ws.tarray.data() + inst.dst * array_len);
+				break;
+			}
+			default :
+				break;
+			}
+		}
+
+		/**
+		 * @brief column of component `c` of k-th operand of the array instruction in batch evaluation
+		 * @param[out] value the value broadcast to the elements if it returns `nullptr`
+		 */
+		const Type* array_column(const Details::Instruction<Type>& inst, int k, std::size_t c, const Workspace& ws, Type& value) const
+		{
+			switch (inst.kind[k])
+			{
+			case Details::Operand::Param :
+				value = arrays[inst.src[k]][c];
+				return nullptr;
+			case Details::Operand::Array :
+				return ws.ablock.data() + (inst.src[k] * array_len + c) * BLOCK;
+			default :
+				return ws.block.data() + inst.src[k] * BLOCK;  /* scalar is broadcast to the components */
+			}
+		}
+
+		/** @brief execute the array instruction for `m` elements of the block. arrays are not longer than VECTOR_MAX */
+		void execute_array_block(const Details::Instruction<Type>& inst, std::size_t m, Workspace& ws) const
+		{
+			using Details::OpCode;
+			const std::size_t n = static_cast<std::size_t>(inst.length);
+			const bool binary = inst.arg_num > 1;
+			Type* d = ws.block.data() + inst.dst * BLOCK;  /* destination of reductions */
+			auto column = [&](std::size_t c) { return ws.ablock.data() + (inst.dst * array_len + c) * BLOCK; };
+			auto at     = [](const Type* p, const Type& v, std::size_t i) { return (p != nullptr) ? p[i] : v; };
+			Type av, bv;
+
+			switch (inst.code)
+			{
+			case OpCode::AMap :
+			{
+				const int index = inst.index;
+				Details::dispatch(inst.op, [&](auto Code)
+				{
+					for (std::size_t c = 0; c < n; ++c) {
+						const Type* a = array_column(inst, 0, c, ws, av);
+						const Type* b = binary ? array_column(inst, 1, c, ws, bv) : a;
+						if (!binary)
+							bv = av;
+						Type* dc = column(c);
+						if (a != nullptr && b != nullptr) {
+							for (std::size_t i = 0; i < m; ++i) {
+								dc[i] = Details::operate<Code(), Type>(a[i], b[i], index);
+							}
+						} else {
+							for (std::size_t i = 0; i < m; ++i) {
+								dc[i] = Details::operate<Code(), Type>(at(a, av, i), at(b, bv, i), index);
+							}
+						}
+					}
+				});
+				break;
+			}
+			case OpCode::Vec :
+				for (std::size_t c = 0; c < n; ++c) {
+					std::copy_n(ws.block.data() + (inst.src[0] + c) * BLOCK, m, column(c));
+				}
+				break;
+			case OpCode::Comp :
+			{
+				const Type* a = array_column(inst, 0, static_cast<std::size_t>(inst.index), ws, av);
+				for (std::size_t i = 0; i < m; ++i) {
+					d[i] = at(a, av, i);
+				}
+				break;
+			}
+			case OpCode::Sum :
+			case OpCode::Dot :
+			case OpCode::Norm2 :
+			{
+				/* accumulated apart from `d`, which is the column of a scalar first operand */
+				std::array<Type, BLOCK> acc;
+				for (std::size_t c = 0; c < n; ++c) {
+					const Type* a = array_column(inst, 0, c, ws, av);
+					const Type* b = (inst.code == OpCode::Dot) ? array_column(inst, 1, c, ws, bv) : a;
+					if (inst.code != OpCode::Dot)
+						bv = av;
+					for (std::size_t i = 0; i < m; ++i) {
+						const Type term = (inst.code == OpCode::Sum) ? at(a, av, i) : at(a, av, i) * at(b, bv, i);
+						acc[i] = (c == 0) ? term : acc[i] + term;
+					}
+				}
+				using std::sqrt;
+				for (std::size_t i = 0; i < m; ++i) {
+					d[i] = (inst.code == OpCode::Norm2) ? sqrt(acc[i]) : acc[i];
+				}
+				break;
+			}
+			case OpCode::Max :
+				if constexpr (std::totally_ordered<Type>) {
+					std::array<Type, BLOCK> acc;
+					for (std::size_t c = 0; c < n; ++c) {
+						const Type* a = array_column(inst, 0, c, ws, av);
+						for (std::size_t i = 0; i < m; ++i) {
+							acc[i] = (c == 0 || at(a, av, i) > acc[i]) ? at(a, av, i) : acc[i];
+						}
+					}
+					std::copy_n(acc.begin(), m, d);
+				}
+				break;
+			case OpCode::Cross :
+			{
+				std::array<const Type*, 3> a, b;
+				std::array<Type, 3> as, bs;
+				for (std::size_t c = 0; c < 3; ++c) {
+					a[c] = array_column(inst, 0, c, ws, as[c]);
+					b[c] = array_column(inst, 1, c, ws, bs[c]);
+				}
+				Type* x = column(0);
+				Type* y = column(1);
+				Type* z = column(2);
+				for (std::size_t i = 0; i < m; ++i) {
+					const std::array<Type, 3> r = Details::cross(at(a[0], as[0], i), at(a[1], as[1], i), at(a[2], as[2], i),
+					                                             at(b[0], bs[0], i), at(b[1], bs[1], i), at(b[2], bs[2], i));
+					x[i] = r[0];
+					y[i] = r[1];
+					z[i] = r[2];
+				}
+				break;
+			}
+			default :
+				break;
+			}
+		}
+
+		/** @brief evaluate the elements one by one, because array registers are too large for blocks */
+		void eval_elements(std::size_t n, const Type* const* columns, std::size_t slot, Type* out, Type* dout, Workspace& ws) const
+		{
+			for (std::size_t i = 0; i < n; ++i) {
+				for (std::size_t k = 0; k < free_num; ++k) {
+					ws.vars[k] = columns[k][i];
+				}
+				if (dout != nullptr) {
+					out[i] = eval_derivative(ws.vars.data(), slot, ws, dout[i]);
+				} else {
+					out[i] = eval(ws.vars.data(), ws);
+				}
+			}
+		}
+
+	public:
+		Program() = default;
+
+		/**
+		 * @brief compile rpn into program
+		 *
+		 * @param rpn       rpn made by Details::make_rpn()
+		 * @param variables free variables in the order of the arguments of evaluation
+		 * @param table     values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		Program(const Details::RPNs<Type>& rpn, const std::vector<std::string>& variables,
+		        const VariableTable<Type>& table = VariableTable<Type>())
+			: names(variables), free_num(variables.size())
+		{
+			using Details::OpCode;
+
+			if (rpn.empty()) {
+				throw std::invalid_argument("Invalid formula: formula is empty or parentheses are mismatched");
+			}
+
+			int depth = 0;
+			std::vector<int> table_at;  /* id of the data table in each register, or -1 */
+			std::vector<ArraySlot> array_at;
+			for (const Details::Token<Type>& token : rpn) {
+				table_at.resize(std::max(table_at.size(), static_cast<std::size_t>(depth) + 1), -1);
+				table_at[depth] = -1;
+				array_at.resize(table_at.size());
+				array_at[depth] = ArraySlot();
+
+				switch (token.type)
+				{
+				case Details::TokenType::Table :
+					/* no instruction: the table is bound to tab1 or tab2 which takes it */
+					table_at[depth] = static_cast<int>(Details::coordinate(token.value));
+					break;
+				case Details::TokenType::Variable :
+				{
+					int slot = find_name(token.str);
+					if (slot < 0 && table.contains_array(token.str)) {
+						/* no instruction: the array is read by the array instruction which takes it */
+						auto it = std::ranges::find(array_names, token.str);
+						if (it == array_names.end()) {
+							array_names.push_back(token.str);
+							arrays.push_back(table.array_at(token.str));
+							array_len = std::max(array_len, arrays.back().size());
+							it = array_names.end() - 1;
+						}
+						const int index = static_cast<int>(it - array_names.begin());
+						array_at[depth] = { Details::Operand::Param, index, static_cast<int>(arrays[index].size()) };
+						break;
+					}
+					if (slot < 0) {
+						if (!table.contains(token.str)) {
+							throw std::runtime_error("Invalid function: some variable are not determined");
+						}
+						slot = static_cast<int>(names.size());
+						names.push_back(token.str);
+						params.push_back(table.at(token.str));
+					}
+
+					if (static_cast<std::size_t>(slot) < free_num) {
+						code.push_back({ OpCode::Load, depth, { -1, -1, -1 }, 0, slot, 0, nullptr });
+					} else {
+						code.push_back({ OpCode::Param, depth, { -1, -1, -1 }, 0, static_cast<int>(slot - free_num), 0, nullptr });
+					}
+					break;
+				}
+				case Details::TokenType::Constant :
+				case Details::TokenType::Real :
+				case Details::TokenType::Imaginary :
+					code.push_back({ OpCode::Const, depth, { -1, -1, -1 }, 0, 0, token.value, nullptr });
+					break;
+				case Details::TokenType::Operator :
+				case Details::TokenType::Func0 :
+				case Details::TokenType::Func1 :
+				case Details::TokenType::Func2 :
+				case Details::TokenType::Func3 :
+				{
+					depth -= token.arg_num;
+					if (depth < 0) {
+						throw std::invalid_argument("Invalid formula: missing number of argument for " + token.str);
+					}
+					Details::reject_window_function(token);
+
+					OpCode op = Details::ret_opcode(token.str);
+					for (int k = Details::is_table(op) ? 1 : 0; k < token.arg_num; ++k) {
+						if (table_at[depth + k] >= 0) {
+							throw std::invalid_argument("Invalid formula: data table can be used only as the first argument of tab1 and tab2");
+						}
+					}
+
+					bool has_array = false;
+					for (int k = 0; k < token.arg_num; ++k) {
+						has_array = has_array || array_at[depth + k].kind != Details::Operand::Scalar;
+					}
+
+					int exponent = 0;
+					if (has_array || op == OpCode::Vec || op == OpCode::Comp || op == OpCode::Cross) {
+						compile_array(op, token, depth, array_at);
+					} else if (Details::is_table(op)) {
+						const int id = table_at[depth];
+						if (id < 0) {
+							throw std::invalid_argument("Invalid formula: the first argument of " + token.str + " must be a data table");
+						}
+						auto table = Details::data_table(static_cast<Type>(static_cast<Details::ValueType>(id)));
+						if (table->dimension() != static_cast<std::size_t>(token.arg_num - 1)) {
+							throw std::invalid_argument("Invalid formula: the data table of " + token.str + " has the other number of variables");
+						}
+						code.push_back({ op, depth, { depth + 1, depth + 2, -1 }, token.arg_num - 1, id, 0, nullptr, table.get() });
+						tables.push_back(std::move(table));
+						table_at[depth] = -1;
+					} else if (op == OpCode::Pow && code.back().code == OpCode::Const
+					    && Details::is_int_exponent(code.back().value, exponent)) {
+						code.pop_back(); /* the exponent is not needed as register */
+						code.push_back({ OpCode::PowInt, depth, { depth, -1, -1 }, 1, exponent, 0, nullptr });
+					} else if (Details::is_random(op)) {
+						code.push_back({ op, depth, { token.arg_num ? depth : -1, -1, -1 }, token.arg_num, random_num++, 0, nullptr });
+					} else if (op == OpCode::Call || Details::is_array(op)) {
+						/* reduction of a scalar is the function of the token */
+						code.push_back({ OpCode::Call, depth, { depth, -1, -1 }, token.arg_num, 0, 0, token.func });
+						max_arg = std::max(max_arg, token.arg_num);
+					} else {
+						code.push_back({ op, depth, { depth, depth + 1, -1 }, token.arg_num, 0, 0, nullptr });
+					}
+					fold_constant();
+					break;
+				}
+				default :
+					throw std::invalid_argument("Invalid formula: unexpected token " + token.str);
+				}
+
+				depth++;
+				reg_num = std::max(reg_num, static_cast<std::size_t>(depth));
+			}
+
+			if (depth != 1) {
+				throw std::invalid_argument("Invalid formula: some functions have too many arguments");
+			}
+			if (table_at[0] >= 0) {
+				throw std::invalid_argument("Invalid formula: data table can be used only as the first argument of tab1 and tab2");
+			}
+			if (array_at[0].kind != Details::Operand::Scalar) {
+				throw std::invalid_argument("Invalid formula: the result is an array. use reductions like sum()");
+			}
+		}
+
+		~Program() = default;
+
+		/** @return `Workspace` buffers reserved for this program */
+		Workspace make_workspace(void) const
+		{
+			Workspace ws;
+			ws.reg.resize(reg_num);
+			ws.args.reserve(static_cast<std::size_t>(max_arg));
+			ws.block.resize(reg_num * BLOCK);
+			ws.tangent.resize(reg_num);
+			ws.tblock.resize(reg_num * BLOCK);
+			ws.targs.reserve(static_cast<std::size_t>(max_arg));
+			ws.array.resize(reg_num * array_len);
+			ws.tarray.resize(reg_num * array_len);
+			if (array_len <= VECTOR_MAX) {
+				ws.ablock.resize(reg_num * array_len * BLOCK);
+			}
+			ws.vars.resize(free_num);
+			return ws;
+		}
+
+		/**
+		 * @brief evaluate the program
+		 * @param vars values of free variables
+		 * @param ws   workspace made by make_workspace()
+		 */
+		Type eval(const Type* vars, Workspace& ws) const
+		{
+			const Details::RandomKey key = { seed, ws.stream++ };
+			for (const Details::Instruction<Type>& inst : code) {
+				if (array_num != 0 && Details::is_array(inst.code)) {
+					execute_array(inst, ws.reg.data(), nullptr, ws);
+					continue;
+				}
+				Details::execute(inst, ws.reg.data(), vars, params.data(), ws.args, key);
+			}
+			return ws.reg[0];
+		}
+
+		/**
+		 * @brief evaluate the program
+		 * @param vars values of free variables
+		 * @throw `std::invalid_argument` if the number of values is not equal to the number of free variables
+		 */
+		Type operator()(std::initializer_list<Type> vars) const
+		{
+			if (vars.size() != free_num) {
+				throw std::invalid_argument("Program: the number of variables is invalid");
+			}
+			Workspace ws = make_workspace();
+			return eval(std::data(vars), ws);
+		}
+
+		/**
+		 * @brief evaluate the program for every elements
+		 *
+		 * @param n       the number of elements
+		 * @param columns `columns[k][i]` is the value of k-th free variable of i-th element
+		 * @param out     `out[i]` is the result of i-th element
+		 * @param ws      workspace made by make_workspace()
+		 */
+		void eval_batch(std::size_t n, const Type* const* columns, Type* out, Workspace& ws) const
+		{
+			using Details::OpCode;
+			if (array_len > VECTOR_MAX) {
+				eval_elements(n, columns, 0, out, nullptr, ws);
+				return;
+			}
+
+			for (std::size_t base = 0; base < n; base += BLOCK) {
+				const std::size_t m = std::min(BLOCK, n - base);
+
+				for (const Details::Instruction<Type>& inst : code) {
+					Type* d = ws.block.data() + inst.dst * BLOCK;
+
+					switch (inst.code)
+					{
+					case OpCode::Load :
+						std::copy_n(columns[inst.index] + base, m, d);
+						break;
+					case OpCode::Param :
+						std::fill_n(d, m, params[inst.index]);
+						break;
+					case OpCode::Const :
+						std::fill_n(d, m, inst.value);
+						break;
+					case OpCode::Call :
+						for (std::size_t i = 0; i < m; ++i) {
+							ws.args.resize(inst.arg_num);
+							for (int k = 0; k < inst.arg_num; ++k) {
+								ws.args[k] = ws.block[(inst.src[0] + k) * BLOCK + i];
+							}
+							d[i] = inst.func(ws.args);
+						}
+						break;
+					case OpCode::AMap :
+					case OpCode::Sum :
+					case OpCode::Dot :
+					case OpCode::Norm2 :
+					case OpCode::Max :
+					case OpCode::Vec :
+					case OpCode::Comp :
+					case OpCode::Cross :
+						execute_array_block(inst, m, ws);
+						break;
+					case OpCode::Tab1 :
+					case OpCode::Tab2 :
+					{
+						/* gather of the table: d is the register of the table, which is not read */
+						const Type* x = ws.block.data() + inst.src[0] * BLOCK;
+						const Type* y = ws.block.data() + inst.src[inst.arg_num - 1] * BLOCK;
+						Type dx, dy;
+						for (std::size_t i = 0; i < m; ++i) {
+							d[i] = Details::lookup(inst, x[i], y[i], dx, dy);
+						}
+						break;
+					}
+					case OpCode::RandU :
+					case OpCode::RandN :
+					case OpCode::RandE :
+						/* each element has its own stream */
+						for (std::size_t i = 0; i < m; ++i) {
+							d[i] = Details::draw(inst, d[i], { seed, ws.stream + base + i });
+						}
+						break;
+					default :
+					{
+						const Type* a = ws.block.data() + inst.src[0] * BLOCK;
+						const Type* b = (inst.arg_num > 1) ? ws.block.data() + inst.src[1] * BLOCK : a;
+						const int index = inst.index;
+						Details::dispatch(inst.code, [&](auto Code)
+						{
+							for (std::size_t i = 0; i < m; ++i) {
+								d[i] = Details::operate<Code(), Type>(a[i], b[i], index);
+							}
+						});
+						break;
+					}
+					}
+				}
+
+				std::copy_n(ws.block.data(), m, out + base);
+			}
+			ws.stream += n;
+		}
+
+		/**
+		 * @brief evaluate the program for every elements with threads
+		 * @param threads the number of threads. `0` means the number of hardware threads.
+		 * @note  random numbers of i-th element are drawn from stream i. change the seed to draw the others.
+		 */
+		void eval_batch(std::size_t n, const Type* const* columns, Type* out, std::size_t threads = 0) const
+		{
+			std::vector<Workspace> wss(Details::ret_thread_num(threads), make_workspace());
+
+			Details::parallel_for(n, 16 * BLOCK, wss.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					std::vector<const Type*> cols(free_num);
+					for (std::size_t k = 0; k < free_num; ++k) {
+						cols[k] = columns[k] + begin;
+					}
+					wss[worker].stream = begin; /* the stream of each element does not depend on the threads */
+					eval_batch(end - begin, cols.data(), out + begin, wss[worker]);
+				});
+		}
+
+		/**
+		 * @brief evaluate the program and its derivative by forward mode automatic differentiation
+		 *
+		 * @param vars            values of free variables
+		 * @param slot            slot index of the variable to differentiate by (see slot())
+		 * @param ws              workspace made by make_workspace()
+		 * @param[out] derivative derivative of the result
+		 * @return `Type` the result
+		 * @note  derivatives of custom functions are calculated by central difference.
+		 */
+		Type eval_derivative(const Type* vars, std::size_t slot, Workspace& ws, Type& derivative) const
+		{
+			using Details::OpCode;
+			const Type zero = static_cast<Type>(static_cast<Details::ValueType>(0.0));
+			const Type one  = static_cast<Type>(static_cast<Details::ValueType>(1.0));
+			Type* reg = ws.reg.data();
+			Type* tan = ws.tangent.data();
+			const Details::RandomKey key = { seed, ws.stream++ };
+
+			for (const Details::Instruction<Type>& inst : code) {
+				switch (inst.code)
+				{
+				case OpCode::Load :
+					reg[inst.dst] = vars[inst.index];
+					tan[inst.dst] = (static_cast<std::size_t>(inst.index) == slot) ? one : zero;
+					break;
+				case OpCode::Param :
+					reg[inst.dst] = params[inst.index];
+					tan[inst.dst] = (free_num + inst.index == slot) ? one : zero;
+					break;
+				case OpCode::Const :
+					reg[inst.dst] = inst.value;
+					tan[inst.dst] = zero;
+					break;
+				case OpCode::Call :
+				{
+					const Type t = Details::call_tangent(inst.func, inst.arg_num, reg + inst.src[0], tan + inst.src[0], ws.args);
+					Details::execute(inst, reg, vars, params.data(), ws.args);
+					tan[inst.dst] = t;
+					break;
+				}
+				case OpCode::Tab1 :
+				case OpCode::Tab2 :
+				{
+					const int sx = inst.src[0], sy = inst.src[inst.arg_num - 1];
+					Type dx, dy;
+					reg[inst.dst] = Details::lookup(inst, reg[sx], reg[sy], dx, dy);
+					tan[inst.dst] = (inst.code == OpCode::Tab2) ? dx * tan[sx] + dy * tan[sy] : dx * tan[sx];
+					break;
+				}
+				case OpCode::AMap :
+				case OpCode::Sum :
+				case OpCode::Dot :
+				case OpCode::Norm2 :
+				case OpCode::Max :
+				case OpCode::Vec :
+				case OpCode::Comp :
+				case OpCode::Cross :
+					execute_array(inst, reg, tan, ws);
+					break;
+				case OpCode::RandU :
+				case OpCode::RandN :
+					reg[inst.dst] = Details::draw(inst, zero, key);
+					tan[inst.dst] = zero;
+					break;
+				case OpCode::RandE :
+				{
+					/* d(E / l) = -(E / l) / l dl */
+					const Type l = reg[inst.src[0]];
+					const Type r = Details::draw(inst, l, key);
+					reg[inst.dst] = r;
+					tan[inst.dst] = zero - r / l * tan[inst.src[0]];
+					break;
+				}
+				default :
+				{
+					const bool binary = inst.arg_num > 1;
+					const Type a  = reg[inst.src[0]];
+					const Type b  = binary ? reg[inst.src[1]] : a;
+					const Type da = tan[inst.src[0]];
+					const Type db = binary ? tan[inst.src[1]] : zero;
+					const int index = inst.index;
+					Details::dispatch(inst.code, [&](auto Code)
+					{
+						const Type r = Details::operate<Code(), Type>(a, b, index);
+						reg[inst.dst] = r;
+						tan[inst.dst] = Details::differentiate<Code(), Type>(a, b, r, da, db, index);
+					});
+					break;
+				}
+				}
+			}
+
+			derivative = tan[0];
+			return reg[0];
+		}
+
+		/**
+		 * @brief evaluate the program and its derivative for every elements
+		 *
+		 * @param n       the number of elements
+		 * @param columns `columns[k][i]` is the value of k-th free variable of i-th element
+		 * @param slot    slot index of the variable to differentiate by (see slot())
+		 * @param out     `out[i]` is the result of i-th element
+		 * @param dout    `dout[i]` is the derivative of i-th element
+		 * @param ws      workspace made by make_workspace()
+		 */
+		void eval_batch_derivative(std::size_t n, const Type* const* columns, std::size_t slot,
+		                           Type* out, Type* dout, Workspace& ws) const
+		{
+			using Details::OpCode;
+			const Type zero = static_cast<Type>(static_cast<Details::ValueType>(0.0));
+			const Type one  = static_cast<Type>(static_cast<Details::ValueType>(1.0));
+			if (array_num != 0) {
+				eval_elements(n, columns, slot, out, dout, ws);
+				return;
+			}
+
+			for (std::size_t base = 0; base < n; base += BLOCK) {
+				const std::size_t m = std::min(BLOCK, n - base);
+
+				for (const Details::Instruction<Type>& inst : code) {
+					Type* d  = ws.block.data()  + inst.dst * BLOCK;
+					Type* td = ws.tblock.data() + inst.dst * BLOCK;
+
+					switch (inst.code)
+					{
+					case OpCode::Load :
+						std::copy_n(columns[inst.index] + base, m, d);
+						std::fill_n(td, m, (static_cast<std::size_t>(inst.index) == slot) ? one : zero);
+						break;
+					case OpCode::Param :
+						std::fill_n(d, m, params[inst.index]);
+						std::fill_n(td, m, (free_num + inst.index == slot) ? one : zero);
+						break;
+					case OpCode::Const :
+						std::fill_n(d, m, inst.value);
+						std::fill_n(td, m, zero);
+						break;
+					case OpCode::Call :
+						for (std::size_t i = 0; i < m; ++i) {
+							ws.targs.resize(inst.arg_num);
+							std::vector<Type>& values = ws.tangent; /* reg_num >= arg_num */
+							for (int k = 0; k < inst.arg_num; ++k) {
+								values[k]   = ws.block[(inst.src[0] + k) * BLOCK + i];
+								ws.targs[k] = ws.tblock[(inst.src[0] + k) * BLOCK + i];
+							}
+							const Type t = Details::call_tangent(inst.func, inst.arg_num, values.data(), ws.targs.data(), ws.args);
+							ws.args.assign(values.begin(), values.begin() + inst.arg_num);
+							d[i]  = inst.func(ws.args);
+							td[i] = t;
+						}
+						break;
+					case OpCode::Tab1 :
+					case OpCode::Tab2 :
+					{
+						const Type* x  = ws.block.data()  + inst.src[0] * BLOCK;
+						const Type* y  = ws.block.data()  + inst.src[inst.arg_num - 1] * BLOCK;
+						const Type* tx = ws.tblock.data() + inst.src[0] * BLOCK;
+						const Type* ty = ws.tblock.data() + inst.src[inst.arg_num - 1] * BLOCK;
+						Type dx, dy;
+						for (std::size_t i = 0; i < m; ++i) {
+							d[i]  = Details::lookup(inst, x[i], y[i], dx, dy);
+							td[i] = (inst.code == OpCode::Tab2) ? dx * tx[i] + dy * ty[i] : dx * tx[i];
+						}
+						break;
+					}
+					case OpCode::RandU :
+					case OpCode::RandN :
+					case OpCode::RandE :
+						for (std::size_t i = 0; i < m; ++i) {
+							const Type l = d[i];
+							d[i]  = Details::draw(inst, l, { seed, ws.stream + base + i });
+							td[i] = (inst.code == OpCode::RandE) ? zero - d[i] / l * td[i] : zero;
+						}
+						break;
+					default :
+					{
+						const bool binary = inst.arg_num > 1;
+						const Type* a  = ws.block.data()  + inst.src[0] * BLOCK;
+						const Type* b  = binary ? ws.block.data()  + inst.src[1] * BLOCK : a;
+						const Type* da = ws.tblock.data() + inst.src[0] * BLOCK;
+						const Type* db = binary ? ws.tblock.data() + inst.src[1] * BLOCK : nullptr;
+						const int index = inst.index;
+						Details::dispatch(inst.code, [&](auto Code)
+						{
+							for (std::size_t i = 0; i < m; ++i) {
+								const Type av = a[i];
+								const Type bv = b[i];
+								const Type r  = Details::operate<Code(), Type>(av, bv, index);
+								td[i] = Details::differentiate<Code(), Type>(av, bv, r, da[i], binary ? db[i] : zero, index);
+								d[i]  = r;
+							}
+						});
+						break;
+					}
+					}
+				}
+
+				std::copy_n(ws.block.data(),  m, out  + base);
+				std::copy_n(ws.tblock.data(), m, dout + base);
+			}
+			ws.stream += n;
+		}
+
+		/**
+		 * @brief change the value of parameter
+		 * @throw `std::out_of_range` if the name is not a parameter of this program
+		 */
+		void set_parameter(const std::string& str, const Type& value)
+		{
+			int slot = find_name(str);
+			if (slot < static_cast<int>(free_num)) {
+				throw std::out_of_range("Program: " + str + " is not a parameter");
+			}
+			params[slot - free_num] = value;
+		}
+
+		/**
+		 * @brief change the value of parameter by its index without searching the name
+		 * @param index slot index - variable_num(). This must be valid.
+		 */
+		void set_parameter(std::size_t index, const Type& value) noexcept
+		{
+			params[index] = value;
+		}
+
+		/**
+		 * @brief change the values of array variable
+		 * @throw `std::out_of_range` if the name is not an array of this program, or the length is different
+		 */
+		void set_array(const std::string& str, const std::vector<Type>& values)
+		{
+			auto it = std::ranges::find(array_names, str);
+			if (it == array_names.end() || arrays[it - array_names.begin()].size() != values.size()) {
+				throw std::out_of_range("Program: " + str + " is not an array of the same length");
+			}
+			arrays[it - array_names.begin()] = values;
+		}
+
+		/**
+		 * @brief change the seed of randu(), randn() and rande()
+		 * @note  random numbers depend only on (seed, stream of Workspace, position in the formula).
+		 */
+		void set_seed(std::uint64_t seed) noexcept
+		{
+			this->seed = seed;
+		}
+
+		/** @return `bool` true if the formula draws random numbers */
+		bool is_random(void) const noexcept { return random_num != 0; }
+
+		/** @return `int` slot index of the variable (free variables first, then parameters), or `-1` */
+		int slot(const std::string& str) const noexcept { return find_name(str); }
+
+		/** @return `const auto&` names of free variables and parameters */
+		const std::vector<std::string>& variables(void) const noexcept { return names; }
+
+		/** @return `const auto&` values of parameters */
+		const std::vector<Type>& parameters(void) const noexcept { return params; }
+
+		/** @return `const auto&` compiled instructions */
+		const std::vector<Details::Instruction<Type>>& instructions(void) const noexcept { return code; }
+
+		/** @return `std::size_t` the number of free variables */
+		std::size_t variable_num(void) const noexcept { return free_num; }
+
+		/** @return `std::size_t` the number of registers */
+		std::size_t register_num(void) const noexcept { return reg_num; }
+	};
+
+
+	template <Details::MathConcept Type>
+	class Syamfp
+	{
+	private:
+		std::string formula;
+		VariableTable<Type> table;
+		Details::VariableList vars;
+		Details::CompiledRPN<Type> crpn;
+		Details::RPNs<Type> rpn;
+
+	public:
+		Syamfp() = default;
+
+		Syamfp(const std::string& formula, const VariableTable<Type>& table = VariableTable<Type>())
+			: formula(formula), table(table), vars(), crpn(), rpn() {};
+
+		~Syamfp() = default;
+
+		/**
+		 * @brief parse and compile formula
+		 * @param formula compiled formula
+		 * @return `int` `0`:Success, `negative`:Error
+		 */
+		int parse(const std::string& formula)
+		{
+			auto rpn = Details::make_rpn<Type>(formula);
+			if (rpn == Details::BAD_RPNs<Type>) {
+				return -EINVAL;
+			}
+
+			try {
+				auto crpn = Details::compile_RPN<Type>(rpn, vars);
+				this->crpn = crpn;
+				this->rpn = rpn;
+				this->formula = formula;
+				return 0;
+			} catch (const std::exception& e) {
+				return -EINVAL;
+			}
+		}
+
+		/**
+		 * @brief parse and compile formula
+		 * @param formula compiled formula
+		 * @param table used variable table
+		 * @return `int` `0`:Success, `negative`:Error
+		 */
+		int parse(const std::string& formula, const VariableTable<Type>& table)
+		{
+			this->table = table;
+			return parse(formula);
+		}
+
+		/** @brief register variable table */
+		void regist(const VariableTable<Type>& table)
+		{
+			this->table = table;
+		}
+
+		/**
+		 * @brief return functional object
+		 *
+		 * @param[in] variable_string variable string used as variable like "x", "z", etc.
+		 * @return `auto` functional object
+		 * @throw `std::runtime_error` if unknown variable is included in function
+		 * @throw `std::invalid_argument` if vectors, array variables or rolling-window functions are used
+		 */
+		auto ret_func(const std::string& variable_string) -> std::function<Type(const Type&)>
+		{
+			for (const Details::Token<Type>& token : rpn) {
+				if (token.type == Details::TokenType::Variable)
+					continue;  /* like "vx" used as a variable */
+				Details::reject_window_function(token);
+				const Details::OpCode op = Details::ret_opcode(token.str);
+				if (op == Details::OpCode::Vec || op == Details::OpCode::Comp || op == Details::OpCode::Cross) {
+					throw std::invalid_argument("Invalid function: vectors are supported by ret_program() only");
+				}
+			}
+
+			/* check variable list */
+			for (const std::string& str : vars) {
+				if (table.contains_array(str) && (str != variable_string)) {
+					throw std::invalid_argument("Invalid function: array variables are supported by ret_program() only");
+				}
+				if (!table.contains(str) && (str != variable_string)) {
+					throw std::runtime_error("Invalid function: some variable are not determined");
+				}
+			}
+
+			/* copy member variable to use in lambda function */
+			VariableTable<Type> Table = table;
+			Details::CompiledRPN<Type> CRPN = crpn;
+			return [Table, CRPN, variable_string](const Type& value) -> Type
+			{
+				Details::Stack<Type> stack;
+				VariableTable<Type> table(Table);
+				table += {variable_string, value};
+
+				for (const Details::CompiledFunc<Type>& func : CRPN) {
+					func(stack, table);
+				}
+
+				return stack.front();
+			};
+		}
+
+		/**
+		 * @brief return compiled program
+		 *
+		 * @param[in] variables variable strings given at each evaluation like {"z", "c"}.
+		 *            the other variables are read from the registered variable table.
+		 * @return `Program<Type>` program evaluated without copying the variable table
+		 * @throw `std::runtime_error` if unknown variable is included in function
+		 * @throw `std::invalid_argument` if no formula is parsed
+		 */
+		auto ret_program(const std::vector<std::string>& variables) const -> Program<Type>
+		{
+			return Program<Type>(rpn, variables, table);
+		}
+
+		/**
+		 * @brief parse the formula and return compiled program
+		 *
+		 * @param[in] formula   formula like "sin(x)*y"
+		 * @param[in] variables variable strings given at each evaluation
+		 * @param[in] table     values of the other variables
+		 * @return `Program<Type>` compiled program
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		static auto compile(const std::string& formula, const std::vector<std::string>& variables,
+		                    const VariableTable<Type>& table = VariableTable<Type>()) -> Program<Type>
+		{
+			Syamfp<Type> parser;
+			if (parser.parse(formula, table) != 0) {
+				throw std::invalid_argument("Invalid formula: " + formula);
+			}
+			return parser.ret_program(variables);
+		}
+
+		/** @return `const Details::VariableList&` variable strings used in the parsed formula */
+		const Details::VariableList& ret_variables(void) const noexcept
+		{
+			return vars;
+		}
+
+		/** @return `const std::string&` parsed formula */
+		const std::string& ret_formula(void) const noexcept
+		{
+			return formula;
+		}
+	};
+
+	/**
+	 * @brief add function used in formulas of all parsers of `Type`
+	 *
+	 * The function added before by the same name is replaced.
+	 *
+	 * @param name    name of the function
+	 * @param type    TokenType::Func0 to TokenType::Func3
+	 * @param arg_num the number of arguments
+	 * @param lambda  function of the arguments
+	 * @throw `std::invalid_argument` if the name is used by a builtin function, a constant, an operator or a data table
+	 */
+	template <Details::MathConcept Type>
+	void add_custom_function(const std::string& name, Details::TokenType type, int arg_num, Details::Func<Type> lambda)
+	{
+		auto pair = Details::RESERVED_TOKEN<Type>.find(name);
+		if (pair != Details::RESERVED_TOKEN<Type>.end() && !Details::CUSTOM_FUNCTION<Type>.contains(name)) {
+			throw std::invalid_argument("add_custom_function: " + name + " is already used by a builtin function, a constant, an operator or a data table");
+		}
+		Details::CUSTOM_FUNCTION<Type>.insert(name);
+		Details::RESERVED_TOKEN<Type>.insert_or_assign(name,
+			Details::Token<Type>(name, type, arg_num, static_cast<Details::ValueType>(0.0), lambda));
+	}
+
+	/**
+	 * @brief add data table of one variable used by `tab1(name, x)`
+	 *
+	 * The table is bound to Program at the compilation, and the program keeps it after it is replaced by
+	 * the other table of the same name. The replaced table is released when no program uses it.
+	 *
+	 * @param name          name of the table in formulas
+	 * @param x             strictly increasing grid, which may be non-uniform
+	 * @param values        `values[i]` is the value at x[i]
+	 * @param interpolation linear or cubic. the variable out of the grid is clamped.
+	 * @throw `std::invalid_argument` if the grid is not strictly increasing or the sizes are not equal,
+	 *        or the name is used by a function, a constant or an operator
+	 */
+	template <Details::MathConcept Type>
+	void add_data_table(const std::string& name, const std::vector<double>& x, const std::vector<Type>& values,
+	                    Interpolation interpolation = Interpolation::Cubic)
+	{
+		Details::add_data_table(name, std::make_shared<const Details::DataTable<Type>>(x, values, interpolation));
+	}
+
+	/**
+	 * @brief add data table of two variables used by `tab2(name, x, y)`
+	 *
+	 * @param name          name of the table in formulas
+	 * @param x, y          strictly increasing grids, which may be non-uniform
+	 * @param values        `values[j * x.size() + i]` is the value at (x[i], y[j])
+	 * @param interpolation bilinear or bicubic. the variables out of the grid are clamped.
+	 * @throw `std::invalid_argument` if the grid is not strictly increasing or the sizes are not equal,
+	 *        or the name is used by a function, a constant or an operator
+	 */
+	template <Details::MathConcept Type>
+	void add_data_table(const std::string& name, const std::vector<double>& x, const std::vector<double>& y,
+	                    const std::vector<Type>& values, Interpolation interpolation = Interpolation::Cubic)
+	{
+		Details::add_data_table(name, std::make_shared<const Details::DataTable<Type>>(x, y, values, interpolation));
+	}
+}
+
+#endif /* end of __SYAMFP_HPP__ */
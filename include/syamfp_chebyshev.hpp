@@ -0,0 +1,325 @@
+/**
+ * @file syamfp_chebyshev.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Piecewise Chebyshev approximation of compiled formulas
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_CHEBYSHEV_HPP__
+#define __SYAMFP_CHEBYSHEV_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	/**
+	 * @brief piecewise Chebyshev expansion of a formula of one variable on [a, b]
+	 *
+	 * Each piece is sampled at the Chebyshev extrema of the maximum degree, where all pieces of a round are
+	 * evaluated by one batch evaluation, and the coefficients are calculated by the discrete cosine transform.
+	 * A piece is bisected while its coefficients do not decay below the tolerance, and the rest is truncated
+	 * to the lowest degree within the tolerance. Evaluation is Clenshaw's recurrence: `degree()` multiply-adds.
+	 *
+	 * eval_batch() pads the coefficients of all pieces to the same degree, so that the loop over the elements
+	 * of a block runs the same recurrence for all of them and can be vectorized with gathers of the coefficients.
+	 * A block whose elements are in one piece, which is usual for sorted inputs, reads the coefficients without gathers.
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	class ChebyshevApproximation
+	{
+	public:
+		struct Option
+		{
+			std::size_t max_degree = 32;
+			std::size_t max_pieces = 1024;
+			std::size_t threads    = 0;  /* 0 means the number of hardware threads */
+		};
+
+	private:
+		static constexpr std::size_t BLOCK = 64;
+
+		std::vector<Type>        breaks;  /* pieces[k] is [breaks[k], breaks[k + 1]] */
+		std::vector<std::size_t> degrees;
+		std::vector<Type>        coefs;   /* coefs[k * (max_deg + 1) + j], padded by zero */
+		std::size_t              max_deg = 0;
+		double                   err     = 0.0;
+
+		/** @return `std::size_t` index of the piece of x. x out of [a, b] uses the piece at the end */
+		std::size_t piece(const Type& x) const
+		{
+			const auto it = std::upper_bound(breaks.begin() + 1, breaks.end() - 1, x);
+			return static_cast<std::size_t>(it - (breaks.begin() + 1));
+		}
+
+		/** @return `Type` x mapped to [-1, 1] of the piece */
+		Type local(std::size_t k, const Type& x) const
+		{
+			return (Details::num<Type>(2.0) * x - (breaks[k] + breaks[k + 1])) / (breaks[k + 1] - breaks[k]);
+		}
+
+		/** @brief make the pieces and their coefficients */
+		void build(const Program<Type>& program, const Type& a, const Type& b, double tol, const Option& option)
+		{
+			using std::abs;
+			const std::size_t n = std::max<std::size_t>(option.max_degree, 2);
+			std::vector<double> cosine(2 * n);
+			for (std::size_t k = 0; k < 2 * n; ++k) {
+				cosine[k] = std::cos(std::numbers::pi * static_cast<double>(k) / static_cast<double>(n));
+			}
+
+			struct Piece
+			{
+				Type lo, hi;
+				std::vector<Type> c;
+				std::size_t degree;
+			};
+			std::vector<Piece> done, pending = { { a, b, {}, 0 } }, next;
+			std::vector<Type> xs, fs;
+
+			while (!pending.empty()) {
+				/* sample all pending pieces at once */
+				xs.clear();
+				for (const Piece& p : pending) {
+					for (std::size_t k = 0; k <= n; ++k) {
+						xs.push_back(Details::num<Type>(0.5) * (p.lo + p.hi) + Details::num<Type>(0.5 * cosine[k]) * (p.hi - p.lo));
+					}
+				}
+				const Type* columns[1] = { xs.data() };
+				fs.resize(xs.size());
+				program.eval_batch(xs.size(), columns, fs.data(), option.threads);
+
+				next.clear();
+				for (std::size_t s = 0; s < pending.size(); ++s) {
+					Piece& p = pending[s];
+					const Type* f = fs.data() + s * (n + 1);
+
+					/* c_j = 2/n sum'' f_k cos(pi j k / n) */
+					p.c.assign(n + 1, Details::num<Type>(0.0));
+					for (std::size_t j = 0; j <= n; ++j) {
+						Type sum = Details::num<Type>(0.5) * (f[0] + ((j % 2 == 0) ? f[n] : -f[n]));
+						for (std::size_t k = 1; k < n; ++k) {
+							sum += f[k] * Details::num<Type>(cosine[(j * k) % (2 * n)]);
+						}
+						p.c[j] = Details::num<Type>(2.0 / static_cast<double>(n)) * sum;
+					}
+					p.c[0] *= Details::num<Type>(0.5);
+					p.c[n] *= Details::num<Type>(0.5);
+
+					/* the lowest degree whose tail is within the tolerance */
+					double tail = 0.0;
+					std::size_t degree = n;
+					while (degree > 0) {
+						const double t = tail + static_cast<double>(abs(p.c[degree]));
+						if (!(t <= 0.5 * tol))
+							break;
+						tail = t;
+						degree--;
+					}
+					const bool resolved = degree + 3 <= n && std::isfinite(tail);
+
+					if (!resolved && done.size() + pending.size() + next.size() < option.max_pieces) {
+						const Type mid = Details::num<Type>(0.5) * (p.lo + p.hi);
+						if (p.lo < mid && mid < p.hi) {
+							next.push_back({ p.lo, mid, {}, 0 });
+							next.push_back({ mid, p.hi, {}, 0 });
+							continue;
+						}
+					}
+					if (!resolved) {
+						/* the limit is reached: keep all coefficients, and the last ones estimate the error */
+						degree = n;
+						tail   = static_cast<double>(abs(p.c[n - 1])) + static_cast<double>(abs(p.c[n]));
+					}
+					p.degree = degree;
+					err = std::max(err, tail);
+					done.push_back(std::move(p));
+				}
+				pending.swap(next);
+			}
+
+			std::sort(done.begin(), done.end(), [](const Piece& p, const Piece& q) { return p.lo < q.lo; });
+			for (const Piece& p : done) {
+				max_deg = std::max(max_deg, p.degree);
+			}
+			for (const Piece& p : done) {
+				breaks.push_back(p.lo);
+				degrees.push_back(p.degree);
+				for (std::size_t j = 0; j <= max_deg; ++j) {
+					coefs.push_back((j <= p.degree) ? p.c[j] : Details::num<Type>(0.0));
+				}
+			}
+			breaks.push_back(b);
+		}
+
+	public:
+		/**
+		 * @brief approximate the program of one free variable
+		 *
+		 * @param program program with one free variable
+		 * @param a, b    interval
+		 * @param tol     absolute tolerance
+		 * @param option  limits of the approximation
+		 * @throw `std::invalid_argument` if the program does not have one free variable, or the interval is empty
+		 */
+		ChebyshevApproximation(const Program<Type>& program, const Type& a, const Type& b, double tol,
+		                       const Option& option = Option())
+		{
+			if (program.variable_num() != 1) {
+				throw std::invalid_argument("ChebyshevApproximation: program must have one variable");
+			}
+			if (!(a < b)) {
+				throw std::invalid_argument("ChebyshevApproximation: interval is empty");
+			}
+			build(program, a, b, tol, option);
+		}
+
+		/**
+		 * @brief approximate the formula
+		 *
+		 * @param formula  formula like "exp(-x) * sin(3*x)"
+		 * @param variable variable string
+		 * @param a, b     interval
+		 * @param tol      absolute tolerance
+		 * @param table    values of the other variables
+		 * @param option   limits of the approximation
+		 * @throw `std::invalid_argument` if the formula is invalid, or the interval is empty
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		ChebyshevApproximation(const std::string& formula, const std::string& variable,
+		                       const Type& a, const Type& b, double tol,
+		                       const VariableTable<Type>& table = VariableTable<Type>(),
+		                       const Option& option = Option())
+		{
+			if (!(a < b)) {
+				throw std::invalid_argument("ChebyshevApproximation: interval is empty");
+			}
+			build(Syamfp<Type>::compile(formula, {variable}, table), a, b, tol, option);
+		}
+
+		~ChebyshevApproximation() = default;
+
+		/** @return `Type` approximated value at x by Clenshaw's recurrence */
+		Type operator()(const Type& x) const
+		{
+			const std::size_t k = piece(x);
+			const Type t2 = Details::num<Type>(2.0) * local(k, x);
+			const Type* c = coefs.data() + k * (max_deg + 1);
+
+			Type b1 = Details::num<Type>(0.0), b2 = Details::num<Type>(0.0);
+			for (std::size_t j = degrees[k]; j > 0; --j) {
+				const Type b0 = c[j] + t2 * b1 - b2;
+				b2 = b1;
+				b1 = b0;
+			}
+			return c[0] + Details::num<Type>(0.5) * t2 * b1 - b2;
+		}
+
+		/**
+		 * @brief evaluate every elements
+		 * @param n   the number of elements
+		 * @param x   `x[i]` is the variable of i-th element
+		 * @param out `out[i]` is the result of i-th element
+		 */
+		void eval_batch(std::size_t n, const Type* x, Type* out) const
+		{
+			const std::size_t stride = max_deg + 1;
+			Type t2[BLOCK], b1[BLOCK], b2[BLOCK];
+			std::size_t base_of[BLOCK];
+
+			for (std::size_t base = 0; base < n; base += BLOCK) {
+				const std::size_t m = std::min(BLOCK, n - base);
+				bool same = true;  /* all elements are in one piece */
+				for (std::size_t i = 0; i < m; ++i) {
+					const std::size_t k = piece(x[base + i]);
+					t2[i] = Details::num<Type>(2.0) * local(k, x[base + i]);
+					base_of[i] = k * stride;
+					same = same && base_of[i] == base_of[0];
+					b1[i] = Details::num<Type>(0.0);
+					b2[i] = Details::num<Type>(0.0);
+				}
+				if (same) {
+					const Type* c = coefs.data() + base_of[0];
+					for (std::size_t j = max_deg; j > 0; --j) {
+						for (std::size_t i = 0; i < m; ++i) {
+							const Type b0 = c[j] + t2[i] * b1[i] - b2[i];
+							b2[i] = b1[i];
+							b1[i] = b0;
+						}
+					}
+				} else {
+					for (std::size_t j = max_deg; j > 0; --j) {
+						for (std::size_t i = 0; i < m; ++i) {
+							const Type b0 = coefs[base_of[i] + j] + t2[i] * b1[i] - b2[i];
+							b2[i] = b1[i];
+							b1[i] = b0;
+						}
+					}
+				}
+				for (std::size_t i = 0; i < m; ++i) {
+					out[base + i] = coefs[base_of[i]] + Details::num<Type>(0.5) * t2[i] * b1[i] - b2[i];
+				}
+			}
+		}
+
+		/** @brief evaluate every elements with threads */
+		void eval_batch(std::size_t n, const Type* x, Type* out, std::size_t threads) const
+		{
+			Details::parallel_for(n, 16 * BLOCK, threads,
+				[&](std::size_t begin, std::size_t end, std::size_t)
+				{
+					eval_batch(end - begin, x + begin, out + begin);
+				});
+		}
+
+		/** @return `double` estimate of the maximum error from the truncated coefficients */
+		double error(void) const noexcept { return err; }
+
+		/** @return `std::size_t` the number of pieces */
+		std::size_t pieces(void) const noexcept { return degrees.size(); }
+
+		/** @return `std::size_t` the maximum degree of the pieces */
+		std::size_t degree(void) const noexcept { return max_deg; }
+
+		/** @return `const auto&` break points of the pieces */
+		const std::vector<Type>& break_points(void) const noexcept { return breaks; }
+	};
+
+
+	/**
+	 * @brief approximate the formula on [a, b] by piecewise Chebyshev expansion
+	 *
+	 * @param formula  formula like "exp(-x) * sin(3*x)"
+	 * @param variable variable string
+	 * @param a, b     interval
+	 * @param tol      absolute tolerance
+	 * @param table    values of the other variables
+	 * @param option   limits of the approximation
+	 * @return `ChebyshevApproximation<Type>` evaluator of the approximation
+	 * @throw `std::invalid_argument` if the formula is invalid, or the interval is empty
+	 * @throw `std::runtime_error` if unknown variable is included in formula
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	ChebyshevApproximation<Type> approximate(const std::string& formula, const std::string& variable,
+	                                         const Type& a, const Type& b, double tol,
+	                                         const VariableTable<Type>& table = VariableTable<Type>(),
+	                                         const typename ChebyshevApproximation<Type>::Option& option = typename ChebyshevApproximation<Type>::Option())
+	{
+		return ChebyshevApproximation<Type>(formula, variable, a, b, tol, table, option);
+	}
+}
+
+#endif /* end of __SYAMFP_CHEBYSHEV_HPP__ */
@@ -0,0 +1,547 @@
+/**
+ * @file syamfp_contour.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Implicit curves and contours of compiled formulas by marching squares on a quadtree
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_CONTOUR_HPP__
+#define __SYAMFP_CONTOUR_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/**
+		 * @brief closed interval [lo, hi] of real numbers
+		 *
+		 * The empty interval (the function is NaN everywhere) is [NaN, NaN]. The bounds are widened
+		 * by one ulp after each operation instead of directed rounding.
+		 */
+		struct Interval
+		{
+			double lo, hi;
+
+			bool empty(void) const { return std::isnan(lo); }
+			bool contains(double value) const { return lo <= value && value <= hi; }
+		};
+
+		namespace IntervalMath
+		{
+			constexpr double INF = std::numeric_limits<double>::infinity();
+			constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+			constexpr Interval WHOLE = { -INF, INF };
+			constexpr Interval EMPTY = { NaN, NaN };
+
+			inline Interval widen(Interval a)
+			{
+				if (a.empty())
+					return a;
+				return { std::nextafter(a.lo, -INF), std::nextafter(a.hi, INF) };
+			}
+
+			/** @brief image of a monotone function over the interval clipped to the domain [min, max] */
+			template <typename Fn>
+			Interval monotone(Interval a, Fn&& fn, bool increasing, double min = -INF, double max = INF)
+			{
+				if (a.empty() || a.hi < min || max < a.lo)
+					return EMPTY;
+				const double lo = fn(std::max(a.lo, min));
+				const double hi = fn(std::min(a.hi, max));
+				return increasing ? Interval{ lo, hi } : Interval{ hi, lo };
+			}
+
+			inline Interval add(Interval a, Interval b)
+			{
+				if (a.empty() || b.empty())
+					return EMPTY;
+				const double lo = a.lo + b.lo;
+				const double hi = a.hi + b.hi;
+				return { std::isnan(lo) ? -INF : lo, std::isnan(hi) ? INF : hi };
+			}
+
+			inline Interval neg(Interval a)
+			{
+				return { -a.hi, -a.lo };
+			}
+
+			inline Interval mul(Interval a, Interval b)
+			{
+				if (a.empty() || b.empty())
+					return EMPTY;
+				/* 0 * inf is taken as 0 */
+				auto product = [](double x, double y) { return (x == 0.0 || y == 0.0) ? 0.0 : x * y; };
+				const double p[4] = { product(a.lo, b.lo), product(a.lo, b.hi), product(a.hi, b.lo), product(a.hi, b.hi) };
+				return { *std::min_element(p, p + 4), *std::max_element(p, p + 4) };
+			}
+
+			inline Interval div(Interval a, Interval b)
+			{
+				if (a.empty() || b.empty())
+					return EMPTY;
+				if (b.contains(0.0))
+					return WHOLE;
+				return mul(a, { 1.0 / b.hi, 1.0 / b.lo });
+			}
+
+			inline Interval pow_int(Interval a, int n)
+			{
+				if (a.empty())
+					return EMPTY;
+				if (n < 0)
+					return div({ 1.0, 1.0 }, pow_int(a, -n));
+				if (n == 0)
+					return { 1.0, 1.0 };
+
+				const double lo = std::pow(a.lo, n);
+				const double hi = std::pow(a.hi, n);
+				if (n % 2 == 1)
+					return { lo, hi };
+				if (a.lo >= 0.0)
+					return { lo, hi };
+				if (a.hi <= 0.0)
+					return { hi, lo };
+				return { 0.0, std::max(lo, hi) };
+			}
+
+			inline Interval exp(Interval a) { return monotone(a, [](double x) { return std::exp(x); }, true); }
+			inline Interval log(Interval a) { return monotone(a, [](double x) { return std::log(x); }, true, 0.0); }
+
+			inline Interval pow(Interval a, Interval b)
+			{
+				if (a.empty() || b.empty())
+					return EMPTY;
+				if (a.lo <= 0.0)
+					return WHOLE;
+				return exp(mul(b, log(a)));
+			}
+
+			/** @return `bool` true if offset + 2 pi k is in the interval for some integer k */
+			inline bool hits(Interval a, double offset)
+			{
+				constexpr double TWO_PI = 2.0 * std::numbers::pi;
+				const double k = std::ceil((a.lo - offset) / TWO_PI);
+				return offset + TWO_PI * k <= a.hi;
+			}
+
+			inline Interval sin(Interval a)
+			{
+				constexpr double HALF_PI = 0.5 * std::numbers::pi;
+				if (a.empty())
+					return EMPTY;
+				if (!(a.hi - a.lo < 2.0 * std::numbers::pi))
+					return { -1.0, 1.0 };
+				double lo = std::min(std::sin(a.lo), std::sin(a.hi));
+				double hi = std::max(std::sin(a.lo), std::sin(a.hi));
+				if (hits(a,  HALF_PI))
+					hi = 1.0;
+				if (hits(a, -HALF_PI))
+					lo = -1.0;
+				return { lo, hi };
+			}
+
+			inline Interval cos(Interval a)
+			{
+				return sin(add(a, { 0.5 * std::numbers::pi, 0.5 * std::numbers::pi }));
+			}
+
+			inline Interval tan(Interval a)
+			{
+				if (a.empty())
+					return EMPTY;
+				/* poles at pi/2 + k pi */
+				if (!(a.hi - a.lo < std::numbers::pi) || hits(a, 0.5 * std::numbers::pi) || hits(a, -0.5 * std::numbers::pi))
+					return WHOLE;
+				return { std::tan(a.lo), std::tan(a.hi) };
+			}
+
+			inline Interval cosh(Interval a)
+			{
+				if (a.empty())
+					return EMPTY;
+				const double lo = std::cosh(a.lo);
+				const double hi = std::cosh(a.hi);
+				if (a.contains(0.0))
+					return { 1.0, std::max(lo, hi) };
+				return { std::min(lo, hi), std::max(lo, hi) };
+			}
+		}
+
+		/**
+		 * @brief bound of the program over a box of the free variables by interval arithmetic
+		 *
+		 * @param code   instructions of the program
+		 * @param params values of the parameters
+		 * @param vars   intervals of the free variables
+		 * @param reg    registers. `reg.size() >= register_num()`
+		 * @return `Interval` range which includes every value of the program in the box
+		 */
+		template <MathConcept Type>
+		Interval eval_interval(const std::vector<Instruction<Type>>& code, const std::vector<Type>& params,
+		                       const Interval* vars, std::vector<Interval>& reg)
+		{
+			using namespace IntervalMath;
+			for (const Instruction<Type>& inst : code) {
+				const bool operand = inst.code != OpCode::Call && !is_array(inst.code);  /* array operands are not registers */
+				const Interval a = (inst.arg_num > 0 && operand) ? reg[inst.src[0]] : EMPTY;
+				const Interval b = (inst.arg_num > 1 && operand) ? reg[inst.src[1]] : EMPTY;
+				Interval r;
+
+				switch (inst.code)
+				{
+				case OpCode::Load   : r = vars[inst.index]; break;
+				case OpCode::Param  : r = { static_cast<double>(params[inst.index]), static_cast<double>(params[inst.index]) }; break;
+				case OpCode::Const  : r = { static_cast<double>(inst.value), static_cast<double>(inst.value) }; break;
+				case OpCode::Add    : r = add(a, b); break;
+				case OpCode::Sub    : r = add(a, neg(b)); break;
+				case OpCode::Mul    : r = mul(a, b); break;
+				case OpCode::Div    : r = div(a, b); break;
+				case OpCode::Pow    : r = pow(a, b); break;
+				case OpCode::PowInt : r = pow_int(a, inst.index); break;
+				case OpCode::Sin    : r = sin(a); break;
+				case OpCode::Cos    : r = cos(a); break;
+				case OpCode::Tan    : r = tan(a); break;
+				case OpCode::Asin   : r = monotone(a, [](double x) { return std::asin(x); }, true, -1.0, 1.0); break;
+				case OpCode::Acos   : r = monotone(a, [](double x) { return std::acos(x); }, false, -1.0, 1.0); break;
+				case OpCode::Atan   : r = monotone(a, [](double x) { return std::atan(x); }, true); break;
+				case OpCode::Sinh   : r = monotone(a, [](double x) { return std::sinh(x); }, true); break;
+				case OpCode::Cosh   : r = cosh(a); break;
+				case OpCode::Tanh   : r = monotone(a, [](double x) { return std::tanh(x); }, true); break;
+				case OpCode::Asinh  : r = monotone(a, [](double x) { return std::asinh(x); }, true); break;
+				case OpCode::Acosh  : r = monotone(a, [](double x) { return std::acosh(x); }, true, 1.0); break;
+				case OpCode::Atanh  : r = monotone(a, [](double x) { return std::atanh(x); }, true, -1.0, 1.0); break;
+				case OpCode::Exp    : r = exp(a); break;
+				case OpCode::Log    : r = log(a); break;
+				case OpCode::Log10  : r = monotone(a, [](double x) { return std::log10(x); }, true, 0.0); break;
+				case OpCode::Sqrt   : r = monotone(a, [](double x) { return std::sqrt(x); }, true, 0.0); break;
+				case OpCode::RandU  : r = { 0.0, 1.0 }; break;
+				default             : r = WHOLE; break;  /* random numbers, custom functions, data tables and arrays */
+				}
+				reg[inst.dst] = widen(r);
+			}
+			return reg[0];
+		}
+	}
+
+
+	/**
+	 * @brief contours f(x, y) = level of a formula of two variables on a rectangle
+	 *
+	 * The rectangle is divided as a quadtree. In each depth, the range of f over every cell is bounded by
+	 * interval arithmetic in parallel, and the cells which cannot include any level are culled. The corners
+	 * of the cells left at the finest depth are evaluated by one threaded batch evaluation, and marching
+	 * squares makes the segments, which are joined into polylines through the shared edges.
+	 *
+	 * @note features smaller than a cell of the finest depth can be missed, as with a uniform grid.
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	class ContourExtractor
+	{
+	public:
+		struct Option
+		{
+			std::size_t depth   = 9;  /* the finest grid has 2^depth x 2^depth cells */
+			std::size_t threads = 0;  /* 0 means the number of hardware threads */
+		};
+
+		struct Point
+		{
+			double x, y;
+		};
+
+		struct Polyline
+		{
+			double             level;
+			std::vector<Point> points;
+			bool               closed = false;  /* the last point connects to the first one */
+		};
+
+		struct Result
+		{
+			std::vector<Polyline> lines;
+			std::size_t           evaluations = 0;  /* corners evaluated */
+			std::size_t           cells       = 0;  /* cells of the finest depth not culled */
+		};
+
+	private:
+		struct Cell
+		{
+			std::uint32_t i, j;  /* position in the grid of the depth */
+		};
+
+		Program<Type> program;
+
+		/** @brief bound every cell of the depth, and keep the cells whose bound includes a level */
+		void cull(std::vector<Cell>& cells, std::size_t depth, const std::array<double, 4>& box,
+		          const std::vector<double>& levels, std::size_t threads) const
+		{
+			const double n  = static_cast<double>(std::uint64_t(1) << depth);
+			const double wx = (box[1] - box[0]) / n;
+			const double wy = (box[3] - box[2]) / n;
+
+			std::vector<char> keep(cells.size());
+			std::vector<std::vector<Details::Interval>> regs(Details::ret_thread_num(threads),
+				std::vector<Details::Interval>(program.register_num() + 1));
+			Details::parallel_for(cells.size(), 64, regs.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					for (std::size_t k = begin; k < end; ++k) {
+						const Details::Interval vars[2] = {
+							{ box[0] + wx * cells[k].i, box[0] + wx * (cells[k].i + 1) },
+							{ box[2] + wy * cells[k].j, box[2] + wy * (cells[k].j + 1) },
+						};
+						const Details::Interval bound = Details::eval_interval(program.instructions(), program.parameters(), vars, regs[worker]);
+						keep[k] = std::any_of(levels.begin(), levels.end(), [&](double level) { return bound.contains(level); });
+					}
+				});
+
+			std::size_t size = 0;
+			for (std::size_t k = 0; k < cells.size(); ++k) {
+				if (keep[k])
+					cells[size++] = cells[k];
+			}
+			cells.resize(size);
+		}
+
+		/** @brief join the segments between edges into polylines */
+		static void join(const std::vector<std::array<std::uint64_t, 2>>& segments,
+		                 const std::unordered_map<std::uint64_t, Point>& crossings, double level, std::vector<Polyline>& lines)
+		{
+			/* each edge is shared by at most two segments */
+			std::unordered_map<std::uint64_t, std::array<std::size_t, 2>> owners;
+			constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+			for (std::size_t s = 0; s < segments.size(); ++s) {
+				for (std::uint64_t edge : segments[s]) {
+					auto [it, inserted] = owners.try_emplace(edge, std::array<std::size_t, 2>{ NONE, NONE });
+					it->second[inserted ? 0 : 1] = s;
+				}
+			}
+
+			std::vector<char> used(segments.size(), 0);
+			auto walk = [&](std::size_t s, std::uint64_t edge)
+			{
+				Polyline line{ level, { crossings.at(edge) }, false };
+				while (s != NONE && !used[s]) {
+					used[s] = 1;
+					edge = (segments[s][0] == edge) ? segments[s][1] : segments[s][0];
+					line.points.push_back(crossings.at(edge));
+
+					const std::array<std::size_t, 2>& next = owners.at(edge);
+					s = (next[0] == s) ? next[1] : next[0];
+				}
+				if (line.points.size() > 2 && s != NONE) {
+					line.closed = true;
+					line.points.pop_back();  /* the first point is repeated */
+				}
+				lines.push_back(std::move(line));
+			};
+
+			/* open lines start from the edges with one segment, and closed lines from the rest */
+			for (std::size_t s = 0; s < segments.size(); ++s) {
+				for (std::uint64_t edge : segments[s]) {
+					if (!used[s] && owners.at(edge)[1] == NONE)
+						walk(s, edge);
+				}
+			}
+			for (std::size_t s = 0; s < segments.size(); ++s) {
+				if (!used[s])
+					walk(s, segments[s][0]);
+			}
+		}
+
+	public:
+		/**
+		 * @param program program with two free variables (x, y)
+		 * @throw `std::invalid_argument` if the program does not have two free variables
+		 */
+		ContourExtractor(const Program<Type>& program)
+			: program(program)
+		{
+			if (program.variable_num() != 2) {
+				throw std::invalid_argument("ContourExtractor: program must have two variables");
+			}
+		}
+
+		/**
+		 * @brief compile the function
+		 *
+		 * @param formula formula like "x^2 + y^2 - 1"
+		 * @param x, y    variable strings of the axes
+		 * @param table   values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		ContourExtractor(const std::string& formula, const std::string& x, const std::string& y,
+		                 const VariableTable<Type>& table = VariableTable<Type>())
+		{
+			program = Syamfp<Type>::compile(formula, {x, y}, table);
+		}
+
+		~ContourExtractor() = default;
+
+		/**
+		 * @brief extract the contours of the levels on [x0, x1] x [y0, y1]
+		 *
+		 * @param x0, x1, y0, y1 rectangle
+		 * @param levels         values of the contours. `{ 0.0 }` gives the implicit curve f(x, y) = 0
+		 * @param option         depth of the quadtree and threads
+		 * @return `Result` polylines of all levels
+		 */
+		Result extract(double x0, double x1, double y0, double y1,
+		               const std::vector<double>& levels = { 0.0 }, const Option& option = Option()) const
+		{
+			Result result;
+			const std::array<double, 4> box = { x0, x1, y0, y1 };
+			const std::size_t depth = std::min<std::size_t>(option.depth, 20);
+
+			/* quadtree */
+			std::vector<Cell> cells = { { 0, 0 } }, children;
+			for (std::size_t d = 0; ; ++d) {
+				cull(cells, d, box, levels, option.threads);
+				if (d == depth || cells.empty())
+					break;
+
+				children.clear();
+				for (const Cell& cell : cells) {
+					children.push_back({ 2 * cell.i,     2 * cell.j });
+					children.push_back({ 2 * cell.i + 1, 2 * cell.j });
+					children.push_back({ 2 * cell.i,     2 * cell.j + 1 });
+					children.push_back({ 2 * cell.i + 1, 2 * cell.j + 1 });
+				}
+				cells.swap(children);
+			}
+			result.cells = cells.size();
+
+			/* corners of the cells, each of which is evaluated once */
+			const std::uint64_t n = std::uint64_t(1) << depth;
+			auto corner = [&](std::uint64_t i, std::uint64_t j) { return j * (n + 1) + i; };
+			std::unordered_map<std::uint64_t, std::size_t> index;
+			std::vector<Type> xs, ys, fs;
+			for (const Cell& cell : cells) {
+				for (std::uint64_t dj = 0; dj < 2; ++dj) {
+					for (std::uint64_t di = 0; di < 2; ++di) {
+						const std::uint64_t key = corner(cell.i + di, cell.j + dj);
+						if (index.try_emplace(key, xs.size()).second) {
+							xs.push_back(Details::num<Type>(x0 + (x1 - x0) * static_cast<double>(cell.i + di) / static_cast<double>(n)));
+							ys.push_back(Details::num<Type>(y0 + (y1 - y0) * static_cast<double>(cell.j + dj) / static_cast<double>(n)));
+						}
+					}
+				}
+			}
+			const Type* columns[2] = { xs.data(), ys.data() };
+			fs.resize(xs.size());
+			program.eval_batch(xs.size(), columns, fs.data(), option.threads);
+			result.evaluations = xs.size();
+
+			/* marching squares: corners 0 (i, j), 1 (i + 1, j), 2 (i + 1, j + 1), 3 (i, j + 1),
+			 * and edges 0 (0-1), 1 (1-2), 2 (3-2), 3 (0-3). an edge id is 2 * corner id (+1 if vertical) */
+			for (double level : levels) {
+				std::vector<std::array<std::uint64_t, 2>> segments;
+				std::unordered_map<std::uint64_t, Point> crossings;
+
+				for (const Cell& cell : cells) {
+					const std::array<std::uint64_t, 4> id = {
+						corner(cell.i, cell.j), corner(cell.i + 1, cell.j), corner(cell.i + 1, cell.j + 1), corner(cell.i, cell.j + 1),
+					};
+					std::array<double, 4> v;
+					bool finite = true;
+					for (int k = 0; k < 4; ++k) {
+						v[k] = static_cast<double>(fs[index.at(id[k])]);
+						finite = finite && std::isfinite(v[k]);
+					}
+					if (!finite)
+						continue;
+
+					const std::array<std::array<int, 2>, 4> ends = {{ { 0, 1 }, { 1, 2 }, { 3, 2 }, { 0, 3 } }};
+					const std::array<std::uint64_t, 4> edge = { 2 * id[0], 2 * id[1] + 1, 2 * id[3], 2 * id[0] + 1 };
+					std::array<bool, 4> above;
+					for (int k = 0; k < 4; ++k) {
+						above[k] = v[k] > level;
+					}
+
+					int crossed = 0;
+					for (int e = 0; e < 4; ++e) {
+						const int a = ends[e][0], b = ends[e][1];
+						if (above[a] == above[b])
+							continue;
+						crossed++;
+						if (crossings.count(edge[e]))
+							continue;
+						const double t  = (level - v[a]) / (v[b] - v[a]);
+						const double xa = static_cast<double>(xs[index.at(id[a])]), ya = static_cast<double>(ys[index.at(id[a])]);
+						const double xb = static_cast<double>(xs[index.at(id[b])]), yb = static_cast<double>(ys[index.at(id[b])]);
+						crossings.emplace(edge[e], Point{ xa + t * (xb - xa), ya + t * (yb - ya) });
+					}
+
+					if (crossed == 2) {
+						std::array<std::uint64_t, 2> seg;
+						int m = 0;
+						for (int e = 0; e < 4; ++e) {
+							if (above[ends[e][0]] != above[ends[e][1]])
+								seg[m++] = edge[e];
+						}
+						segments.push_back(seg);
+					} else if (crossed == 4) {
+						/* saddle: the corners on the other side of the center are cut off */
+						const bool center = 0.25 * (v[0] + v[1] + v[2] + v[3]) > level;
+						constexpr std::array<std::array<int, 2>, 4> CUT = {{ { 3, 0 }, { 0, 1 }, { 1, 2 }, { 2, 3 } }};
+						for (int k = 0; k < 4; ++k) {
+							if (above[k] != center)
+								segments.push_back({ edge[CUT[k][0]], edge[CUT[k][1]] });
+						}
+					}
+				}
+
+				join(segments, crossings, level, result.lines);
+			}
+
+			return result;
+		}
+	};
+
+
+	/**
+	 * @brief extract the contours of the formula on [x0, x1] x [y0, y1]
+	 *
+	 * @param formula        formula like "x^2 + y^2 - 1"
+	 * @param x, y           variable strings of the axes
+	 * @param x0, x1, y0, y1 rectangle
+	 * @param levels         values of the contours
+	 * @param table          values of the other variables
+	 * @param option         depth of the quadtree and threads
+	 * @return `ContourExtractor<Type>::Result` polylines of all levels
+	 * @throw `std::invalid_argument` if the formula is invalid
+	 * @throw `std::runtime_error` if unknown variable is included in formula
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	typename ContourExtractor<Type>::Result extract_contours(const std::string& formula, const std::string& x, const std::string& y,
+	                                                         double x0, double x1, double y0, double y1,
+	                                                         const std::vector<double>& levels = { 0.0 },
+	                                                         const VariableTable<Type>& table = VariableTable<Type>(),
+	                                                         const typename ContourExtractor<Type>::Option& option = typename ContourExtractor<Type>::Option())
+	{
+		return ContourExtractor<Type>(formula, x, y, table).extract(x0, x1, y0, y1, levels, option);
+	}
+}
+
+#endif /* end of __SYAMFP_CONTOUR_HPP__ */
@@ -0,0 +1,279 @@
+/**
+ * @file syamfp_curve.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Adaptive sampling of curves y = f(x) for plotting
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_CURVE_HPP__
+#define __SYAMFP_CURVE_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	/**
+	 * @brief adaptive sampler of a curve y = f(x) on [a, b] for a plot of given size in pixels
+	 *
+	 * The interval is split into a coarse uniform grid, and the midpoints of all segments not resolved yet
+	 * are evaluated by one batch evaluation in each level. A segment is resolved when its midpoint is within
+	 * the tolerance of the chord in pixels, and a steep segment also needs to be split evenly by its midpoint
+	 * as a continuous curve is. The segments where a finite value and NaN meet are refined
+	 * to locate the boundary, and a segment that is not resolved at the minimum width is a discontinuity.
+	 *
+	 * The curve is returned as a polyline. A point with NaN y breaks the line at discontinuities and
+	 * where the value is not finite.
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	class CurveSampler
+	{
+	public:
+		struct Option
+		{
+			std::size_t width     = 1024;   /* size of the plot in pixels */
+			std::size_t height    = 768;
+			double      ymin      = 0.0;    /* range of y of the plot. ymin >= ymax means the range of the coarse samples */
+			double      ymax      = 0.0;
+			double      tolerance = 0.25;   /* distance from the chord in pixels */
+			double      min_step  = 0.125;  /* the minimum width of segments in pixels */
+			std::size_t initial   = 64;     /* the number of segments of the coarse grid */
+			std::size_t threads   = 0;      /* 0 means the number of hardware threads */
+		};
+
+		struct Point
+		{
+			double x, y;
+		};
+
+		struct Result
+		{
+			std::vector<Point> points;  /* polyline in ascending order of x */
+			std::size_t        evaluations = 0;
+		};
+
+	private:
+		struct Segment
+		{
+			double x0, x1;
+			double y0, y1;
+		};
+
+		Program<Type> program;
+
+		static double value(const Type& y)
+		{
+			const double v = static_cast<double>(y);
+			return std::isfinite(v) ? v : std::numeric_limits<double>::quiet_NaN();
+		}
+
+		void evaluate(const std::vector<double>& xs, std::vector<double>& ys, std::size_t threads) const
+		{
+			std::vector<Type> in(xs.size()), out(xs.size());
+			for (std::size_t i = 0; i < xs.size(); ++i) {
+				in[i] = Details::num<Type>(xs[i]);
+			}
+			const Type* columns[1] = { in.data() };
+			program.eval_batch(in.size(), columns, out.data(), threads);
+
+			ys.resize(xs.size());
+			for (std::size_t i = 0; i < xs.size(); ++i) {
+				ys[i] = value(out[i]);
+			}
+		}
+
+	public:
+		/**
+		 * @param program program with one free variable
+		 * @throw `std::invalid_argument` if the program does not have one free variable
+		 */
+		CurveSampler(const Program<Type>& program)
+			: program(program)
+		{
+			if (program.variable_num() != 1) {
+				throw std::invalid_argument("CurveSampler: program must have one variable");
+			}
+		}
+
+		/**
+		 * @brief compile the curve
+		 *
+		 * @param formula  formula like "sin(x)/x"
+		 * @param variable variable string
+		 * @param table    values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		CurveSampler(const std::string& formula, const std::string& variable,
+		             const VariableTable<Type>& table = VariableTable<Type>())
+		{
+			program = Syamfp<Type>::compile(formula, {variable}, table);
+		}
+
+		~CurveSampler() = default;
+
+		/**
+		 * @brief sample the curve on [a, b]
+		 *
+		 * @param a, b   range of x of the plot
+		 * @param option size of the plot and tolerance
+		 * @return `Result` polyline and the number of evaluations
+		 */
+		Result sample(double a, double b, const Option& option = Option()) const
+		{
+			constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+			Result result;
+			if (!(a < b))
+				return result;
+
+			/* coarse grid */
+			const std::size_t initial = std::max<std::size_t>(option.initial, 1);
+			std::vector<double> xs(initial + 1), ys;
+			for (std::size_t i = 0; i <= initial; ++i) {
+				xs[i] = a + (b - a) * static_cast<double>(i) / static_cast<double>(initial);
+			}
+			xs[initial] = b;
+			evaluate(xs, ys, option.threads);
+			result.evaluations += xs.size();
+
+			double ymin = option.ymin, ymax = option.ymax;
+			if (!(ymin < ymax)) {
+				ymin =  std::numeric_limits<double>::infinity();
+				ymax = -std::numeric_limits<double>::infinity();
+				for (double y : ys) {
+					if (!std::isnan(y)) {
+						ymin = std::min(ymin, y);
+						ymax = std::max(ymax, y);
+					}
+				}
+				if (!(ymin < ymax)) {
+					ymin -= 1.0;
+					ymax += 1.0;
+				}
+			}
+
+			/* pixels per unit */
+			const double sx = static_cast<double>(std::max<std::size_t>(option.width, 1))  / (b - a);
+			const double sy = static_cast<double>(std::max<std::size_t>(option.height, 1)) / (ymax - ymin);
+			const double min_width = option.min_step / sx;
+
+			std::vector<Segment> pending, next;
+			for (std::size_t i = 0; i < initial; ++i) {
+				pending.push_back({ xs[i], xs[i + 1], ys[i], ys[i + 1] });
+			}
+
+			/* each resolved segment adds its midpoint and right end, and the points are sorted at last */
+			std::vector<Point>& points = result.points;
+			points.push_back({ xs[0], ys[0] });
+			while (!pending.empty()) {
+				xs.clear();
+				for (const Segment& seg : pending) {
+					xs.push_back(0.5 * (seg.x0 + seg.x1));
+				}
+				evaluate(xs, ys, option.threads);
+				result.evaluations += xs.size();
+
+				next.clear();
+				for (std::size_t i = 0; i < pending.size(); ++i) {
+					const Segment& seg = pending[i];
+					const double xm = xs[i];
+					const double ym = ys[i];
+					const int nans = std::isnan(seg.y0) + std::isnan(ym) + std::isnan(seg.y1);
+
+					bool resolved;
+					if (nans == 3) {
+						resolved = true;
+					} else if (nans > 0) {
+						resolved = false;  /* boundary of the domain */
+					} else {
+						/* distance of the midpoint from the chord in pixels */
+						const double dx = (seg.x1 - seg.x0) * sx;
+						const double dy = (seg.y1 - seg.y0) * sy;
+						const double cross = std::abs(dx * (ym - seg.y0) * sy - dy * (xm - seg.x0) * sx);
+						resolved = cross <= option.tolerance * std::hypot(dx, dy);
+
+						/* a steep chord is near vertical, and a jump is found by the uneven halves of it */
+						if (std::abs(dy) > std::max(dx, option.tolerance)) {
+							const double half = std::max(std::abs(ym - seg.y0), std::abs(seg.y1 - ym));
+							resolved = resolved && half <= 0.75 * std::abs(seg.y1 - seg.y0);
+						}
+					}
+
+					if (!resolved && seg.x1 - seg.x0 > min_width) {
+						next.push_back({ seg.x0, xm, seg.y0, ym });
+						next.push_back({ xm, seg.x1, ym, seg.y1 });
+						continue;
+					}
+
+					if (!resolved && nans == 0) {
+						/* discontinuity: break the line in the half with the larger jump */
+						if (std::abs(ym - seg.y0) > std::abs(seg.y1 - ym)) {
+							points.push_back({ 0.5 * (seg.x0 + xm), NaN });
+							points.push_back({ xm, ym });
+						} else {
+							points.push_back({ xm, ym });
+							points.push_back({ 0.5 * (xm + seg.x1), NaN });
+						}
+					} else {
+						points.push_back({ xm, ym });
+					}
+					points.push_back({ seg.x1, seg.y1 });
+				}
+				pending.swap(next);
+			}
+
+			std::sort(points.begin(), points.end(),
+				[](const Point& p, const Point& q) { return p.x < q.x; });
+
+			/* one NaN is enough for each break, and none at the ends */
+			std::size_t size = 0;
+			for (std::size_t i = 0; i < points.size(); ++i) {
+				if (std::isnan(points[i].y) && (size == 0 || std::isnan(points[size - 1].y)))
+					continue;
+				points[size++] = points[i];
+			}
+			if (size > 0 && std::isnan(points[size - 1].y))
+				size--;
+			points.resize(size);
+
+			return result;
+		}
+	};
+
+
+	/**
+	 * @brief sample the curve y = f(x) on [a, b] for plotting
+	 *
+	 * @param formula  formula like "sin(x)/x"
+	 * @param variable variable string
+	 * @param a, b     range of x of the plot
+	 * @param table    values of the other variables
+	 * @param option   size of the plot and tolerance
+	 * @return `CurveSampler<Type>::Result` polyline and the number of evaluations
+	 * @throw `std::invalid_argument` if the formula is invalid
+	 * @throw `std::runtime_error` if unknown variable is included in formula
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	typename CurveSampler<Type>::Result sample_curve(const std::string& formula, const std::string& variable,
+	                                                 double a, double b,
+	                                                 const VariableTable<Type>& table = VariableTable<Type>(),
+	                                                 const typename CurveSampler<Type>::Option& option = typename CurveSampler<Type>::Option())
+	{
+		return CurveSampler<Type>(formula, variable, table).sample(a, b, option);
+	}
+}
+
+#endif /* end of __SYAMFP_CURVE_HPP__ */
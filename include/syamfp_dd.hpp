@@ -0,0 +1,680 @@
+/**
+ * @file syamfp_dd.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Double-double (about 106 bits) real and complex number satisfying MathConcept
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_DD_HPP__
+#define __SYAMFP_DD_HPP__
+
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <ostream>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @brief s + e = a + b exactly */
+		inline void two_sum(double a, double b, double& s, double& e)
+		{
+			s = a + b;
+			double bb = s - a;
+			e = (a - (s - bb)) + (b - bb);
+		}
+
+		/** @brief s + e = a + b exactly if |a| >= |b| */
+		inline void quick_two_sum(double a, double b, double& s, double& e)
+		{
+			s = a + b;
+			e = b - (s - a);
+		}
+
+		/** @brief p + e = a * b exactly */
+		inline void two_prod(double a, double b, double& p, double& e)
+		{
+			p = a * b;
+			e = std::fma(a, b, -p);
+		}
+	}
+
+
+	/**
+	 * @brief double-double real number: the value is `hi + lo` where |lo| <= ulp(hi) / 2
+	 * @note  arithmetic is implemented by error-free transformations, so that it is about 106 bits precision.
+	 */
+	struct dd_real
+	{
+		double hi;
+		double lo;
+
+		constexpr dd_real() : hi(0.0), lo(0.0) {}
+		constexpr dd_real(double hi) : hi(hi), lo(0.0) {}
+		constexpr dd_real(int hi) : hi(static_cast<double>(hi)), lo(0.0) {}
+		constexpr dd_real(double hi, double lo) : hi(hi), lo(lo) {}
+
+		explicit constexpr operator double() const { return hi; }
+
+		dd_real operator-() const { return dd_real(-hi, -lo); }
+
+		dd_real& operator+=(const dd_real& b);
+		dd_real& operator-=(const dd_real& b);
+		dd_real& operator*=(const dd_real& b);
+		dd_real& operator/=(const dd_real& b);
+	};
+
+	namespace Details
+	{
+		constexpr dd_real DD_PI     = dd_real(3.141592653589793116e+00, 1.224646799147353207e-16);
+		constexpr dd_real DD_PI_2   = dd_real(1.570796326794896558e+00, 6.123233995736766036e-17);
+		constexpr dd_real DD_LN2    = dd_real(6.931471805599452862e-01, 2.319046813846299558e-17);
+		constexpr dd_real DD_LN10   = dd_real(2.302585092994045901e+00, -2.170756223382249351e-16);
+		constexpr double  DD_EPS    = 4.93038065763132e-32; /* 2^-104 */
+		constexpr double  DD_LOG_MAX = 7.09782712893383973e+02; /* log of the largest double */
+		constexpr int     DD_POW_INT_MAX = 64;
+	}
+
+	inline dd_real operator+(const dd_real& a, const dd_real& b)
+	{
+		double s, e, t, f;
+		Details::two_sum(a.hi, b.hi, s, e);
+		Details::two_sum(a.lo, b.lo, t, f);
+		e += t;
+		Details::quick_two_sum(s, e, s, e);
+		e += f;
+		Details::quick_two_sum(s, e, s, e);
+		return dd_real(s, e);
+	}
+
+	inline dd_real operator+(const dd_real& a, double b)
+	{
+		double s, e;
+		Details::two_sum(a.hi, b, s, e);
+		e += a.lo;
+		Details::quick_two_sum(s, e, s, e);
+		return dd_real(s, e);
+	}
+
+	inline dd_real operator+(double a, const dd_real& b) { return b + a; }
+
+	inline dd_real operator-(const dd_real& a, const dd_real& b) { return a + (-b); }
+	inline dd_real operator-(const dd_real& a, double b)         { return a + (-b); }
+	inline dd_real operator-(double a, const dd_real& b)         { return (-b) + a; }
+
+	inline dd_real operator*(const dd_real& a, const dd_real& b)
+	{
+		double p, e;
+		Details::two_prod(a.hi, b.hi, p, e);
+		e += a.hi * b.lo + a.lo * b.hi;
+		Details::quick_two_sum(p, e, p, e);
+		return dd_real(p, e);
+	}
+
+	inline dd_real operator*(const dd_real& a, double b)
+	{
+		double p, e;
+		Details::two_prod(a.hi, b, p, e);
+		e += a.lo * b;
+		Details::quick_two_sum(p, e, p, e);
+		return dd_real(p, e);
+	}
+
+	inline dd_real operator*(double a, const dd_real& b) { return b * a; }
+
+	inline dd_real operator/(const dd_real& a, const dd_real& b)
+	{
+		/* long division with three quotient digits. the remainder of inf or NaN is NaN */
+		double q1 = a.hi / b.hi;
+		if (!std::isfinite(q1) || !std::isfinite(b.hi))
+			return dd_real(q1);
+		dd_real r = a - b * q1;
+		double q2 = r.hi / b.hi;
+		r = r - b * q2;
+		double q3 = r.hi / b.hi;
+
+		double s, e;
+		Details::quick_two_sum(q1, q2, s, e);
+		return dd_real(s, e) + q3;
+	}
+
+	inline dd_real operator/(const dd_real& a, double b)
+	{
+		double q1 = a.hi / b;
+		if (!std::isfinite(q1) || !std::isfinite(b))
+			return dd_real(q1);
+		double p, e;
+		Details::two_prod(q1, b, p, e);
+		double s, f;
+		Details::two_sum(a.hi, -p, s, f);
+		f -= e;
+		f += a.lo;
+		double q2 = (s + f) / b;
+		Details::quick_two_sum(q1, q2, s, e);
+		return dd_real(s, e);
+	}
+
+	inline dd_real operator/(double a, const dd_real& b) { return dd_real(a) / b; }
+
+	inline dd_real& dd_real::operator+=(const dd_real& b) { return *this = *this + b; }
+	inline dd_real& dd_real::operator-=(const dd_real& b) { return *this = *this - b; }
+	inline dd_real& dd_real::operator*=(const dd_real& b) { return *this = *this * b; }
+	inline dd_real& dd_real::operator/=(const dd_real& b) { return *this = *this / b; }
+
+	inline bool operator==(const dd_real& a, const dd_real& b) { return a.hi == b.hi && a.lo == b.lo; }
+	inline bool operator!=(const dd_real& a, const dd_real& b) { return !(a == b); }
+	inline bool operator< (const dd_real& a, const dd_real& b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+	inline bool operator> (const dd_real& a, const dd_real& b) { return b < a; }
+	inline bool operator<=(const dd_real& a, const dd_real& b) { return !(b < a); }
+	inline bool operator>=(const dd_real& a, const dd_real& b) { return !(a < b); }
+
+	inline std::ostream& operator<<(std::ostream& os, const dd_real& a)
+	{
+		return os << a.hi;
+	}
+
+	/* -------------------------------------------------------------------------------- */
+	/*  functions of dd_real                                                             */
+	/* -------------------------------------------------------------------------------- */
+
+	inline dd_real abs(const dd_real& a)  { return (a.hi < 0.0) ? -a : a; }
+	inline dd_real fabs(const dd_real& a) { return abs(a); }
+	inline bool isfinite(const dd_real& a) { return std::isfinite(a.hi); }
+	inline dd_real ldexp(const dd_real& a, int exp) { return dd_real(std::ldexp(a.hi, exp), std::ldexp(a.lo, exp)); }
+
+	/** @return `dd_real` the nearest integer */
+	inline dd_real nint(const dd_real& a)
+	{
+		double hi = std::nearbyint(a.hi);
+		if (hi == a.hi) {
+			double lo = std::nearbyint(a.lo);
+			Details::quick_two_sum(hi, lo, hi, lo);
+			return dd_real(hi, lo);
+		}
+		if (std::abs(hi - a.hi) == 0.5 && a.lo < 0.0)
+			hi -= 1.0;
+		return dd_real(hi);
+	}
+
+	inline dd_real sqrt(const dd_real& a)
+	{
+		if (a.hi <= 0.0)
+			return (a.hi == 0.0) ? dd_real() : dd_real(std::numeric_limits<double>::quiet_NaN());
+
+		/* one Newton step from double precision: x' = ax + (a - ax^2) * x / 2 */
+		double x  = 1.0 / std::sqrt(a.hi);
+		double ax = a.hi * x;
+		return dd_real(ax) + (a - dd_real(ax) * ax).hi * (x * 0.5);
+	}
+
+	inline dd_real exp(const dd_real& a)
+	{
+		if (a.hi > Details::DD_LOG_MAX)
+			return dd_real(std::numeric_limits<double>::infinity());
+		if (a.hi < -745.0)
+			return dd_real();
+		if (a.hi == 0.0)
+			return dd_real(1.0);
+
+		/* exp(a) = 2^k * exp(r)^512, |r| <= ln2 / 1024 */
+		const double k = std::nearbyint(a.hi / Details::DD_LN2.hi);
+		const dd_real r = ldexp(a - Details::DD_LN2 * k, -9);
+
+		/* s = exp(r) - 1 by Taylor series */
+		dd_real s    = r;
+		dd_real term = r;
+		for (int n = 2; n < 20; ++n) {
+			term = term * r / static_cast<double>(n);
+			s += term;
+			if (std::abs(term.hi) < Details::DD_EPS * std::abs(s.hi))
+				break;
+		}
+
+		/* (1 + s)^2 - 1 = 2s + s^2 */
+		for (int n = 0; n < 9; ++n) {
+			s = ldexp(s, 1) + s * s;
+		}
+		return ldexp(s + 1.0, static_cast<int>(k));
+	}
+
+	namespace Details
+	{
+		/** @brief atanh of |a| <= 0.06 by Taylor series */
+		inline dd_real atanh_taylor(const dd_real& a)
+		{
+			const dd_real a2 = a * a;
+			dd_real s     = a;
+			dd_real power = a;
+			for (int n = 1; n < 40; ++n) {
+				power = power * a2;
+				const dd_real term = power / static_cast<double>(2 * n + 1);
+				s += term;
+				if (std::abs(term.hi) < DD_EPS * std::abs(s.hi))
+					break;
+			}
+			return s;
+		}
+	}
+
+	inline dd_real log(const dd_real& a)
+	{
+		if (a.hi <= 0.0)
+			return dd_real((a.hi == 0.0) ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN());
+		if (!std::isfinite(a.hi))
+			return a;
+		if (a.hi == 1.0 && a.lo == 0.0)
+			return dd_real();
+		/* the Newton step below is accurate only in absolute error: log(a) = 2 atanh((a - 1) / (a + 1)) */
+		if (std::abs(a.hi - 1.0) < 0.1)
+			return ldexp(Details::atanh_taylor((a - 1.0) / (a + 1.0)), 1);
+
+		/* a = 2^k m, so that exp(-x) is not subnormal: log(a) = k log(2) + log(m) */
+		int k;
+		std::frexp(a.hi, &k);
+		const dd_real m = ldexp(a, -k);
+
+		/* one Newton step of exp(x) = m: x' = x + m * exp(-x) - 1 */
+		dd_real x = std::log(m.hi);
+		return x + m * exp(-x) - 1.0 + Details::DD_LN2 * static_cast<double>(k);
+	}
+
+	inline dd_real log10(const dd_real& a) { return log(a) / Details::DD_LN10; }
+
+	namespace Details
+	{
+		/** @brief log(1 + a) without cancellation for small |a| */
+		inline dd_real log1p(const dd_real& a)
+		{
+			if (std::abs(a.hi) > 0.1)
+				return log(1.0 + a);
+			/* log(1 + a) = 2 atanh(a / (2 + a)) */
+			return ldexp(atanh_taylor(a / (2.0 + a)), 1);
+		}
+	}
+
+	namespace Details
+	{
+		/** @brief sin and cos of |a| <= pi/4 by Taylor series */
+		inline void sincos_taylor(const dd_real& a, dd_real& s, dd_real& c)
+		{
+			const dd_real a2 = a * a;
+
+			s = a;
+			dd_real term = a;
+			for (int n = 1; n < 20; ++n) {
+				term = -term * a2 / static_cast<double>((2 * n) * (2 * n + 1));
+				s += term;
+				if (std::abs(term.hi) < DD_EPS * std::abs(s.hi))
+					break;
+			}
+
+			c = dd_real(1.0);
+			term = dd_real(1.0);
+			for (int n = 1; n < 20; ++n) {
+				term = -term * a2 / static_cast<double>((2 * n - 1) * (2 * n));
+				c += term;
+				if (std::abs(term.hi) < DD_EPS)
+					break;
+			}
+		}
+
+		/** @brief sin and cos of any argument */
+		inline void sincos(const dd_real& a, dd_real& s, dd_real& c)
+		{
+			const dd_real j = nint(a / DD_PI_2);
+			const dd_real t = a - DD_PI_2 * j;
+
+			dd_real st, ct;
+			sincos_taylor(t, st, ct);
+
+			switch (static_cast<int>(std::fmod(j.hi, 4.0) + 4.0) % 4)
+			{
+			case 0 : s =  st; c =  ct; break;
+			case 1 : s =  ct; c = -st; break;
+			case 2 : s = -st; c = -ct; break;
+			default: s = -ct; c =  st; break;
+			}
+		}
+	}
+
+	inline dd_real sin(const dd_real& a) { dd_real s, c; Details::sincos(a, s, c); return s; }
+	inline dd_real cos(const dd_real& a) { dd_real s, c; Details::sincos(a, s, c); return c; }
+	inline dd_real tan(const dd_real& a) { dd_real s, c; Details::sincos(a, s, c); return s / c; }
+
+	inline dd_real atan2(const dd_real& y, const dd_real& x)
+	{
+		if (x.hi == 0.0 && y.hi == 0.0)
+			return dd_real();
+
+		/* one Newton step from double precision */
+		const dd_real r  = sqrt(x * x + y * y);
+		const dd_real xx = x / r;
+		const dd_real yy = y / r;
+		dd_real z = std::atan2(y.hi, x.hi);
+		dd_real s, c;
+		Details::sincos(z, s, c);
+
+		if (std::abs(xx.hi) > std::abs(yy.hi)) {
+			z += (yy - s) / c;
+		} else {
+			z -= (xx - c) / s;
+		}
+		return z;
+	}
+
+	inline dd_real atan(const dd_real& a) { return atan2(a, dd_real(1.0)); }
+	inline dd_real asin(const dd_real& a) { return atan2(a, sqrt((1.0 - a) * (1.0 + a))); }
+	inline dd_real acos(const dd_real& a) { return atan2(sqrt((1.0 - a) * (1.0 + a)), a); }
+
+	inline dd_real sinh(const dd_real& a)
+	{
+		if (std::abs(a.hi) > 40.0) {
+			const dd_real e = exp(abs(a) - Details::DD_LN2);
+			return (a.hi < 0.0) ? -e : e;
+		}
+		if (std::abs(a.hi) > 0.05) {
+			const dd_real e = exp(a);
+			return ldexp(e - 1.0 / e, -1);
+		}
+
+		/* Taylor series to avoid cancellation */
+		const dd_real a2 = a * a;
+		dd_real s    = a;
+		dd_real term = a;
+		for (int n = 1; n < 20; ++n) {
+			term = term * a2 / static_cast<double>((2 * n) * (2 * n + 1));
+			s += term;
+			if (std::abs(term.hi) < Details::DD_EPS * std::abs(s.hi))
+				break;
+		}
+		return s;
+	}
+
+	inline dd_real cosh(const dd_real& a)
+	{
+		/* exp(-|a|) is below the precision, and exp(|a|) / 2 may be finite when exp(|a|) is not */
+		if (std::abs(a.hi) > 40.0)
+			return exp(abs(a) - Details::DD_LN2);
+		const dd_real e = exp(a);
+		return ldexp(e + 1.0 / e, -1);
+	}
+
+	inline dd_real tanh(const dd_real& a)
+	{
+		/* 1 - tanh(a) < 2exp(-2|a|) is below the precision */
+		if (std::abs(a.hi) > 40.0)
+			return dd_real(std::copysign(1.0, a.hi));
+		if (std::abs(a.hi) > 0.05) {
+			const dd_real e = exp(a);
+			const dd_real inv = 1.0 / e;
+			return (e - inv) / (e + inv);
+		}
+		const dd_real s = sinh(a);
+		return s / sqrt(1.0 + s * s);
+	}
+
+	inline dd_real asinh(const dd_real& a)
+	{
+		if (a.hi < 0.0)
+			return -asinh(-a);
+		/* a^2 overflows, and asinh(a) = log(2a) within the precision */
+		if (a.hi > 1e150)
+			return log(a) + Details::DD_LN2;
+		/* a + sqrt(a^2 + 1) = 1 + a + a^2 / (1 + sqrt(a^2 + 1)) */
+		const dd_real a2 = a * a;
+		return Details::log1p(a + a2 / (1.0 + sqrt(a2 + 1.0)));
+	}
+
+	inline dd_real acosh(const dd_real& a)
+	{
+		if (a.hi < 1.0)
+			return dd_real(std::numeric_limits<double>::quiet_NaN());
+		if (a.hi > 1e150)
+			return log(a) + Details::DD_LN2;
+		/* a + sqrt(a^2 - 1) = 1 + t + sqrt(t (t + 2)) where t = a - 1 is exact near 1 */
+		const dd_real t = a - 1.0;
+		return Details::log1p(t + sqrt(t * (t + 2.0)));
+	}
+
+	inline dd_real atanh(const dd_real& a)
+	{
+		if (std::abs(a.hi) <= 0.05)
+			return Details::atanh_taylor(a);
+		/* 1 + a and 1 - a are exact near 1, and log(1 + 2a / (1 - a)) has no cancellation near 0 */
+		if (std::abs(a.hi) >= 0.5)
+			return ldexp(log((1.0 + a) / (1.0 - a)), -1);
+		return ldexp(Details::log1p(ldexp(a, 1) / (1.0 - a)), -1);
+	}
+
+	namespace Details
+	{
+		/** @brief a^n by repeated squaring if b is an integer n */
+		template <typename DD>
+		bool dd_pow_int(const DD& a, const dd_real& b, DD& result)
+		{
+			if (b.lo != 0.0 || b.hi != std::trunc(b.hi) || std::abs(b.hi) > DD_POW_INT_MAX)
+				return false;
+
+			int n = static_cast<int>(b.hi);
+			DD base = a;
+			result = DD(1.0);
+			for (int k = std::abs(n); k != 0; k >>= 1) {
+				if (k & 1)
+					result = result * base;
+				base = base * base;
+			}
+			if (n < 0)
+				result = DD(1.0) / result;
+			return true;
+		}
+	}
+
+	inline dd_real pow(const dd_real& a, const dd_real& b)
+	{
+		dd_real result;
+		if (Details::dd_pow_int(a, b, result))
+			return result;
+		if (a.hi == 0.0)
+			return dd_real((b.hi > 0.0) ? 0.0 : std::numeric_limits<double>::infinity());
+		return exp(b * log(a));
+	}
+
+
+	/**
+	 * @brief complex number of dd_real
+	 * @note  std::complex<dd_real> is unspecified by the standard, so this class is used instead.
+	 */
+	struct dd_complex
+	{
+		dd_real re;
+		dd_real im;
+
+		constexpr dd_complex() = default;
+		constexpr dd_complex(double re) : re(re), im() {}
+		constexpr dd_complex(int re) : re(re), im() {}
+		constexpr dd_complex(const dd_real& re, const dd_real& im = dd_real()) : re(re), im(im) {}
+		constexpr dd_complex(const std::complex<double>& z) : re(z.real()), im(z.imag()) {}
+
+		explicit operator std::complex<double>() const { return { re.hi, im.hi }; }
+
+		const dd_real& real() const { return re; }
+		const dd_real& imag() const { return im; }
+
+		dd_complex operator-() const { return dd_complex(-re, -im); }
+
+		dd_complex& operator+=(const dd_complex& b);
+		dd_complex& operator-=(const dd_complex& b);
+		dd_complex& operator*=(const dd_complex& b);
+		dd_complex& operator/=(const dd_complex& b);
+	};
+
+	inline dd_complex operator+(const dd_complex& a, const dd_complex& b) { return dd_complex(a.re + b.re, a.im + b.im); }
+	inline dd_complex operator-(const dd_complex& a, const dd_complex& b) { return dd_complex(a.re - b.re, a.im - b.im); }
+
+	inline dd_complex operator*(const dd_complex& a, const dd_complex& b)
+	{
+		return dd_complex(a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re);
+	}
+
+	inline dd_complex operator*(const dd_complex& a, const dd_real& b) { return dd_complex(a.re * b, a.im * b); }
+	inline dd_complex operator*(const dd_real& a, const dd_complex& b) { return b * a; }
+	inline dd_complex operator*(const dd_complex& a, double b)         { return dd_complex(a.re * b, a.im * b); }
+	inline dd_complex operator*(double a, const dd_complex& b)         { return b * a; }
+
+	inline dd_complex operator/(const dd_complex& a, const dd_complex& b)
+	{
+		/* Smith's algorithm to avoid overflow */
+		if (std::abs(b.re.hi) >= std::abs(b.im.hi)) {
+			const dd_real r = b.im / b.re;
+			const dd_real d = b.re + b.im * r;
+			return dd_complex((a.re + a.im * r) / d, (a.im - a.re * r) / d);
+		} else {
+			const dd_real r = b.re / b.im;
+			const dd_real d = b.re * r + b.im;
+			return dd_complex((a.re * r + a.im) / d, (a.im * r - a.re) / d);
+		}
+	}
+
+	inline dd_complex operator/(const dd_complex& a, const dd_real& b) { return dd_complex(a.re / b, a.im / b); }
+	inline dd_complex operator/(const dd_complex& a, double b)         { return dd_complex(a.re / b, a.im / b); }
+
+	inline dd_complex& dd_complex::operator+=(const dd_complex& b) { return *this = *this + b; }
+	inline dd_complex& dd_complex::operator-=(const dd_complex& b) { return *this = *this - b; }
+	inline dd_complex& dd_complex::operator*=(const dd_complex& b) { return *this = *this * b; }
+	inline dd_complex& dd_complex::operator/=(const dd_complex& b) { return *this = *this / b; }
+
+	inline bool operator==(const dd_complex& a, const dd_complex& b) { return a.re == b.re && a.im == b.im; }
+	inline bool operator!=(const dd_complex& a, const dd_complex& b) { return !(a == b); }
+
+	inline std::ostream& operator<<(std::ostream& os, const dd_complex& a)
+	{
+		return os << '(' << a.re << ',' << a.im << ')';
+	}
+
+	/* -------------------------------------------------------------------------------- */
+	/*  functions of dd_complex                                                          */
+	/* -------------------------------------------------------------------------------- */
+
+	inline dd_real real(const dd_complex& z) { return z.re; }
+	inline dd_real imag(const dd_complex& z) { return z.im; }
+	inline dd_real norm(const dd_complex& z) { return z.re * z.re + z.im * z.im; }
+	inline dd_real abs(const dd_complex& z)  { return sqrt(norm(z)); }
+	inline dd_real arg(const dd_complex& z)  { return atan2(z.im, z.re); }
+	inline dd_complex conj(const dd_complex& z) { return dd_complex(z.re, -z.im); }
+
+	inline dd_complex exp(const dd_complex& z)
+	{
+		const dd_real e = exp(z.re);
+		dd_real s, c;
+		Details::sincos(z.im, s, c);
+		return dd_complex(e * c, e * s);
+	}
+
+	inline dd_complex log(const dd_complex& z)
+	{
+		return dd_complex(ldexp(log(norm(z)), -1), arg(z));
+	}
+
+	inline dd_complex log10(const dd_complex& z) { return log(z) / Details::DD_LN10; }
+
+	inline dd_complex sqrt(const dd_complex& z)
+	{
+		if (z.re.hi == 0.0 && z.im.hi == 0.0)
+			return dd_complex();
+
+		const dd_real r = abs(z);
+		if (z.re.hi >= 0.0) {
+			const dd_real t = sqrt(ldexp(r + z.re, -1));
+			return dd_complex(t, z.im / ldexp(t, 1));
+		} else {
+			const dd_real t = sqrt(ldexp(r - z.re, -1));
+			return dd_complex(abs(z.im) / ldexp(t, 1), (z.im.hi < 0.0) ? -t : t);
+		}
+	}
+
+	inline dd_complex sin(const dd_complex& z)
+	{
+		dd_real s, c;
+		Details::sincos(z.re, s, c);
+		return dd_complex(s * cosh(z.im), c * sinh(z.im));
+	}
+
+	inline dd_complex cos(const dd_complex& z)
+	{
+		dd_real s, c;
+		Details::sincos(z.re, s, c);
+		return dd_complex(c * cosh(z.im), -(s * sinh(z.im)));
+	}
+
+	inline dd_complex tan(const dd_complex& z) { return sin(z) / cos(z); }
+
+	inline dd_complex sinh(const dd_complex& z)
+	{
+		dd_real s, c;
+		Details::sincos(z.im, s, c);
+		return dd_complex(sinh(z.re) * c, cosh(z.re) * s);
+	}
+
+	inline dd_complex cosh(const dd_complex& z)
+	{
+		dd_real s, c;
+		Details::sincos(z.im, s, c);
+		return dd_complex(cosh(z.re) * c, sinh(z.re) * s);
+	}
+
+	inline dd_complex tanh(const dd_complex& z)
+	{
+		/* (sinh(2x) + i sin(2y)) / (cosh(2x) + cos(2y)), which does not overflow for large |x| */
+		dd_real s, c;
+		Details::sincos(ldexp(z.im, 1), s, c);
+		if (std::abs(z.re.hi) > 40.0)
+			return dd_complex(dd_real(std::copysign(1.0, z.re.hi)), ldexp(s * exp(-ldexp(abs(z.re), 1)), 1));
+
+		const dd_real x2 = ldexp(z.re, 1);
+		const dd_real d  = cosh(x2) + c;
+		return dd_complex(sinh(x2) / d, s / d);
+	}
+
+	inline dd_complex asin(const dd_complex& z)
+	{
+		/* -i log(iz + sqrt(1 - z^2)) */
+		const dd_complex w = log(dd_complex(-z.im, z.re) + sqrt(dd_complex(1.0) - z * z));
+		return dd_complex(w.im, -w.re);
+	}
+
+	inline dd_complex acos(const dd_complex& z) { return dd_complex(Details::DD_PI_2) - asin(z); }
+
+	inline dd_complex atan(const dd_complex& z)
+	{
+		/* i/2 (log(1 - iz) - log(1 + iz)) */
+		const dd_complex iz(-z.im, z.re);
+		const dd_complex w = log(dd_complex(1.0) - iz) - log(dd_complex(1.0) + iz);
+		return dd_complex(ldexp(-w.im, -1), ldexp(w.re, -1));
+	}
+
+	inline dd_complex asinh(const dd_complex& z) { return log(z + sqrt(z * z + dd_complex(1.0))); }
+	inline dd_complex acosh(const dd_complex& z) { return log(z + sqrt(z + dd_complex(1.0)) * sqrt(z - dd_complex(1.0))); }
+
+	inline dd_complex atanh(const dd_complex& z)
+	{
+		const dd_complex w = log(dd_complex(1.0) + z) - log(dd_complex(1.0) - z);
+		return dd_complex(ldexp(w.re, -1), ldexp(w.im, -1));
+	}
+
+	inline dd_complex pow(const dd_complex& a, const dd_complex& b)
+	{
+		dd_complex result;
+		if (b.im.hi == 0.0 && Details::dd_pow_int(a, b.re, result))
+			return result;
+		if (a.re.hi == 0.0 && a.im.hi == 0.0)
+			return dd_complex();
+		return exp(b * log(a));
+	}
+}
+
+#endif /* end of __SYAMFP_DD_HPP__ */
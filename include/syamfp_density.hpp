@@ -0,0 +1,250 @@
+/**
+ * @file syamfp_density.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Orbit density (Buddhabrot) accumulation
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_DENSITY_HPP__
+#define __SYAMFP_DENSITY_HPP__
+
+#include "syamfp.hpp"
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	/**
+	 * @brief accumulator of orbit points of `z <- f(z, c)` for random c into 2-D histogram
+	 *
+	 * Each sample c is iterated twice with `Program::BLOCK` lanes at once: the first pass decides
+	 * whether the orbit is accepted, and the second pass accumulates the orbit points of the accepted
+	 * samples. Each thread accumulates into its private histogram, and they are merged at the end.
+	 * Samples are generated by Philox from (seed, chunk index), so that the result does not depend
+	 * on the number of threads.
+	 */
+	template <Details::MathConcept Type = std::complex<double>>
+	class DensityRenderer
+	{
+	public:
+		struct Option
+		{
+			std::uint64_t samples       = 1000000;
+			std::size_t   max_iter      = 1000;
+			std::size_t   min_iter      = 0;      /* accumulate only orbits escaping at min_iter or later */
+			double        bailout       = 2.0;
+			bool          escaping      = true;   /* true: escaping orbits (Buddhabrot), false: bounded orbits */
+			Type          sample_center = Details::num<Type>(-0.5);
+			double        sample_radius = 2.0;    /* c is sampled in the square of center +- radius */
+			bool          periodicity   = true;   /* stop bounded orbits caught in a cycle at the first pass */
+			double        period_tolerance = 1e-12;
+			std::uint64_t seed          = 0;
+			std::size_t   threads       = 0;      /* 0 means the number of hardware threads */
+		};
+
+		struct View
+		{
+			Type        center     = Details::num<Type>(-0.5);
+			double      pixel_size = 4.0 / 512;
+			std::size_t width      = 512;
+			std::size_t height     = 512;
+		};
+
+		struct Result
+		{
+			std::size_t width  = 0;
+			std::size_t height = 0;
+			std::vector<std::uint32_t> histogram;  /* row major, top row first */
+			std::uint64_t accepted = 0;            /* the number of accepted samples */
+		};
+
+	private:
+		static constexpr std::size_t BLOCK = Program<Type>::BLOCK;
+		static constexpr std::size_t CHUNK = 16 * BLOCK;  /* samples generated from one stream */
+
+		Program<Type> program;
+		Type          z0;
+
+		/** @brief histogram and buffers of one thread */
+		struct Worker
+		{
+			std::vector<std::uint32_t> histogram;
+			std::uint64_t accepted = 0;
+			typename Program<Type>::Workspace ws;
+			std::vector<Type> cs;
+			std::vector<std::size_t> escape;
+		};
+
+		static double real(const Type& z) { return static_cast<double>(z.real()); }
+		static double imag(const Type& z) { return static_cast<double>(z.imag()); }
+
+		/**
+		 * @brief iterate samples `cs[lanes]` with compacting finished lanes
+		 * @param visit `bool(std::size_t lane, std::size_t iteration, const Type& z)` returns false to finish the lane
+		 */
+		template <typename Visit>
+		void iterate(const std::vector<Type>& cs, std::vector<std::size_t> lanes, const Option& option,
+		             typename Program<Type>::Workspace& ws, Visit&& visit) const
+		{
+			std::array<Type, BLOCK> zs, cb, out;
+			std::array<std::size_t, BLOCK> lane;
+			const Type* columns[2] = { zs.data(), cb.data() };
+
+			for (std::size_t base = 0; base < lanes.size(); base += BLOCK) {
+				std::size_t m = std::min(BLOCK, lanes.size() - base);
+				for (std::size_t i = 0; i < m; ++i) {
+					lane[i] = lanes[base + i];
+					zs[i]   = z0;
+					cb[i]   = cs[lane[i]];
+				}
+
+				for (std::size_t it = 0; it < option.max_iter && m != 0; ++it) {
+					program.eval_batch(m, columns, out.data(), ws);
+
+					std::size_t active = 0;
+					for (std::size_t i = 0; i < m; ++i) {
+						if (visit(lane[i], it, out[i])) {
+							zs[active]   = out[i];
+							cb[active]   = cb[i];
+							lane[active] = lane[i];
+							active++;
+						}
+					}
+					m = active;
+				}
+			}
+		}
+
+		void accumulate(std::uint64_t chunk, const View& view, const Option& option, Worker& w) const
+		{
+			const double bail2 = option.bailout * option.bailout;
+			const std::uint64_t first = chunk * CHUNK;
+			const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(CHUNK, option.samples - first));
+
+			/* samples of this chunk */
+			Details::CounterRNG rng(option.seed, chunk);
+			w.cs.resize(n);
+			for (std::size_t i = 0; i < n; ++i) {
+				const double x = (2.0 * rng.uniform() - 1.0) * option.sample_radius;
+				const double y = (2.0 * rng.uniform() - 1.0) * option.sample_radius;
+				w.cs[i] = option.sample_center + static_cast<Type>(std::complex<Details::ValueType>(x, y));
+			}
+
+			/* first pass: escape time of each sample */
+			std::vector<std::size_t> lanes(n);
+			for (std::size_t i = 0; i < n; ++i) {
+				lanes[i] = i;
+			}
+			w.escape.assign(n, option.max_iter);
+			std::vector<Details::PeriodDetector<Type>> detectors(n, Details::PeriodDetector<Type>(z0, option.period_tolerance));
+			const bool periodicity = option.periodicity && option.escaping;
+
+			iterate(w.cs, lanes, option, w.ws, [&](std::size_t i, std::size_t it, const Type& z)
+			{
+				const double nz = real(z) * real(z) + imag(z) * imag(z);
+				if (!(nz <= bail2)) {
+					w.escape[i] = it;
+					return false;
+				}
+				return !(periodicity && detectors[i].check(z) != 0);
+			});
+
+			/* second pass: accumulate orbit points of accepted samples */
+			lanes.clear();
+			for (std::size_t i = 0; i < n; ++i) {
+				const bool escaped = w.escape[i] < option.max_iter;
+				if (escaped == option.escaping && (!escaped || w.escape[i] >= option.min_iter))
+					lanes.push_back(i);
+			}
+			w.accepted += lanes.size();
+
+			const double left = real(view.center) - 0.5 * static_cast<double>(view.width)  * view.pixel_size;
+			const double top  = imag(view.center) + 0.5 * static_cast<double>(view.height) * view.pixel_size;
+			const double inv  = 1.0 / view.pixel_size;
+
+			iterate(w.cs, lanes, option, w.ws, [&](std::size_t i, std::size_t it, const Type& z)
+			{
+				if (it >= w.escape[i])
+					return false;
+
+				const double px = (real(z) - left) * inv;
+				const double py = (top - imag(z)) * inv;
+				if (px >= 0.0 && py >= 0.0 && px < static_cast<double>(view.width) && py < static_cast<double>(view.height)) {
+					w.histogram[static_cast<std::size_t>(px) + static_cast<std::size_t>(py) * view.width]++;
+				}
+				return true;
+			});
+		}
+
+	public:
+		/**
+		 * @brief compile formula `f(z, c)`
+		 *
+		 * @param formula formula like "z^2 + c"
+		 * @param table   values of the other variables
+		 * @param z       variable string iterated
+		 * @param c       variable string of the sample
+		 * @param z0      initial value of z
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		DensityRenderer(const std::string& formula, const VariableTable<Type>& table = VariableTable<Type>(),
+		                const std::string& z = "z", const std::string& c = "c",
+		                const Type& z0 = Details::num<Type>(0.0))
+			: z0(z0)
+		{
+			program = Syamfp<Type>::compile(formula, {z, c}, table);
+		}
+
+		~DensityRenderer() = default;
+
+		/**
+		 * @brief accumulate orbit points of random samples
+		 * @param view   area of the histogram in the complex plane
+		 * @param option options of sampling
+		 * @return `Result` histogram of orbit points
+		 */
+		Result render(const View& view, const Option& option = Option()) const
+		{
+			std::vector<Worker> workers(Details::ret_thread_num(option.threads));
+			for (Worker& w : workers) {
+				w.histogram.assign(view.width * view.height, 0);
+				w.ws = program.make_workspace();
+			}
+
+			const std::uint64_t chunks = (option.samples + CHUNK - 1) / CHUNK;
+			Details::parallel_for(static_cast<std::size_t>(chunks), 1, workers.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					for (std::size_t chunk = begin; chunk < end; ++chunk) {
+						accumulate(chunk, view, option, workers[worker]);
+					}
+				});
+
+			/* merge private histograms */
+			Result result;
+			result.width  = view.width;
+			result.height = view.height;
+			result.histogram.swap(workers[0].histogram);
+			result.accepted = workers[0].accepted;
+			for (std::size_t k = 1; k < workers.size(); ++k) {
+				for (std::size_t p = 0; p < result.histogram.size(); ++p) {
+					result.histogram[p] += workers[k].histogram[p];
+				}
+				result.accepted += workers[k].accepted;
+			}
+			return result;
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_DENSITY_HPP__ */
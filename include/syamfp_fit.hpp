@@ -0,0 +1,327 @@
+/**
+ * @file syamfp_fit.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Nonlinear least squares fitting of parameters of compiled formulas
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_FIT_HPP__
+#define __SYAMFP_FIT_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	/**
+	 * @brief Levenberg-Marquardt fitting of the parameters of a model formula to observed data
+	 *
+	 * The model `y = f(x..., p...)` is compiled once with the data variables as free variables, and the
+	 * parameters are the variables of VariableTable. The Jacobian is calculated by forward mode automatic
+	 * differentiation: one batch evaluation per parameter. The data are split into fixed chunks, and the
+	 * normal equations of the chunks are summed in order, so the result does not depend on the number of threads.
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	class CurveFitter
+	{
+	public:
+		struct Option
+		{
+			std::size_t max_iter = 100;
+			double      lambda   = 1e-3;   /* initial damping */
+			double      ftol     = 1e-12;  /* relative decrease of chi square to stop */
+			double      xtol     = 1e-12;  /* relative step of the parameters to stop */
+			std::size_t threads  = 0;      /* 0 means the number of hardware threads */
+		};
+
+		struct Result
+		{
+			std::vector<Type> parameters;  /* fitted values in the order of the parameter names */
+			std::vector<Type> covariance;  /* row major, parameters.size() x parameters.size() */
+			Type              chi2;        /* sum of squared (weighted) residuals */
+			std::size_t       iterations = 0;
+			bool              converged  = false;
+		};
+
+	private:
+		static constexpr std::size_t CHUNK = 4096;
+
+		Program<Type>            program;
+		std::vector<std::size_t> indices;  /* parameter index of Program for each fitted parameter */
+
+		/** @brief data of one fit */
+		struct Data
+		{
+			std::size_t        n;
+			const Type* const* columns;
+			const Type*        observed;
+			const Type*        sigma;
+		};
+
+		/**
+		 * @brief sum of squared residuals, and the normal equations J^T J and J^T r if `normal` is true
+		 * @param[out] sums `sums[0]` is chi square, then J^T r (p), then J^T J (p x p, row major)
+		 */
+		void accumulate(const Program<Type>& model, const Data& data, bool normal, std::size_t threads,
+		                std::vector<Type>& sums) const
+		{
+			const std::size_t p      = indices.size();
+			const std::size_t width  = normal ? 1 + p + p * p : 1;
+			const std::size_t chunks = (data.n + CHUNK - 1) / CHUNK;
+			const std::size_t vars   = model.variable_num();
+			std::vector<Type> partial(chunks * width, Details::num<Type>(0.0));
+
+			const std::size_t workers = Details::ret_thread_num(threads);
+			std::vector<typename Program<Type>::Workspace> wss(workers, model.make_workspace());
+			std::vector<std::vector<Type>> values(workers, std::vector<Type>(CHUNK * (normal ? 1 + p : 1)));
+
+			Details::parallel_for(chunks, 1, workers,
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					std::vector<const Type*> cols(vars);
+					Type* f  = values[worker].data();
+					Type* df = f + CHUNK;
+					for (std::size_t chunk = begin; chunk < end; ++chunk) {
+						const std::size_t first = chunk * CHUNK;
+						const std::size_t m     = std::min(CHUNK, data.n - first);
+						for (std::size_t k = 0; k < vars; ++k) {
+							cols[k] = data.columns[k] + first;
+						}
+
+						if (normal) {
+							for (std::size_t j = 0; j < p; ++j) {
+								model.eval_batch_derivative(m, cols.data(), vars + indices[j], f, df + j * CHUNK, wss[worker]);
+							}
+						} else {
+							model.eval_batch(m, cols.data(), f, wss[worker]);
+						}
+
+						Type* sum = partial.data() + chunk * width;
+						for (std::size_t i = 0; i < m; ++i) {
+							const Type w = (data.sigma == nullptr) ? Details::num<Type>(1.0) : Details::num<Type>(1.0) / data.sigma[first + i];
+							const Type r = w * (data.observed[first + i] - f[i]);
+							sum[0] += r * r;
+							if (!normal)
+								continue;
+							for (std::size_t j = 0; j < p; ++j) {
+								const Type jj = w * df[j * CHUNK + i];
+								sum[1 + j] += jj * r;
+								for (std::size_t k = 0; k <= j; ++k) {
+									sum[1 + p + j * p + k] += jj * w * df[k * CHUNK + i];
+								}
+							}
+						}
+					}
+				});
+
+			sums.assign(width, Details::num<Type>(0.0));
+			for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+				for (std::size_t k = 0; k < width; ++k) {
+					sums[k] += partial[chunk * width + k];
+				}
+			}
+			if (normal) {
+				for (std::size_t j = 0; j < p; ++j) {
+					for (std::size_t k = j + 1; k < p; ++k) {
+						sums[1 + p + j * p + k] = sums[1 + p + k * p + j];
+					}
+				}
+			}
+		}
+
+		/**
+		 * @brief Cholesky decomposition of a symmetric matrix in place (lower triangle)
+		 * @return `bool` false if the matrix is not positive definite
+		 */
+		static bool cholesky(std::vector<Type>& a, std::size_t p)
+		{
+			using std::sqrt;
+			for (std::size_t j = 0; j < p; ++j) {
+				Type d = a[j * p + j];
+				for (std::size_t k = 0; k < j; ++k) {
+					d -= a[j * p + k] * a[j * p + k];
+				}
+				if (!(d > Details::num<Type>(0.0)))
+					return false;
+				d = sqrt(d);
+				a[j * p + j] = d;
+				for (std::size_t i = j + 1; i < p; ++i) {
+					Type s = a[i * p + j];
+					for (std::size_t k = 0; k < j; ++k) {
+						s -= a[i * p + k] * a[j * p + k];
+					}
+					a[i * p + j] = s / d;
+				}
+			}
+			return true;
+		}
+
+		/** @brief solve L L^T x = b in place */
+		static void cholesky_solve(const std::vector<Type>& l, std::size_t p, Type* b)
+		{
+			for (std::size_t i = 0; i < p; ++i) {
+				for (std::size_t k = 0; k < i; ++k) {
+					b[i] -= l[i * p + k] * b[k];
+				}
+				b[i] /= l[i * p + i];
+			}
+			for (std::size_t i = p; i-- > 0;) {
+				for (std::size_t k = i + 1; k < p; ++k) {
+					b[i] -= l[k * p + i] * b[k];
+				}
+				b[i] /= l[i * p + i];
+			}
+		}
+
+	public:
+		/**
+		 * @brief compile the model
+		 *
+		 * @param formula    model like "a*exp(-b*t) + c"
+		 * @param parameters names of the fitted parameters. their initial values are read from `table`.
+		 * @param variables  names of the data variables
+		 * @param table      values of the parameters and the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid, no parameter is given,
+		 *        or a parameter is duplicated or not used in the formula
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		CurveFitter(const std::string& formula, const std::vector<std::string>& parameters,
+		            const std::vector<std::string>& variables, const VariableTable<Type>& table)
+		{
+			program = Syamfp<Type>::compile(formula, variables, table);
+
+			if (parameters.empty()) {
+				throw std::invalid_argument("CurveFitter: no parameter to fit");
+			}
+			for (const std::string& name : parameters) {
+				const int slot = program.slot(name);
+				if (slot < static_cast<int>(program.variable_num())) {
+					throw std::invalid_argument("CurveFitter: " + name + " is not a parameter of the formula");
+				}
+				const std::size_t index = static_cast<std::size_t>(slot) - program.variable_num();
+				if (std::find(indices.begin(), indices.end(), index) != indices.end()) {
+					throw std::invalid_argument("CurveFitter: " + name + " is given twice");
+				}
+				indices.push_back(index);
+			}
+		}
+
+		~CurveFitter() = default;
+
+		/**
+		 * @brief fit the parameters to the data
+		 *
+		 * @param n        the number of data points
+		 * @param columns  `columns[k][i]` is the value of k-th data variable of i-th point
+		 * @param observed `observed[i]` is the observed value of i-th point
+		 * @param sigma    `sigma[i]` is the standard deviation of i-th observed value, or `nullptr`
+		 * @param option   limits of the iteration
+		 * @return `Result` fitted parameters and their covariance. without `sigma`, the covariance is
+		 *         scaled by chi2 / (n - p) as the variance of the data is estimated from the residuals.
+		 */
+		Result fit(std::size_t n, const Type* const* columns, const Type* observed,
+		           const Type* sigma = nullptr, const Option& option = Option()) const
+		{
+			using std::abs;
+			const std::size_t p = indices.size();
+			const Data data{ n, columns, observed, sigma };
+
+			Program<Type> model = program;
+			Result result;
+			for (std::size_t index : indices) {
+				result.parameters.push_back(model.parameters()[index]);
+			}
+
+			std::vector<Type> sums, trial_sums, a(p * p), step(p);
+			accumulate(model, data, true, option.threads, sums);
+			result.chi2 = sums[0];
+			Type lambda = Details::num<Type>(option.lambda);
+
+			while (result.iterations < option.max_iter && p > 0) {
+				result.iterations++;
+
+				/* (J^T J + lambda diag(J^T J)) step = J^T r */
+				for (std::size_t k = 0; k < p * p; ++k) {
+					a[k] = sums[1 + p + k];
+				}
+				for (std::size_t j = 0; j < p; ++j) {
+					const Type d = a[j * p + j];
+					a[j * p + j] = d + lambda * ((d > Details::num<Type>(0.0)) ? d : Details::num<Type>(1.0));
+					step[j] = sums[1 + j];
+				}
+				if (!cholesky(a, p)) {
+					lambda *= Details::num<Type>(10.0);
+					continue;
+				}
+				cholesky_solve(a, p, step.data());
+
+				for (std::size_t j = 0; j < p; ++j) {
+					model.set_parameter(indices[j], result.parameters[j] + step[j]);
+				}
+				accumulate(model, data, false, option.threads, trial_sums);
+
+				if (!(trial_sums[0] < result.chi2)) {
+					for (std::size_t j = 0; j < p; ++j) {
+						model.set_parameter(indices[j], result.parameters[j]);
+					}
+					lambda *= Details::num<Type>(10.0);
+					if (lambda > Details::num<Type>(1e32))
+						break;
+					continue;
+				}
+
+				/* accept the step */
+				bool small = true;
+				for (std::size_t j = 0; j < p; ++j) {
+					if (abs(step[j]) > Details::num<Type>(option.xtol) * (abs(result.parameters[j]) + Details::num<Type>(option.xtol)))
+						small = false;
+					result.parameters[j] += step[j];
+				}
+				const Type decrease = result.chi2 - trial_sums[0];
+				result.chi2 = trial_sums[0];
+				lambda = std::max(lambda / Details::num<Type>(10.0), Details::num<Type>(1e-12));
+
+				accumulate(model, data, true, option.threads, sums);
+				if (small || decrease <= Details::num<Type>(option.ftol) * result.chi2 || result.chi2 == Details::num<Type>(0.0)) {
+					result.converged = true;
+					break;
+				}
+			}
+
+			/* covariance = (J^T J)^-1 */
+			result.covariance.assign(p * p, Details::num<Type>(std::numeric_limits<double>::quiet_NaN()));
+			for (std::size_t k = 0; k < p * p; ++k) {
+				a[k] = sums[1 + p + k];
+			}
+			if (p > 0 && cholesky(a, p)) {
+				const Type scale = (sigma == nullptr && n > p)
+					? result.chi2 / Details::num<Type>(static_cast<double>(n - p))
+					: Details::num<Type>(1.0);
+				for (std::size_t j = 0; j < p; ++j) {
+					std::fill(step.begin(), step.end(), Details::num<Type>(0.0));
+					step[j] = Details::num<Type>(1.0);
+					cholesky_solve(a, p, step.data());
+					for (std::size_t k = 0; k < p; ++k) {
+						result.covariance[k * p + j] = scale * step[k];
+					}
+				}
+			}
+
+			return result;
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_FIT_HPP__ */
@@ -0,0 +1,360 @@
+/**
+ * @file syamfp_lookup.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Tabulated formulas evaluated by interpolation
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_LOOKUP_HPP__
+#define __SYAMFP_LOOKUP_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	/**
+	 * @brief formula of one or two variables tabulated on a uniform grid
+	 *
+	 * The table is made by one threaded batch evaluation of all grid points, and evaluated by linear or
+	 * cubic (Catmull-Rom) interpolation. The grid has one ghost point at each end of the axes extrapolated
+	 * by a quadratic, so that the cubic interpolation needs no branch at the edges. The variables out of
+	 * the range are clamped to it.
+	 *
+	 * eval_batch() calculates the cells and the weights of a block first, and then gathers the values,
+	 * so that the both loops can be vectorized.
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	class LookupTable
+	{
+	public:
+		using Interpolation = SYAMFP::Interpolation;
+
+		struct Axis
+		{
+			double      min, max;
+			std::size_t points;  /* the number of grid points including both ends. at least 2 */
+		};
+
+		struct Option
+		{
+			Interpolation interpolation = Interpolation::Cubic;
+			std::size_t   threads       = 0;  /* 0 means the number of hardware threads */
+		};
+
+		/** @brief error of the interpolation against direct evaluation */
+		struct Report
+		{
+			double      max_abs = 0.0;
+			double      max_rel = 0.0;  /* relative to |f|, where |f| is not zero */
+			double      rms_abs = 0.0;
+			std::size_t samples = 0;
+		};
+
+	private:
+		static constexpr std::size_t BLOCK = 64;
+
+		Program<Type>       program;
+		std::vector<Axis>   axes;
+		std::vector<double> inv_step;   /* grid points per unit */
+		std::vector<Type>   values;     /* values[(j + 1) * stride + (i + 1)] is f(x_i, y_j) with ghost points */
+		std::size_t         stride = 0;
+		Interpolation       interpolation;
+
+		/**
+		 * @brief cell index and the position in the cell of the variable on the axis
+		 * @return `bool` false if the variable is NaN. the index and the position are 0 then.
+		 */
+		bool locate(std::size_t axis, const Type& value, std::size_t& index, double& t) const
+		{
+			const Axis& a = axes[axis];
+			const double x = static_cast<double>(value);
+			if (std::isnan(x)) {
+				index = 0;
+				t     = 0.0;
+				return false;
+			}
+			const double u = std::clamp((x - a.min) * inv_step[axis], 0.0, static_cast<double>(a.points - 1));
+			index = std::min(static_cast<std::size_t>(u), a.points - 2);
+			t = u - static_cast<double>(index);
+			return true;
+		}
+
+		/** @brief weights of the points index - 1, ..., index + 2 */
+		void weights(double t, double* w) const
+		{
+			if (interpolation == Interpolation::Linear) {
+				w[0] = 0.0;
+				w[1] = 1.0 - t;
+				w[2] = t;
+				w[3] = 0.0;
+			} else {
+				const double t2 = t * t, t3 = t2 * t;
+				w[0] = 0.5 * (-t3 + 2.0 * t2 - t);
+				w[1] = 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+				w[2] = 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+				w[3] = 0.5 * (t3 - t2);
+			}
+		}
+
+		/** @brief tabulate the program on the grid */
+		void build(const Option& option)
+		{
+			if (axes.size() != program.variable_num() || axes.empty() || axes.size() > 2) {
+				throw std::invalid_argument("LookupTable: the number of axes must be the number of variables (1 or 2)");
+			}
+			for (const Axis& a : axes) {
+				if (a.points < 2 || !(a.min < a.max)) {
+					throw std::invalid_argument("LookupTable: axis must have two points at least on a non-empty range");
+				}
+				inv_step.push_back(static_cast<double>(a.points - 1) / (a.max - a.min));
+			}
+
+			const std::size_t nx = axes[0].points;
+			const std::size_t ny = (axes.size() == 2) ? axes[1].points : 1;
+			stride = nx + 2;
+
+			std::vector<Type> xs(nx * ny), ys(nx * ny), fs(nx * ny);
+			for (std::size_t j = 0; j < ny; ++j) {
+				for (std::size_t i = 0; i < nx; ++i) {
+					xs[j * nx + i] = Details::num<Type>(axes[0].min + (axes[0].max - axes[0].min) * static_cast<double>(i) / static_cast<double>(nx - 1));
+					if (axes.size() == 2)
+						ys[j * nx + i] = Details::num<Type>(axes[1].min + (axes[1].max - axes[1].min) * static_cast<double>(j) / static_cast<double>(ny - 1));
+				}
+			}
+			const Type* columns[2] = { xs.data(), ys.data() };
+			program.eval_batch(xs.size(), columns, fs.data(), option.threads);
+
+			const std::size_t rows = (axes.size() == 2) ? ny + 2 : 1;
+			values.assign(stride * rows, Details::num<Type>(0.0));
+			auto at = [&](std::ptrdiff_t i, std::ptrdiff_t j) -> Type&
+			{
+				const std::ptrdiff_t row = (axes.size() == 2) ? j + 1 : 0;
+				return values[static_cast<std::size_t>(row) * stride + static_cast<std::size_t>(i + 1)];
+			};
+			for (std::size_t j = 0; j < ny; ++j) {
+				for (std::size_t i = 0; i < nx; ++i) {
+					at(i, j) = fs[j * nx + i];
+				}
+			}
+
+			/* ghost points: p[-1] = 3 p[0] - 3 p[1] + p[2], or linear with two points */
+			auto ghost = [](const Type& p0, const Type& p1, const Type& p2, bool quadratic)
+			{
+				return quadratic ? Details::num<Type>(3.0) * (p0 - p1) + p2 : Details::num<Type>(2.0) * p0 - p1;
+			};
+			const std::ptrdiff_t sx = static_cast<std::ptrdiff_t>(nx), sy = static_cast<std::ptrdiff_t>(ny);
+			for (std::ptrdiff_t j = 0; j < sy; ++j) {
+				at(-1, j) = ghost(at(0, j), at(1, j), at(std::min<std::ptrdiff_t>(2, sx - 1), j), nx > 2);
+				at(sx, j) = ghost(at(sx - 1, j), at(sx - 2, j), at(std::max<std::ptrdiff_t>(sx - 3, 0), j), nx > 2);
+			}
+			if (axes.size() == 2) {
+				for (std::ptrdiff_t i = -1; i <= sx; ++i) {
+					at(i, -1) = ghost(at(i, 0), at(i, 1), at(i, std::min<std::ptrdiff_t>(2, sy - 1)), ny > 2);
+					at(i, sy) = ghost(at(i, sy - 1), at(i, sy - 2), at(i, std::max<std::ptrdiff_t>(sy - 3, 0)), ny > 2);
+				}
+			}
+		}
+
+	public:
+		/**
+		 * @param program program with one or two free variables
+		 * @param axes    grid of each free variable
+		 * @param option  interpolation and threads used to make the table
+		 * @throw `std::invalid_argument` if the axes do not match the free variables
+		 */
+		LookupTable(const Program<Type>& program, const std::vector<Axis>& axes, const Option& option = Option())
+			: program(program), axes(axes), interpolation(option.interpolation)
+		{
+			build(option);
+		}
+
+		/**
+		 * @brief compile and tabulate the formula
+		 *
+		 * @param formula   formula like "pow(x, 1.7) * exp(-y)"
+		 * @param variables variable strings of the axes (1 or 2)
+		 * @param axes      grid of each variable
+		 * @param table     values of the other variables
+		 * @param option    interpolation and threads used to make the table
+		 * @throw `std::invalid_argument` if the formula is invalid, or the axes do not match the variables
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		LookupTable(const std::string& formula, const std::vector<std::string>& variables, const std::vector<Axis>& axes,
+		            const VariableTable<Type>& table = VariableTable<Type>(), const Option& option = Option())
+			: axes(axes), interpolation(option.interpolation)
+		{
+			program = Syamfp<Type>::compile(formula, variables, table);
+			build(option);
+		}
+
+		~LookupTable() = default;
+
+		/**
+		 * @brief interpolate the table
+		 * @param vars values of the variables
+		 * @return `Type` interpolated value. NaN if a variable is NaN
+		 */
+		Type operator()(const Type* vars) const
+		{
+			std::size_t i, j = 0;
+			double tx, ty = 0.0, wx[4], wy[4] = { 0.0, 1.0, 0.0, 0.0 };
+			if (!locate(0, vars[0], i, tx) || (axes.size() == 2 && !locate(1, vars[1], j, ty)))
+				return Details::num<Type>(std::numeric_limits<double>::quiet_NaN());
+			weights(tx, wx);
+			if (axes.size() == 2)
+				weights(ty, wy);
+
+			Type sum = Details::num<Type>(0.0);
+			const std::size_t rows = (axes.size() == 2) ? 4 : 1;
+			for (std::size_t r = 0; r < rows; ++r) {
+				const Type* row = values.data() + ((axes.size() == 2) ? (j + r) * stride : 0) + i;
+				Type s = Details::num<Type>(0.0);
+				for (std::size_t k = 0; k < 4; ++k) {
+					s += Details::num<Type>(wx[k]) * row[k];
+				}
+				sum += Details::num<Type>((axes.size() == 2) ? wy[r] : 1.0) * s;
+			}
+			return sum;
+		}
+
+		/** @brief interpolate the table of one variable */
+		Type operator()(const Type& x) const
+		{
+			return (*this)(&x);
+		}
+
+		/** @brief interpolate the table of two variables */
+		Type operator()(const Type& x, const Type& y) const
+		{
+			const Type vars[2] = { x, y };
+			return (*this)(vars);
+		}
+
+		/**
+		 * @brief interpolate for every elements
+		 *
+		 * @param n       the number of elements
+		 * @param columns `columns[k][i]` is the value of k-th variable of i-th element
+		 * @param out     `out[i]` is the result of i-th element
+		 */
+		void eval_batch(std::size_t n, const Type* const* columns, Type* out) const
+		{
+			const bool two = axes.size() == 2;
+			std::size_t offset[BLOCK];
+			double wx[4][BLOCK], wy[4][BLOCK];
+			bool nan[BLOCK];  /* NaN variable: the cell 0 is gathered, and the result is replaced */
+
+			for (std::size_t base = 0; base < n; base += BLOCK) {
+				const std::size_t m = std::min(BLOCK, n - base);
+
+				/* cells and weights */
+				for (std::size_t e = 0; e < m; ++e) {
+					std::size_t i, j = 0;
+					double tx, ty = 0.0, w[4];
+					nan[e] = !locate(0, columns[0][base + e], i, tx);
+					weights(tx, w);
+					for (int k = 0; k < 4; ++k) {
+						wx[k][e] = w[k];
+					}
+					if (two) {
+						nan[e] = !locate(1, columns[1][base + e], j, ty) || nan[e];
+						weights(ty, w);
+						for (int k = 0; k < 4; ++k) {
+							wy[k][e] = w[k];
+						}
+					}
+					offset[e] = j * stride + i;
+				}
+
+				/* gathers */
+				for (std::size_t e = 0; e < m; ++e) {
+					out[base + e] = Details::num<Type>(0.0);
+				}
+				const std::size_t rows = two ? 4 : 1;
+				for (std::size_t r = 0; r < rows; ++r) {
+					for (std::size_t e = 0; e < m; ++e) {
+						const Type* row = values.data() + offset[e] + r * stride;
+						const Type s = Details::num<Type>(wx[0][e]) * row[0] + Details::num<Type>(wx[1][e]) * row[1]
+						             + Details::num<Type>(wx[2][e]) * row[2] + Details::num<Type>(wx[3][e]) * row[3];
+						out[base + e] += two ? Details::num<Type>(wy[r][e]) * s : s;
+					}
+				}
+				for (std::size_t e = 0; e < m; ++e) {
+					if (nan[e])
+						out[base + e] = Details::num<Type>(std::numeric_limits<double>::quiet_NaN());
+				}
+			}
+		}
+
+		/** @brief interpolate for every elements with threads */
+		void eval_batch(std::size_t n, const Type* const* columns, Type* out, std::size_t threads) const
+		{
+			Details::parallel_for(n, 16 * BLOCK, threads,
+				[&](std::size_t begin, std::size_t end, std::size_t)
+				{
+					const Type* cols[2] = { columns[0] + begin, (axes.size() == 2) ? columns[1] + begin : nullptr };
+					eval_batch(end - begin, cols, out + begin);
+				});
+		}
+
+		/**
+		 * @brief compare the interpolation with direct evaluation of the program at random points
+		 *
+		 * @param samples the number of points
+		 * @param seed    seed of the points
+		 * @param threads the number of threads. `0` means the number of hardware threads.
+		 * @return `Report` maximum absolute, relative and rms error
+		 */
+		Report compare(std::size_t samples = 65536, std::uint64_t seed = 0, std::size_t threads = 0) const
+		{
+			std::vector<std::vector<Type>> cols(axes.size(), std::vector<Type>(samples));
+			Details::CounterRNG rng(seed, 0);
+			for (std::size_t i = 0; i < samples; ++i) {
+				for (std::size_t k = 0; k < axes.size(); ++k) {
+					cols[k][i] = Details::num<Type>(axes[k].min + (axes[k].max - axes[k].min) * rng.uniform());
+				}
+			}
+			const Type* columns[2] = { cols[0].data(), (axes.size() == 2) ? cols[1].data() : nullptr };
+
+			std::vector<Type> direct(samples), table(samples);
+			program.eval_batch(samples, columns, direct.data(), threads);
+			eval_batch(samples, columns, table.data(), threads);
+
+			Report report;
+			double sum = 0.0;
+			for (std::size_t i = 0; i < samples; ++i) {
+				const double f = static_cast<double>(direct[i]);
+				if (!std::isfinite(f))
+					continue;
+				const double e = std::abs(static_cast<double>(table[i]) - f);
+				report.max_abs = std::max(report.max_abs, e);
+				if (f != 0.0)
+					report.max_rel = std::max(report.max_rel, e / std::abs(f));
+				sum += e * e;
+				report.samples++;
+			}
+			if (report.samples > 0)
+				report.rms_abs = std::sqrt(sum / static_cast<double>(report.samples));
+			return report;
+		}
+
+		/** @return `std::size_t` the number of values in the table including ghost points */
+		std::size_t size(void) const noexcept { return values.size(); }
+	};
+}
+
+#endif /* end of __SYAMFP_LOOKUP_HPP__ */
@@ -0,0 +1,492 @@
+/**
+ * @file syamfp_mmap.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Batch evaluation over memory-mapped binary columns (.npy and raw float64 / complex128)
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * @note POSIX only (mmap).
+ */
+
+#ifndef __SYAMFP_MMAP_HPP__
+#define __SYAMFP_MMAP_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @brief file mapped into memory. the mapping is released by the destructor */
+		class MappedFile
+		{
+		private:
+			int         fd   = -1;
+			void*       addr = nullptr;
+			std::size_t len  = 0;
+
+			void release(void) noexcept
+			{
+				if (addr != nullptr)
+					::munmap(addr, len);
+				if (fd >= 0)
+					::close(fd);
+				fd   = -1;
+				addr = nullptr;
+				len  = 0;
+			}
+
+		public:
+			MappedFile() = default;
+
+			/**
+			 * @param path     file path
+			 * @param writable map for writing. the file is created or truncated to `size` bytes.
+			 * @param size     size of the file created for writing
+			 * @throw `std::runtime_error` if the file cannot be opened or mapped
+			 */
+			MappedFile(const std::string& path, bool writable, std::size_t size = 0)
+			{
+				fd = writable ? ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : ::open(path.c_str(), O_RDONLY);
+				if (fd < 0) {
+					throw std::runtime_error("MappedFile: cannot open " + path);
+				}
+
+				if (writable) {
+					if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+						release();
+						throw std::runtime_error("MappedFile: cannot resize " + path);
+					}
+					len = size;
+				} else {
+					struct stat st;
+					if (::fstat(fd, &st) != 0) {
+						release();
+						throw std::runtime_error("MappedFile: cannot stat " + path);
+					}
+					len = static_cast<std::size_t>(st.st_size);
+				}
+
+				if (len == 0)
+					return;  /* empty file is not mapped */
+				addr = ::mmap(nullptr, len, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+				if (addr == MAP_FAILED) {
+					addr = nullptr;
+					release();
+					throw std::runtime_error("MappedFile: cannot map " + path);
+				}
+				::madvise(addr, len, MADV_SEQUENTIAL);
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			MappedFile(MappedFile&& other) noexcept
+				: fd(std::exchange(other.fd, -1)), addr(std::exchange(other.addr, nullptr)), len(std::exchange(other.len, 0)) {}
+
+			MappedFile& operator=(MappedFile&& other) noexcept
+			{
+				if (this != &other) {
+					release();
+					fd   = std::exchange(other.fd, -1);
+					addr = std::exchange(other.addr, nullptr);
+					len  = std::exchange(other.len, 0);
+				}
+				return *this;
+			}
+
+			~MappedFile() { release(); }
+
+			/**
+			 * @brief drop the pages of [offset, offset + bytes) from this process
+			 * @note  written data is kept in the shared mapping, and the pages are read again if they are accessed.
+			 */
+			void release_pages(std::size_t offset, std::size_t bytes) const noexcept
+			{
+				if (addr == nullptr)
+					return;
+				const std::size_t page  = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+				const std::size_t begin = (offset + page - 1) / page * page;  /* whole pages inside the range */
+				const std::size_t end   = std::min(offset + bytes, len) / page * page;
+				if (begin < end)
+					::madvise(static_cast<char*>(addr) + begin, end - begin, MADV_DONTNEED);
+			}
+
+			/** @brief write the dirty pages of [offset, offset + bytes) back to the file without waiting */
+			void flush(std::size_t offset, std::size_t bytes) const noexcept
+			{
+				if (addr == nullptr)
+					return;
+				const std::size_t page  = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+				const std::size_t begin = offset / page * page;
+				::msync(static_cast<char*>(addr) + begin, std::min(offset + bytes, len) - begin, MS_ASYNC);
+			}
+
+			char*       data(void) noexcept       { return static_cast<char*>(addr); }
+			const char* data(void) const noexcept { return static_cast<const char*>(addr); }
+			std::size_t size(void) const noexcept { return len; }
+		};
+
+		/** @return `const char*` numpy type string of the element, which is little-endian */
+		template <MathConcept Type>
+		constexpr const char* npy_descr(void)
+		{
+			if constexpr (std::is_same_v<Type, double>)
+				return "<f8";
+			else if constexpr (std::is_same_v<Type, std::complex<double>>)
+				return "<c16";
+			else
+				static_assert(std::is_same_v<Type, double>, "npy_descr(): only double and std::complex<double> are supported");
+		}
+
+		/**
+		 * @brief make the header of .npy version 1.0 padded to 64 bytes
+		 * @param shape dimensions of the array in C order
+		 */
+		template <MathConcept Type>
+		std::string npy_header(const std::vector<std::size_t>& shape)
+		{
+			std::string dims;
+			for (std::size_t k = 0; k < shape.size(); ++k) {
+				dims += (k == 0 ? "" : ", ") + std::to_string(shape[k]);
+			}
+			if (shape.size() == 1)
+				dims += ',';  /* tuple of one element like "(n,)" */
+			std::string dict = std::string("{'descr': '") + npy_descr<Type>() + "', 'fortran_order': False, 'shape': (" + dims + "), }";
+
+			/* magic, version, length, and the dictionary padded by spaces with a line feed */
+			constexpr std::size_t ALIGN = 64;
+			const std::size_t total = (10 + dict.size() + 1 + ALIGN - 1) / ALIGN * ALIGN;
+			dict.append(total - 10 - dict.size() - 1, ' ');
+			dict += '\n';
+			const std::size_t len = dict.size();
+			return std::string("\x93NUMPY\x01\x00", 8) + static_cast<char>(len & 0xff) + static_cast<char>(len >> 8) + dict;
+		}
+
+		/** @return `std::string` value of the key in the header dictionary of .npy like "{'descr': '<f8', ...}" */
+		inline std::string npy_value(const std::string& header, const std::string& key)
+		{
+			std::size_t pos = header.find("'" + key + "'");
+			if (pos == std::string::npos)
+				return std::string();
+			pos = header.find(':', pos);
+			if (pos == std::string::npos)
+				return std::string();
+			pos = header.find_first_not_of(' ', pos + 1);
+			if (pos == std::string::npos)
+				return std::string();
+
+			const char open = header[pos];
+			const char close = (open == '(') ? ')' : (open == '\'' || open == '"') ? open : ',';
+			const std::size_t end = header.find(close, pos + 1);
+			if (end == std::string::npos)
+				return std::string();
+			return (close == ',') ? header.substr(pos, end - pos) : header.substr(pos + 1, end - pos - 1);
+		}
+	}
+
+
+	/**
+	 * @brief binary column mapped into memory, in .npy or raw format
+	 *
+	 * The elements are used in place: no parse nor copy. `Type` is double (float64, '<f8')
+	 * or std::complex<double> (complex128, '<c16'), little-endian. An array of .npy with any shape is
+	 * used as a flat column in C order, and Fortran order is rejected unless only one dimension is longer than 1.
+	 */
+	template <Details::MathConcept Type>
+	class MappedArray
+	{
+	public:
+		enum class Format
+		{
+			Auto,  /* .npy if the path ends with ".npy", otherwise raw */
+			Npy,
+			Raw,
+		};
+
+	private:
+		Details::MappedFile file;
+		std::size_t         offset = 0;  /* bytes before the first element */
+		std::size_t         count  = 0;
+
+		static Format resolve(const std::string& path, Format format)
+		{
+			if (format != Format::Auto)
+				return format;
+			return (path.size() >= 4 && path.compare(path.size() - 4, 4, ".npy") == 0) ? Format::Npy : Format::Raw;
+		}
+
+		static void check_endian(void)
+		{
+			if constexpr (std::endian::native != std::endian::little) {
+				throw std::runtime_error("MappedArray: big-endian machine is not supported");
+			}
+		}
+
+		/** @brief read the header of .npy */
+		void parse_npy(const std::string& path)
+		{
+			const char* p = file.data();
+			if (file.size() < 10 || std::memcmp(p, "\x93NUMPY", 6) != 0) {
+				throw std::invalid_argument("MappedArray: " + path + " is not .npy");
+			}
+
+			const unsigned char major = static_cast<unsigned char>(p[6]);
+			std::size_t header_len, start;
+			if (major == 1) {
+				header_len = static_cast<unsigned char>(p[8]) | (static_cast<std::size_t>(static_cast<unsigned char>(p[9])) << 8);
+				start = 10;
+			} else {
+				if (file.size() < 12) {
+					throw std::invalid_argument("MappedArray: " + path + " is broken");
+				}
+				header_len = 0;
+				for (int k = 3; k >= 0; --k) {
+					header_len = (header_len << 8) | static_cast<unsigned char>(p[8 + k]);
+				}
+				start = 12;
+			}
+			if (start + header_len > file.size()) {
+				throw std::invalid_argument("MappedArray: " + path + " is broken");
+			}
+
+			const std::string header(p + start, header_len);
+			const std::string descr = Details::npy_value(header, "descr");
+			if (descr != Details::npy_descr<Type>() && !(descr == "=f8" && std::is_same_v<Type, double>)) {
+				throw std::invalid_argument("MappedArray: the type of " + path + " is " + descr + ", not " + Details::npy_descr<Type>());
+			}
+
+			/* shape like "(100,)", "(10, 10)" or "()" */
+			const std::string shape = Details::npy_value(header, "shape");
+			count = 1;
+			std::size_t pos = 0, extents = 0;  /* extents: dimensions longer than 1 */
+			while ((pos = shape.find_first_of("0123456789", pos)) != std::string::npos) {
+				std::size_t end = shape.find_first_not_of("0123456789", pos);
+				const std::size_t n = std::stoull(shape.substr(pos, end - pos));
+				count *= n;
+				extents += (n > 1) ? 1 : 0;
+				pos = end;
+			}
+
+			/* the elements of Fortran order are not in C order, unless the array is a vector */
+			if (Details::npy_value(header, "fortran_order") != "False" && extents > 1) {
+				throw std::invalid_argument("MappedArray: " + path + " is in Fortran order");
+			}
+
+			offset = start + header_len;
+			if (offset % alignof(Type) != 0) {
+				throw std::invalid_argument("MappedArray: the data of " + path + " is not aligned");
+			}
+			if (offset + count * sizeof(Type) > file.size()) {
+				throw std::invalid_argument("MappedArray: " + path + " is shorter than its shape");
+			}
+		}
+
+	public:
+		MappedArray() = default;
+
+		/**
+		 * @brief map the file for reading
+		 * @throw `std::runtime_error` if the file cannot be mapped
+		 * @throw `std::invalid_argument` if the file is not .npy of `Type`, or the size of raw file is not a multiple of the element
+		 */
+		static MappedArray open(const std::string& path, Format format = Format::Auto)
+		{
+			check_endian();
+			MappedArray array;
+			array.file = Details::MappedFile(path, false);
+			if (resolve(path, format) == Format::Npy) {
+				array.parse_npy(path);
+			} else {
+				if (array.file.size() % sizeof(Type) != 0) {
+					throw std::invalid_argument("MappedArray: the size of " + path + " is not a multiple of the element");
+				}
+				array.count = array.file.size() / sizeof(Type);
+			}
+			return array;
+		}
+
+		/**
+		 * @brief create the file of `n` elements and map it for writing
+		 * @throw `std::runtime_error` if the file cannot be created
+		 */
+		static MappedArray create(const std::string& path, std::size_t n, Format format = Format::Auto)
+		{
+			check_endian();
+			const std::string header = (resolve(path, format) == Format::Npy) ? Details::npy_header<Type>({ n }) : std::string();
+
+			MappedArray array;
+			array.file   = Details::MappedFile(path, true, header.size() + n * sizeof(Type));
+			array.offset = header.size();
+			array.count  = n;
+			if (!header.empty())
+				std::memcpy(array.file.data(), header.data(), header.size());
+			return array;
+		}
+
+		/** @return `const Type*` elements */
+		const Type* data(void) const noexcept { return reinterpret_cast<const Type*>(file.data() + offset); }
+
+		/** @return `Type*` elements of the array created for writing */
+		Type* data(void) noexcept { return reinterpret_cast<Type*>(file.data() + offset); }
+
+		/** @return `std::size_t` the number of elements */
+		std::size_t size(void) const noexcept { return count; }
+
+		/** @brief drop the pages of the elements [begin, end) from this process after use */
+		void release(std::size_t begin, std::size_t end) const noexcept
+		{
+			file.release_pages(offset + begin * sizeof(Type), (end - begin) * sizeof(Type));
+		}
+
+		/** @brief write the elements [begin, end) back to the file without waiting */
+		void flush(std::size_t begin, std::size_t end) const noexcept
+		{
+			file.flush(offset + begin * sizeof(Type), (end - begin) * sizeof(Type));
+		}
+	};
+
+
+	/**
+	 * @brief batch evaluation of a program over memory-mapped columns into a memory-mapped file
+	 *
+	 * The columns are passed to eval_batch() in place, and the results are written in the output mapping.
+	 * The files are processed by chunks, and the pages of finished chunks are released,
+	 * so files larger than the memory stream through.
+	 */
+	template <Details::MathConcept Type = double>
+	class MappedEvaluator
+	{
+	public:
+		using Format = typename MappedArray<Type>::Format;
+
+		struct Option
+		{
+			std::size_t chunk   = std::size_t(1) << 20;  /* elements per chunk */
+			std::size_t threads = 0;                     /* 0 means the number of hardware threads */
+			Format      format  = Format::Auto;          /* format of the input and output files */
+		};
+
+	private:
+		Program<Type> program;
+
+	public:
+		/** @param program program of which free variables are the columns */
+		MappedEvaluator(const Program<Type>& program)
+			: program(program) {}
+
+		/**
+		 * @brief compile the formula
+		 *
+		 * @param formula   formula like "x*y + sin(z)"
+		 * @param variables names of the free variables in the order of the input files
+		 * @param table     values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		MappedEvaluator(const std::string& formula, const std::vector<std::string>& variables,
+		                const VariableTable<Type>& table = VariableTable<Type>())
+		{
+			program = Syamfp<Type>::compile(formula, variables, table);
+		}
+
+		~MappedEvaluator() = default;
+
+		/**
+		 * @brief evaluate the program for every elements of the input files
+		 *
+		 * @param inputs `inputs[k]` is the file of k-th free variable
+		 * @param output file of the results, which is created or overwritten
+		 * @param option size of chunks and the number of threads
+		 * @return `std::size_t` the number of elements
+		 * @throw `std::invalid_argument` if the number of files or elements are not equal, or the output is an input
+		 * @throw `std::runtime_error` if the files cannot be mapped
+		 */
+		std::size_t run(const std::vector<std::string>& inputs, const std::string& output, const Option& option = Option()) const
+		{
+			if (inputs.size() != program.variable_num()) {
+				throw std::invalid_argument("MappedEvaluator: the number of input files must be the number of variables");
+			}
+
+			std::vector<MappedArray<Type>> columns;
+			for (const std::string& path : inputs) {
+				columns.push_back(MappedArray<Type>::open(path, option.format));
+				if (columns.back().size() != columns.front().size()) {
+					throw std::invalid_argument("MappedEvaluator: the input files have different numbers of elements");
+				}
+			}
+			const std::size_t n = columns.empty() ? 1 : columns.front().size();
+
+			/* creating the output truncates it, and the mapping of the same file as an input would be cut off */
+			struct stat out_st;
+			if (::stat(output.c_str(), &out_st) == 0) {
+				for (const std::string& path : inputs) {
+					struct stat in_st;
+					if (::stat(path.c_str(), &in_st) == 0 && in_st.st_dev == out_st.st_dev && in_st.st_ino == out_st.st_ino) {
+						throw std::invalid_argument("MappedEvaluator: the output " + output + " is the input " + path);
+					}
+				}
+			}
+			MappedArray<Type> result = MappedArray<Type>::create(output, n, option.format);
+
+			const std::size_t chunk = std::max<std::size_t>(option.chunk, 1);
+			std::vector<const Type*> cols(columns.size());
+			for (std::size_t begin = 0; begin < n; begin += chunk) {
+				const std::size_t end = std::min(begin + chunk, n);
+				for (std::size_t k = 0; k < columns.size(); ++k) {
+					cols[k] = columns[k].data() + begin;
+				}
+				program.eval_batch(end - begin, cols.data(), result.data() + begin, option.threads);
+
+				for (const MappedArray<Type>& column : columns) {
+					column.release(begin, end);
+				}
+				result.flush(begin, end);
+				result.release(begin, end);
+			}
+			return n;
+		}
+	};
+
+
+	/**
+	 * @brief evaluate the formula over memory-mapped binary columns
+	 *
+	 * @param formula   formula like "x*y + sin(z)"
+	 * @param variables names of the free variables
+	 * @param inputs    `inputs[k]` is the .npy or raw file of k-th variable
+	 * @param output    file of the results
+	 * @param table     values of the other variables
+	 * @param option    size of chunks and the number of threads
+	 * @return `std::size_t` the number of elements
+	 * @throw `std::invalid_argument` if the formula is invalid, or the files do not match
+	 * @throw `std::runtime_error` if unknown variable is included in formula, or the files cannot be mapped
+	 */
+	template <Details::MathConcept Type = double>
+	std::size_t eval_mapped(const std::string& formula, const std::vector<std::string>& variables,
+	                        const std::vector<std::string>& inputs, const std::string& output,
+	                        const VariableTable<Type>& table = VariableTable<Type>(),
+	                        const typename MappedEvaluator<Type>::Option& option = typename MappedEvaluator<Type>::Option())
+	{
+		return MappedEvaluator<Type>(formula, variables, table).run(inputs, output, option);
+	}
+}
+
+#endif /* end of __SYAMFP_MMAP_HPP__ */
@@ -0,0 +1,186 @@
+/**
+ * @file syamfp_newton.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Newton fractal and basin of attraction renderer
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_NEWTON_HPP__
+#define __SYAMFP_NEWTON_HPP__
+
+#include "syamfp.hpp"
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	/**
+	 * @brief renderer of Newton's method `z <- z - a f(z) / f'(z)` over a complex pixel grid
+	 *
+	 * f'(z) is calculated by automatic differentiation of the compiled formula, and pixels are
+	 * iterated `Program::BLOCK` lanes at once. Converged lanes are removed from the block at each step,
+	 * so that the remaining lanes keep the batch evaluation dense.
+	 */
+	template <Details::MathConcept Type = std::complex<double>>
+	class NewtonRenderer
+	{
+	public:
+		struct Option
+		{
+			std::size_t max_iter       = 100;
+			double      tolerance      = 1e-10;  /* converged if |step| < tolerance */
+			double      root_tolerance = 1e-6;   /* converged points closer than this are the same root */
+			Type        relaxation     = Details::num<Type>(1.0); /* `a` of z - a f/f' */
+			std::vector<Type> roots;             /* known roots. Indices of these roots are kept in the result */
+			std::size_t threads        = 0;      /* 0 means the number of hardware threads */
+		};
+
+		struct Result
+		{
+			std::size_t width  = 0;
+			std::size_t height = 0;
+			std::vector<int>         root_index;  /* index in `roots`, or -1 if not converged */
+			std::vector<std::size_t> iterations;
+			std::vector<Type>        roots;
+		};
+
+	private:
+		Program<Type> program;
+
+		static double norm(const Type& value)
+		{
+			using std::norm;
+			return static_cast<double>(norm(value));
+		}
+
+		/** @brief iterate `n` pixels and write converged points into `z` */
+		void iterate(std::size_t n, Type* z, std::uint8_t* converged, std::size_t* iterations,
+		             const Option& option, typename Program<Type>::Workspace& ws) const
+		{
+			constexpr std::size_t BLOCK = Program<Type>::BLOCK;
+			const double tol2 = option.tolerance * option.tolerance;
+
+			std::array<Type, BLOCK> zs, fs, dfs;
+			std::array<std::size_t, BLOCK> lane; /* pixel of each lane */
+			const Type* columns[1] = { zs.data() };
+
+			for (std::size_t base = 0; base < n; base += BLOCK) {
+				std::size_t m = std::min(BLOCK, n - base);
+				for (std::size_t i = 0; i < m; ++i) {
+					lane[i] = base + i;
+					zs[i]   = z[base + i];
+					converged[base + i]  = 0;
+					iterations[base + i] = option.max_iter;
+				}
+
+				for (std::size_t it = 0; it < option.max_iter && m != 0; ++it) {
+					program.eval_batch_derivative(m, columns, 0, fs.data(), dfs.data(), ws);
+
+					/* update lanes and compact the active ones */
+					std::size_t active = 0;
+					for (std::size_t i = 0; i < m; ++i) {
+						const Type step = option.relaxation * fs[i] / dfs[i];
+						const Type next = zs[i] - step;
+						const double s2 = norm(step);
+
+						if (!std::isfinite(s2)) {
+							z[lane[i]] = zs[i];
+							iterations[lane[i]] = it + 1;
+						} else if (s2 < tol2) {
+							z[lane[i]] = next;
+							converged[lane[i]]  = 1;
+							iterations[lane[i]] = it + 1;
+						} else {
+							zs[active]   = next;
+							lane[active] = lane[i];
+							active++;
+						}
+					}
+					m = active;
+				}
+			}
+		}
+
+	public:
+		/**
+		 * @brief compile formula `f(z)`
+		 *
+		 * @param formula formula like "z^3 - 1"
+		 * @param table   values of the other variables
+		 * @param z       variable string
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		NewtonRenderer(const std::string& formula, const VariableTable<Type>& table = VariableTable<Type>(),
+		               const std::string& z = "z")
+		{
+			program = Syamfp<Type>::compile(formula, {z}, table);
+		}
+
+		~NewtonRenderer() = default;
+
+		/**
+		 * @brief render converged root and iteration count of every pixel
+		 *
+		 * @param center     z at the center of the image
+		 * @param pixel_size width of one pixel in the complex plane
+		 * @param width      the number of pixels in a row
+		 * @param height     the number of rows
+		 * @param option     options of rendering
+		 * @return `Result`  root index and iteration count of each pixel (row major, top row first)
+		 */
+		Result render(const Type& center, double pixel_size, std::size_t width, std::size_t height,
+		              const Option& option = Option()) const
+		{
+			const std::size_t n = width * height;
+
+			Result result;
+			result.width  = width;
+			result.height = height;
+			result.root_index.assign(n, -1);
+			result.iterations.assign(n, 0);
+			result.roots = option.roots;
+
+			std::vector<Type> z(n);
+			for (std::size_t p = 0; p < n; ++p) {
+				const double x = (static_cast<double>(p % width) - 0.5 * static_cast<double>(width)) * pixel_size;
+				const double y = (0.5 * static_cast<double>(height) - static_cast<double>(p / width)) * pixel_size;
+				z[p] = center + static_cast<Type>(std::complex<Details::ValueType>(x, y));
+			}
+
+			std::vector<std::uint8_t> converged(n, 0);
+			std::vector<typename Program<Type>::Workspace> wss(Details::ret_thread_num(option.threads), program.make_workspace());
+			Details::parallel_for(n, 16 * Program<Type>::BLOCK, wss.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					iterate(end - begin, z.data() + begin, converged.data() + begin, result.iterations.data() + begin, option, wss[worker]);
+				});
+
+			/* classify roots in pixel order, so that the indices do not depend on the threads */
+			const double root2 = option.root_tolerance * option.root_tolerance;
+			for (std::size_t p = 0; p < n; ++p) {
+				if (!converged[p])
+					continue;
+
+				auto it = std::ranges::find_if(result.roots, [&](const Type& root) { return norm(z[p] - root) < root2; });
+				if (it == result.roots.end()) {
+					result.roots.push_back(z[p]);
+					it = result.roots.end() - 1;
+				}
+				result.root_index[p] = static_cast<int>(it - result.roots.begin());
+			}
+
+			return result;
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_NEWTON_HPP__ */
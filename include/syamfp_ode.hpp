@@ -0,0 +1,438 @@
+/**
+ * @file syamfp_ode.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Ensemble ODE integrator of compiled right-hand sides
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_ODE_HPP__
+#define __SYAMFP_ODE_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @brief Butcher tableau of Dormand-Prince 5(4) */
+		constexpr std::array<double, 7> DOPRI_C = { 0.0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1.0, 1.0 };
+
+		constexpr std::array<std::array<double, 6>, 7> DOPRI_A =
+		{{
+			{ 0, 0, 0, 0, 0, 0 },
+			{ 1.0 / 5, 0, 0, 0, 0, 0 },
+			{ 3.0 / 40, 9.0 / 40, 0, 0, 0, 0 },
+			{ 44.0 / 45, -56.0 / 15, 32.0 / 9, 0, 0, 0 },
+			{ 19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729, 0, 0 },
+			{ 9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656, 0 },
+			{ 35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84 },
+		}};
+
+		/** @brief difference of the weights of 5th and 4th order solution */
+		constexpr std::array<double, 7> DOPRI_E =
+		{
+			71.0 / 57600, 0.0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200, 22.0 / 525, -1.0 / 40
+		};
+	}
+
+
+	/**
+	 * @brief system of ODE `dx_i/dt = f_i(x, t, params)` integrated over many initial conditions at once
+	 *
+	 * States are given in SoA: `states[i * n + m]` is the i-th component of the m-th member.
+	 * Members are split into chunks of `CHUNK`, each chunk is integrated by one thread, and each
+	 * right-hand side is evaluated for all members of the chunk by batch evaluation.
+	 * Members can have their own parameters ("member parameters"), given in SoA as well.
+	 */
+	template <Details::MathConcept Type = double>
+	class OdeSystem
+	{
+	public:
+		/** @brief the number of members integrated together */
+		static constexpr std::size_t CHUNK = 4 * Program<Type>::BLOCK;
+
+		/** @brief options of the adaptive integration */
+		struct Option
+		{
+			double      rtol      = 1e-6;
+			double      atol      = 1e-9;
+			double      h0        = 0.0;     /* initial step. 0 means estimated from the right-hand side */
+			double      h_min     = 0.0;     /* the member fails if the step becomes smaller than this */
+			std::size_t max_steps = 100000;  /* the member fails if the number of steps exceeds this */
+			std::size_t threads   = 0;       /* 0 means the number of hardware threads */
+		};
+
+		/** @brief statistics of each member of the adaptive integration */
+		struct Result
+		{
+			std::vector<std::uint8_t>  success;   /* 0 if the member failed. its state is at the failed time */
+			std::vector<std::uint32_t> accepted;
+			std::vector<std::uint32_t> rejected;
+		};
+
+	private:
+		std::vector<Program<Type>> programs;
+		std::size_t dim;
+		std::size_t member_num;
+
+		/** @brief buffers of one thread. arrays of components have stride CHUNK */
+		struct Worker
+		{
+			std::vector<typename Program<Type>::Workspace> ws;
+			std::vector<const Type*> columns;
+			std::vector<Type> y, ys, ms, ts;
+			std::array<std::vector<Type>, 7> k;
+			std::vector<double> t, h;
+			std::vector<std::size_t> lane;
+			std::vector<std::uint32_t> accepted, rejected;
+		};
+
+		static double mag(const Type& value)
+		{
+			using std::abs;
+			return static_cast<double>(abs(value));
+		}
+
+		Worker make_worker(void) const
+		{
+			Worker w;
+			for (const Program<Type>& program : programs) {
+				w.ws.push_back(program.make_workspace());
+			}
+			w.columns.resize(dim + 1 + member_num);
+			w.y.resize(dim * CHUNK);
+			w.ys.resize(dim * CHUNK);
+			w.ms.resize(member_num * CHUNK);
+			w.ts.resize(CHUNK);
+			for (std::vector<Type>& k : w.k) {
+				k.resize(dim * CHUNK);
+			}
+			w.t.resize(CHUNK);
+			w.h.resize(CHUNK);
+			w.lane.resize(CHUNK);
+			w.accepted.resize(CHUNK);
+			w.rejected.resize(CHUNK);
+			return w;
+		}
+
+		/** @brief `k[i * CHUNK + l] = f_i(y, ts, ms)` for `m` lanes */
+		void eval(std::size_t m, const Type* y, Type* k, Worker& w) const
+		{
+			for (std::size_t j = 0; j < dim; ++j) {
+				w.columns[j] = y + j * CHUNK;
+			}
+			w.columns[dim] = w.ts.data();
+			for (std::size_t p = 0; p < member_num; ++p) {
+				w.columns[dim + 1 + p] = w.ms.data() + p * CHUNK;
+			}
+			for (std::size_t i = 0; i < dim; ++i) {
+				programs[i].eval_batch(m, w.columns.data(), k + i * CHUNK, w.ws[i]);
+			}
+		}
+
+		/** @brief copy members [begin, end) into the buffers of the worker */
+		void load(std::size_t n, std::size_t begin, std::size_t end, const Type* states, const Type* members, Worker& w) const
+		{
+			for (std::size_t j = 0; j < dim; ++j) {
+				std::copy(states + j * n + begin, states + j * n + end, w.y.begin() + j * CHUNK);
+			}
+			for (std::size_t p = 0; p < member_num; ++p) {
+				std::copy(members + p * n + begin, members + p * n + end, w.ms.begin() + p * CHUNK);
+			}
+		}
+
+		void rk4_chunk(std::size_t n, std::size_t begin, std::size_t end, Type* states, const Type* members,
+		               double t0, double t1, std::size_t steps, Worker& w) const
+		{
+			const std::size_t c = end - begin;
+			const double h = (t1 - t0) / static_cast<double>(steps);
+			const Type half = Details::num<Type>(0.5 * h), full = Details::num<Type>(h), sixth = Details::num<Type>(h / 6.0), two = Details::num<Type>(2.0);
+			Type* y  = w.y.data();
+			Type* ys = w.ys.data();
+
+			load(n, begin, end, states, members, w);
+
+			for (std::size_t s = 0; s < steps; ++s) {
+				const double t = t0 + static_cast<double>(s) * h;
+
+				std::fill_n(w.ts.begin(), c, Details::num<Type>(t));
+				eval(c, y, w.k[0].data(), w);
+
+				std::fill_n(w.ts.begin(), c, Details::num<Type>(t + 0.5 * h));
+				for (std::size_t j = 0; j < dim; ++j) {
+					for (std::size_t l = j * CHUNK; l < j * CHUNK + c; ++l) {
+						ys[l] = y[l] + half * w.k[0][l];
+					}
+				}
+				eval(c, ys, w.k[1].data(), w);
+
+				for (std::size_t j = 0; j < dim; ++j) {
+					for (std::size_t l = j * CHUNK; l < j * CHUNK + c; ++l) {
+						ys[l] = y[l] + half * w.k[1][l];
+					}
+				}
+				eval(c, ys, w.k[2].data(), w);
+
+				std::fill_n(w.ts.begin(), c, Details::num<Type>(t + h));
+				for (std::size_t j = 0; j < dim; ++j) {
+					for (std::size_t l = j * CHUNK; l < j * CHUNK + c; ++l) {
+						ys[l] = y[l] + full * w.k[2][l];
+					}
+				}
+				eval(c, ys, w.k[3].data(), w);
+
+				for (std::size_t j = 0; j < dim; ++j) {
+					for (std::size_t l = j * CHUNK; l < j * CHUNK + c; ++l) {
+						y[l] += sixth * (w.k[0][l] + two * (w.k[1][l] + w.k[2][l]) + w.k[3][l]);
+					}
+				}
+			}
+
+			for (std::size_t j = 0; j < dim; ++j) {
+				std::copy_n(w.y.begin() + j * CHUNK, c, states + j * n + begin);
+			}
+		}
+
+		void dopri_chunk(std::size_t n, std::size_t begin, std::size_t end, Type* states, const Type* members,
+		                 double t0, double t1, const Option& option, Result& result, Worker& w) const
+		{
+			using namespace Details;
+
+			std::size_t m = end - begin;
+			Type* y  = w.y.data();
+			Type* ys = w.ys.data();
+
+			load(n, begin, end, states, members, w);
+			for (std::size_t l = 0; l < m; ++l) {
+				w.lane[l]     = begin + l;
+				w.t[l]        = t0;
+				w.accepted[l] = 0;
+				w.rejected[l] = 0;
+			}
+			std::fill_n(w.ts.begin(), m, Details::num<Type>(t0));
+			eval(m, y, w.k[0].data(), w);
+
+			/* initial step from the scale of the state and the derivative */
+			for (std::size_t l = 0; l < m; ++l) {
+				double d0 = 0.0, d1 = 0.0;
+				for (std::size_t j = 0; j < dim; ++j) {
+					const double sc = option.atol + option.rtol * mag(y[j * CHUNK + l]);
+					d0 += std::pow(mag(y[j * CHUNK + l]) / sc, 2);
+					d1 += std::pow(mag(w.k[0][j * CHUNK + l]) / sc, 2);
+				}
+				d0 = std::sqrt(d0 / static_cast<double>(dim));
+				d1 = std::sqrt(d1 / static_cast<double>(dim));
+				const double h = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0 / d1;
+				w.h[l] = std::min((option.h0 > 0.0) ? option.h0 : h, t1 - t0);
+			}
+
+			/* finish the lane and write back the state */
+			auto finish = [&](std::size_t l, bool success)
+			{
+				const std::size_t member = w.lane[l];
+				for (std::size_t j = 0; j < dim; ++j) {
+					states[j * n + member] = y[j * CHUNK + l];
+				}
+				result.success[member]  = success ? 1 : 0;
+				result.accepted[member] = w.accepted[l];
+				result.rejected[member] = w.rejected[l];
+			};
+
+			while (m != 0) {
+				for (std::size_t l = 0; l < m; ++l) {
+					w.h[l] = std::min(w.h[l], t1 - w.t[l]);
+				}
+
+				/* stages 2 .. 7. the 7th stage is the 5th order solution */
+				for (std::size_t s = 1; s < 7; ++s) {
+					for (std::size_t l = 0; l < m; ++l) {
+						w.ts[l] = Details::num<Type>(w.t[l] + DOPRI_C[s] * w.h[l]);
+					}
+					for (std::size_t j = 0; j < dim; ++j) {
+						for (std::size_t l = 0; l < m; ++l) {
+							const std::size_t x = j * CHUNK + l;
+							Type sum = Details::num<Type>(DOPRI_A[s][0]) * w.k[0][x];
+							for (std::size_t q = 1; q < s; ++q) {
+								sum += Details::num<Type>(DOPRI_A[s][q]) * w.k[q][x];
+							}
+							ys[x] = y[x] + Details::num<Type>(w.h[l]) * sum;
+						}
+					}
+					eval(m, ys, w.k[s].data(), w);
+				}
+
+				/* error control and compaction of the active lanes */
+				std::size_t active = 0;
+				for (std::size_t l = 0; l < m; ++l) {
+					double err = 0.0;
+					for (std::size_t j = 0; j < dim; ++j) {
+						const std::size_t x = j * CHUNK + l;
+						Type e = Details::num<Type>(DOPRI_E[0]) * w.k[0][x];
+						for (std::size_t q = 2; q < 7; ++q) {
+							e += Details::num<Type>(DOPRI_E[q]) * w.k[q][x];
+						}
+						const double sc = option.atol + option.rtol * std::max(mag(y[x]), mag(ys[x]));
+						err += std::pow(w.h[l] * mag(e) / sc, 2);
+					}
+					err = std::sqrt(err / static_cast<double>(dim));
+
+					const bool last = (w.h[l] >= t1 - w.t[l]);
+					double factor;
+					if (err <= 1.0) {
+						w.t[l] = last ? t1 : w.t[l] + w.h[l];
+						for (std::size_t j = 0; j < dim; ++j) {
+							y[j * CHUNK + l]      = ys[j * CHUNK + l];
+							w.k[0][j * CHUNK + l] = w.k[6][j * CHUNK + l];  /* first same as last */
+						}
+						w.accepted[l]++;
+						factor = (err == 0.0) ? 5.0 : std::clamp(0.9 * std::pow(err, -0.2), 0.2, 5.0);
+					} else {
+						w.rejected[l]++;
+						factor = std::isfinite(err) ? std::max(0.2, 0.9 * std::pow(err, -0.2)) : 0.2;
+					}
+					w.h[l] *= factor;
+
+					if (w.t[l] >= t1) {
+						finish(l, true);
+						continue;
+					}
+					if (w.accepted[l] + w.rejected[l] >= option.max_steps || w.h[l] < option.h_min
+					    || w.t[l] + w.h[l] == w.t[l]) {
+						finish(l, false);
+						continue;
+					}
+
+					if (active != l) {
+						for (std::size_t j = 0; j < dim; ++j) {
+							y[j * CHUNK + active]      = y[j * CHUNK + l];
+							w.k[0][j * CHUNK + active] = w.k[0][j * CHUNK + l];
+						}
+						for (std::size_t p = 0; p < member_num; ++p) {
+							w.ms[p * CHUNK + active] = w.ms[p * CHUNK + l];
+						}
+						w.t[active]        = w.t[l];
+						w.h[active]        = w.h[l];
+						w.lane[active]     = w.lane[l];
+						w.accepted[active] = w.accepted[l];
+						w.rejected[active] = w.rejected[l];
+					}
+					active++;
+				}
+				m = active;
+			}
+		}
+
+	public:
+		/**
+		 * @brief compile the right-hand sides
+		 *
+		 * @param rhs     formulas of `dx_i/dt` like {"y", "-x - 0.1*y"}
+		 * @param states  state variable strings like {"x", "y"}
+		 * @param time    time variable string
+		 * @param members member parameter strings given for each member
+		 * @param table   values of the other variables shared by all members
+		 * @throw `std::invalid_argument` if a formula is invalid or the numbers of formulas and states differ
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		OdeSystem(const std::vector<std::string>& rhs, const std::vector<std::string>& states,
+		          const std::string& time = "t", const std::vector<std::string>& members = {},
+		          const VariableTable<Type>& table = VariableTable<Type>())
+			: dim(states.size()), member_num(members.size())
+		{
+			if (rhs.size() != states.size() || states.empty()) {
+				throw std::invalid_argument("OdeSystem: the number of formulas must be equal to the number of states");
+			}
+
+			std::vector<std::string> variables = states;
+			variables.push_back(time);
+			variables.insert(variables.end(), members.begin(), members.end());
+
+			for (const std::string& formula : rhs) {
+				programs.push_back(Syamfp<Type>::compile(formula, variables, table));
+			}
+		}
+
+		~OdeSystem() = default;
+
+		/** @return `std::size_t` the number of state variables */
+		std::size_t dimension(void) const noexcept { return dim; }
+
+		/**
+		 * @brief integrate by the classical Runge-Kutta method with fixed steps
+		 *
+		 * @param n       the number of members
+		 * @param states  [in,out] `states[i * n + m]` is the i-th component of the m-th member
+		 * @param members `members[p * n + m]` is the p-th member parameter of the m-th member
+		 * @param t0, t1  interval of the integration
+		 * @param steps   the number of steps
+		 * @param threads the number of threads. `0` means the number of hardware threads.
+		 */
+		void rk4(std::size_t n, Type* states, const Type* members, double t0, double t1,
+		         std::size_t steps, std::size_t threads = 0) const
+		{
+			if (steps == 0)
+				return;
+
+			std::vector<Worker> workers(Details::ret_thread_num(threads));
+			for (Worker& w : workers) {
+				w = make_worker();
+			}
+			Details::parallel_for(n, CHUNK, workers.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					rk4_chunk(n, begin, end, states, members, t0, t1, steps, workers[worker]);
+				});
+		}
+
+		/**
+		 * @brief integrate by the Dormand-Prince 5(4) method with adaptive steps of each member
+		 *
+		 * @param n       the number of members
+		 * @param states  [in,out] `states[i * n + m]` is the i-th component of the m-th member
+		 * @param members `members[p * n + m]` is the p-th member parameter of the m-th member
+		 * @param t0, t1  interval of the integration
+		 * @param option  tolerances and limits
+		 * @return `Result` statistics of each member
+		 * @throw `std::invalid_argument` if t1 < t0
+		 */
+		Result dopri5(std::size_t n, Type* states, const Type* members, double t0, double t1,
+		              const Option& option = Option()) const
+		{
+			if (t1 < t0) {
+				throw std::invalid_argument("OdeSystem: t1 must not be less than t0");
+			}
+
+			Result result;
+			result.success.assign(n, 1);
+			result.accepted.assign(n, 0);
+			result.rejected.assign(n, 0);
+			if (t1 == t0)
+				return result;
+
+			std::vector<Worker> workers(Details::ret_thread_num(option.threads));
+			for (Worker& w : workers) {
+				w = make_worker();
+			}
+			Details::parallel_for(n, CHUNK, workers.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					dopri_chunk(n, begin, end, states, members, t0, t1, option, result, workers[worker]);
+				});
+			return result;
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_ODE_HPP__ */
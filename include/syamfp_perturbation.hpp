@@ -0,0 +1,465 @@
+/**
+ * @file syamfp_perturbation.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Deep zoom escape time renderer with perturbation theory
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_PERTURBATION_HPP__
+#define __SYAMFP_PERTURBATION_HPP__
+
+#include "syamfp.hpp"
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @brief type of per-pixel delta in perturbation */
+		using Delta = std::complex<double>;
+
+		/** @return `Delta` high precision complex number rounded to double */
+		template <typename High>
+		Delta narrow(const High& value)
+		{
+			if constexpr (std::is_constructible_v<Delta, High>) {
+				return static_cast<Delta>(value);
+			} else {
+				return Delta(static_cast<double>(value.real()), static_cast<double>(value.imag()));
+			}
+		}
+
+		/** @return `High` double complex number converted to high precision */
+		template <typename High>
+		High widen(const Delta& value)
+		{
+			if constexpr (std::is_constructible_v<High, Delta>) {
+				return static_cast<High>(value);
+			} else {
+				using Real = decltype(std::declval<High>().real());
+				return High(static_cast<Real>(value.real()), static_cast<Real>(value.imag()));
+			}
+		}
+
+		/** @return `Delta` exp(d) - 1 without cancellation for small d */
+		inline Delta expm1(const Delta& d)
+		{
+			const double s = std::sin(0.5 * d.imag());
+			return { std::expm1(d.real()) * std::cos(d.imag()) - 2.0 * s * s, std::exp(d.real()) * std::sin(d.imag()) };
+		}
+
+		/** @return `Delta` log(1 + w) without cancellation for small w */
+		inline Delta log1p(const Delta& w)
+		{
+			const double x = w.real();
+			const double y = w.imag();
+			return { 0.5 * std::log1p(2.0 * x + x * x + y * y), std::atan2(y, 1.0 + x) };
+		}
+
+		/** @return `Delta` (a + d)^n - a^n expanded by binomial theorem (n > 0) */
+		inline Delta binomial_delta(const Delta& a, const Delta& d, int n)
+		{
+			/* pw[k] = a^k */
+			std::array<Delta, POW_INT_MAX + 1> pw;
+			pw[0] = 1.0;
+			for (int k = 1; k < n; ++k) {
+				pw[k] = pw[k - 1] * a;
+			}
+
+			/* Horner's method for sum_{k=1}^{n} C(n,k) a^(n-k) d^k */
+			Delta  result = 0.0;
+			double binom  = 1.0; /* C(n, k) */
+			for (int k = n; k >= 1; --k) {
+				result = (result + binom * pw[n - k]) * d;
+				binom  = binom * k / (n - k + 1);
+			}
+			return result;
+		}
+	}
+
+
+	/**
+	 * @brief escape time renderer of `z <- f(z, c)` with perturbation theory
+	 *
+	 * One reference orbit is calculated with `HighType` (complex number with high precision),
+	 * and the differences from the reference orbit are calculated with std::complex<double> for each pixel.
+	 * The formula of the difference is derived from each instruction of the compiled formula,
+	 * so that the perturbation works for any formula, not only for z^2 + c.
+	 *
+	 * Rebasing (restart the reference orbit when the pixel orbit is closer to 0 than the difference)
+	 * assumes that the initial value z0 is common for all pixels.
+	 * When rebasing is disabled, the glitches are detected by Pauldelbrot's criterion
+	 * and the glitched pixels are rendered again with new reference orbits.
+	 */
+	template <Details::MathConcept HighType>
+	class PerturbationRenderer
+	{
+	public:
+		using Delta = Details::Delta;
+
+		struct Option
+		{
+			std::size_t max_iter         = 1000;
+			double      bailout          = 2.0;    /* escape if |z| > bailout */
+			bool        rebase           = true;
+			double      glitch_tolerance = 1e-3;   /* Pauldelbrot's criterion |z| < tol * |Z| */
+			std::size_t max_references   = 8;      /* the number of reference orbits including the first one */
+			std::size_t threads          = 0;      /* 0 means the number of hardware threads */
+			bool        periodicity      = false;  /* stop iteration of the orbit caught in a cycle */
+			double      period_tolerance = 0.0;    /* |z_n - z_m| to regard as cycle. 0 means 1e-3 of pixel size.
+			                                          not below the resolution of double at |z|, at which the orbit is kept */
+		};
+
+		struct Result
+		{
+			std::size_t width  = 0;
+			std::size_t height = 0;
+			std::vector<std::size_t>  iterations; /* `max_iter` if the pixel does not escape */
+			std::vector<std::uint8_t> glitched;   /* 1 if the pixel is not corrected */
+			std::vector<std::size_t>  periods;    /* detected period, or 0 */
+			std::size_t references = 0;           /* the number of used reference orbits */
+		};
+
+	private:
+		/** @brief floor of the period tolerance relative to |z| */
+		static constexpr double PERIOD_RESOLUTION = 4.0 * std::numeric_limits<double>::epsilon();
+
+		/** @brief reference orbit and value of each instruction at each iteration */
+		struct Reference
+		{
+			std::vector<Delta> orbit;  /* Z_0, Z_1, ..., Z_rows */
+			std::vector<Delta> trace;  /* trace[n * instruction_num + k] is output of k-th instruction at Z_n */
+			std::size_t rows = 0;
+		};
+
+		Program<HighType> high;
+		Program<Delta>    low;        /* used to evaluate custom functions in double */
+		std::vector<int>  producers;  /* instruction index of operands */
+		std::vector<int>  offsets;    /* offsets[k] is the first index of k-th instruction in producers */
+		HighType          z0;
+
+		Reference make_reference(const HighType& center, const Option& option) const
+		{
+			const auto& code = high.instructions();
+			const double bail2 = option.bailout * option.bailout;
+
+			Reference ref;
+			typename Program<HighType>::Workspace ws = high.make_workspace();
+			std::array<HighType, 2> vars = { z0, center };
+
+			ref.orbit.push_back(Details::narrow(vars[0]));
+			while (ref.rows < option.max_iter && std::norm(ref.orbit.back()) <= bail2) {
+				for (const Details::Instruction<HighType>& inst : code) {
+					Details::execute(inst, ws.reg.data(), vars.data(), high.parameters().data(), ws.args);
+					ref.trace.push_back(Details::narrow(ws.reg[inst.dst]));
+				}
+				vars[0] = ws.reg[0];
+				ref.orbit.push_back(Details::narrow(vars[0]));
+				ref.rows++;
+			}
+			return ref;
+		}
+
+		/** @brief calculate the difference of every instructions at reference row `R` */
+		Delta step(const Delta* R, Delta* dreg, const Delta& dz, const Delta& dc, std::vector<Delta>& args) const
+		{
+			using Details::OpCode;
+			const auto& code = high.instructions();
+
+			for (std::size_t k = 0; k < code.size(); ++k) {
+				const Details::Instruction<HighType>& inst = code[k];
+				const int* prod = producers.data() + offsets[k];
+
+				const Delta A  = (inst.arg_num > 0) ? R[prod[0]] : Delta();
+				const Delta B  = (inst.arg_num > 1) ? R[prod[1]] : Delta();
+				const Delta da = (inst.arg_num > 0) ? dreg[inst.src[0]] : Delta();
+				const Delta db = (inst.arg_num > 1) ? dreg[inst.src[1]] : Delta();
+				Delta& d = dreg[inst.dst];
+
+				switch (inst.code)
+				{
+				case OpCode::Load :
+					d = (inst.index == 0) ? dz : dc;
+					break;
+				case OpCode::Param :
+				case OpCode::Const :
+					d = 0.0;
+					break;
+				case OpCode::Add :
+					d = da + db;
+					break;
+				case OpCode::Sub :
+					d = da - db;
+					break;
+				case OpCode::Mul :
+					d = A * db + da * (B + db);
+					break;
+				case OpCode::Div :
+					d = (da * B - A * db) / (B * (B + db));
+					break;
+				case OpCode::PowInt :
+					if (inst.index > 0) {
+						d = Details::binomial_delta(A, da, inst.index);
+					} else {
+						d = R[k] * Details::expm1(static_cast<double>(inst.index) * Details::log1p(da / A));
+					}
+					break;
+				case OpCode::Pow :
+					d = R[k] * Details::expm1(B * Details::log1p(da / A) + db * std::log(A + da));
+					break;
+				case OpCode::Exp :
+					d = R[k] * Details::expm1(da);
+					break;
+				case OpCode::Log :
+					d = Details::log1p(da / A);
+					break;
+				case OpCode::Log10 :
+					d = Details::log1p(da / A) * std::numbers::log10e;
+					break;
+				case OpCode::Sqrt :
+					d = da / (std::sqrt(A + da) + R[k]);
+					break;
+				case OpCode::Sin :
+					d = 2.0 * std::cos(A + 0.5 * da) * std::sin(0.5 * da);
+					break;
+				case OpCode::Cos :
+					d = -2.0 * std::sin(A + 0.5 * da) * std::sin(0.5 * da);
+					break;
+				case OpCode::Sinh :
+					d = 2.0 * std::cosh(A + 0.5 * da) * std::sinh(0.5 * da);
+					break;
+				case OpCode::Cosh :
+					d = 2.0 * std::sinh(A + 0.5 * da) * std::sinh(0.5 * da);
+					break;
+				case OpCode::Tan :
+					d = std::sin(da) / (std::cos(A) * std::cos(A + da));
+					break;
+				case OpCode::Tanh :
+					d = std::sinh(da) / (std::cosh(A) * std::cosh(A + da));
+					break;
+				case OpCode::Call :
+					/* no identity is known for custom function: f(A + d) - f(A) */
+					args.resize(inst.arg_num);
+					for (int n = 0; n < inst.arg_num; ++n) {
+						args[n] = R[prod[n]] + dreg[inst.src[0] + n];
+					}
+					d = low.instructions()[k].func(args) - R[k];
+					break;
+				default :
+					/* asin, acos, atan, asinh, acosh, atanh: f(A + d) - f(A) */
+					d = Details::apply(inst.code, A + da, B + db, inst.index) - R[k];
+					break;
+				}
+			}
+			return dreg[0];
+		}
+
+		/**
+		 * @brief iterate one pixel
+		 * @param[out] iteration escape time, or `max_iter` if the pixel does not escape
+		 * @param[out] period    detected period, or `0`
+		 * @return `bool` false if the pixel is glitched
+		 */
+		bool iterate(const Reference& ref, const Delta& dc, const Option& option, double period_tolerance,
+		             std::vector<Delta>& dreg, std::vector<Delta>& args, std::size_t& iteration, std::size_t& period) const
+		{
+			const std::size_t ninst = high.instructions().size();
+			const double bail2 = option.bailout * option.bailout;
+			const double tol2  = option.glitch_tolerance * option.glitch_tolerance;
+
+			period = 0;
+			if (ref.rows == 0)
+				return false;
+
+			Delta dz = 0.0;
+			std::size_t m = 0;
+			/* z is the reference orbit in double plus the delta, which resolves no cycle below a few ulps of |z| */
+			Details::PeriodDetector<Delta> detector(ref.orbit[0], period_tolerance, PERIOD_RESOLUTION);
+			for (iteration = 0; iteration < option.max_iter; ++iteration) {
+				const Delta z = ref.orbit[m] + dz;
+				const double nz = std::norm(z);
+				if (nz > bail2)
+					return true;
+
+				if (option.rebase) {
+					if (m == ref.rows || nz < std::norm(dz)) {
+						dz = z - ref.orbit[0];
+						m  = 0;
+					}
+				} else if (m == ref.rows || nz < tol2 * std::norm(ref.orbit[m])) {
+					return false;
+				}
+
+				dz = step(ref.trace.data() + m * ninst, dreg.data(), dz, dc, args);
+				m++;
+
+				if (!std::isfinite(dz.real()) || !std::isfinite(dz.imag()))
+					return false;
+
+				if (option.periodicity) {
+					period = detector.check(ref.orbit[m] + dz);
+					if (period != 0) {
+						iteration = option.max_iter;
+						return true;
+					}
+				}
+			}
+			return true;
+		}
+
+		void render_pixels(const Reference& ref, const std::vector<std::size_t>& pixels, const Delta& ref_offset,
+		                   double pixel_size, const Option& option, Result& result) const
+		{
+			std::vector<std::vector<Delta>> dregs(Details::ret_thread_num(option.threads), std::vector<Delta>(high.register_num()));
+			std::vector<std::vector<Delta>> argss(dregs.size());
+			const double period_tolerance = (option.period_tolerance > 0.0) ? option.period_tolerance : 1e-3 * pixel_size;
+
+			Details::parallel_for(pixels.size(), 256, dregs.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					for (std::size_t i = begin; i < end; ++i) {
+						const std::size_t p = pixels[i];
+						const double x = (static_cast<double>(p % result.width) - 0.5 * static_cast<double>(result.width)) * pixel_size;
+						const double y = (0.5 * static_cast<double>(result.height) - static_cast<double>(p / result.width)) * pixel_size;
+						const Delta dc = Delta(x, y) - ref_offset;
+
+						std::size_t iteration = 0;
+						std::size_t period = 0;
+						bool ok = iterate(ref, dc, option, period_tolerance, dregs[worker], argss[worker], iteration, period);
+						result.iterations[p] = iteration;
+						result.glitched[p]   = ok ? 0 : 1;
+						result.periods[p]    = period;
+					}
+				});
+		}
+
+	public:
+		/**
+		 * @brief compile formula `f(z, c)`
+		 *
+		 * @param formula formula like "z^2 + c"
+		 * @param table   values of the other variables
+		 * @param z       variable string iterated
+		 * @param c       variable string of the pixel position
+		 * @param z0      initial value of z, which is common for all pixels
+		 * @throw `std::invalid_argument` if the formula is invalid or includes random numbers
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		PerturbationRenderer(const std::string& formula, const VariableTable<HighType>& table = VariableTable<HighType>(),
+		                     const std::string& z = "z", const std::string& c = "c",
+		                     const HighType& z0 = Details::num<HighType>(0.0))
+			: z0(z0)
+		{
+			high = Syamfp<HighType>::compile(formula, {z, c}, table);
+			if (high.is_random()) {
+				throw std::invalid_argument("Invalid formula: random numbers cannot be used in the perturbation");
+			}
+			for (const auto& inst : high.instructions()) {
+				if (Details::is_table(inst.code)) {
+					throw std::invalid_argument("Invalid formula: data tables cannot be used in the perturbation");
+				}
+				if (Details::is_array(inst.code)) {
+					throw std::invalid_argument("Invalid formula: arrays cannot be used in the perturbation");
+				}
+			}
+
+			/* resolve operands into instruction indices */
+			const auto& code = high.instructions();
+			std::vector<int> writer(high.register_num(), -1);
+			bool has_call = false;
+			for (std::size_t k = 0; k < code.size(); ++k) {
+				offsets.push_back(static_cast<int>(producers.size()));
+				if (code[k].code == Details::OpCode::Call) {
+					has_call = true;
+					for (int n = 0; n < code[k].arg_num; ++n) {
+						producers.push_back(writer[code[k].src[0] + n]);
+					}
+				} else {
+					for (int n = 0; n < code[k].arg_num; ++n) {
+						producers.push_back(writer[code[k].src[n]]);
+					}
+				}
+				writer[code[k].dst] = static_cast<int>(k);
+			}
+
+			if (has_call) {
+				VariableTable<Delta> low_table;
+				for (const auto& [str, value] : table) {
+					low_table.add(str, Details::narrow(value));
+				}
+				Syamfp<Delta> low_parser;
+				if (low_parser.parse(formula, low_table) != 0) {
+					throw std::invalid_argument("Invalid formula: custom function must be added for std::complex<double> too");
+				}
+				low = low_parser.ret_program({z, c});
+				if (low.instructions().size() != code.size()) {
+					throw std::invalid_argument("Invalid formula: custom function must be added for std::complex<double> too");
+				}
+			}
+		}
+
+		~PerturbationRenderer() = default;
+
+		/**
+		 * @brief render escape time of every pixel
+		 *
+		 * @param center     c at the center of the image
+		 * @param pixel_size width of one pixel in the complex plane
+		 * @param width      the number of pixels in a row
+		 * @param height     the number of rows
+		 * @param option     options of rendering
+		 * @return `Result`  escape time and glitch flag of each pixel (row major, top row first)
+		 */
+		Result render(const HighType& center, double pixel_size, std::size_t width, std::size_t height,
+		              const Option& option = Option()) const
+		{
+			Result result;
+			result.width  = width;
+			result.height = height;
+			result.iterations.assign(width * height, 0);
+			result.glitched.assign(width * height, 0);
+			result.periods.assign(width * height, 0);
+
+			std::vector<std::size_t> pixels(width * height);
+			for (std::size_t p = 0; p < pixels.size(); ++p) {
+				pixels[p] = p;
+			}
+
+			Delta ref_offset = 0.0;
+			while (!pixels.empty() && result.references < option.max_references) {
+				Reference ref = make_reference(center + Details::widen<HighType>(ref_offset), option);
+				result.references++;
+				render_pixels(ref, pixels, ref_offset, pixel_size, option, result);
+
+				std::vector<std::size_t> remain;
+				for (std::size_t p : pixels) {
+					if (result.glitched[p])
+						remain.push_back(p);
+				}
+				if (remain.empty())
+					break;
+
+				/* next reference is one of the glitched pixels */
+				const std::size_t p = remain[remain.size() / 2];
+				ref_offset = Delta((static_cast<double>(p % width) - 0.5 * static_cast<double>(width)) * pixel_size,
+				                   (0.5 * static_cast<double>(height) - static_cast<double>(p / width)) * pixel_size);
+				pixels.swap(remain);
+			}
+
+			return result;
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_PERTURBATION_HPP__ */
@@ -0,0 +1,331 @@
+/**
+ * @file syamfp_qmc.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Randomized quasi-Monte Carlo integration over multi-dimensional boxes
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_QMC_HPP__
+#define __SYAMFP_QMC_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @brief degree s, coefficients a and initial direction numbers m of Sobol sequence (Joe and Kuo) */
+		struct SobolInit
+		{
+			unsigned int s;
+			unsigned int a;
+			std::array<std::uint32_t, 7> m;
+		};
+
+		/** @brief parameters of the 2nd dimension and later */
+		constexpr std::array<SobolInit, 20> SOBOL_INIT =
+		{{
+			{ 1,  0, { 1 } },
+			{ 2,  1, { 1, 3 } },
+			{ 3,  1, { 1, 3, 1 } },
+			{ 3,  2, { 1, 1, 1 } },
+			{ 4,  1, { 1, 1, 3, 3 } },
+			{ 4,  4, { 1, 3, 5, 13 } },
+			{ 5,  2, { 1, 1, 5, 5, 17 } },
+			{ 5,  4, { 1, 1, 5, 5, 5 } },
+			{ 5,  7, { 1, 1, 7, 11, 19 } },
+			{ 5, 11, { 1, 1, 5, 1, 1 } },
+			{ 5, 13, { 1, 1, 1, 3, 11 } },
+			{ 5, 14, { 1, 3, 5, 5, 31 } },
+			{ 6,  1, { 1, 3, 3, 9, 7, 49 } },
+			{ 6, 13, { 1, 1, 1, 15, 21, 21 } },
+			{ 6, 16, { 1, 3, 1, 13, 27, 49 } },
+			{ 6, 19, { 1, 1, 1, 15, 7, 5 } },
+			{ 6, 22, { 1, 3, 1, 15, 13, 25 } },
+			{ 6, 25, { 1, 1, 5, 5, 19, 61 } },
+			{ 7,  1, { 1, 3, 7, 11, 23, 15, 103 } },
+			{ 7,  4, { 1, 3, 7, 13, 13, 15, 69 } },
+		}};
+
+		/** @brief Sobol sequence in 32 bits, generated in Gray code order */
+		class SobolSequence
+		{
+		private:
+			std::vector<std::array<std::uint32_t, 32>> v;  /* direction numbers of each dimension */
+
+		public:
+			/** @throw `std::invalid_argument` if the dimension is not supported */
+			explicit SobolSequence(std::size_t dim)
+				: v(dim)
+			{
+				if (dim > SOBOL_INIT.size() + 1) {
+					throw std::invalid_argument("SobolSequence: dimension must be " + std::to_string(SOBOL_INIT.size() + 1) + " or less");
+				}
+
+				if (dim == 0)
+					return;
+
+				for (std::size_t k = 0; k < 32; ++k) {
+					v[0][k] = std::uint32_t(1) << (31 - k);
+				}
+				for (std::size_t d = 1; d < dim; ++d) {
+					const SobolInit& init = SOBOL_INIT[d - 1];
+					for (std::size_t k = 0; k < 32; ++k) {
+						if (k < init.s) {
+							v[d][k] = init.m[k] << (31 - k);
+							continue;
+						}
+						std::uint32_t x = v[d][k - init.s] ^ (v[d][k - init.s] >> init.s);
+						for (std::size_t j = 1; j < init.s; ++j) {
+							if ((init.a >> (init.s - 1 - j)) & 1)
+								x ^= v[d][k - j];
+						}
+						v[d][k] = x;
+					}
+				}
+			}
+
+			/**
+			 * @brief write points [first, first + n) of the dimension
+			 * @param out `out[i]` is the 32-bit integer of the (first + i)-th point
+			 */
+			void generate(std::size_t d, std::uint32_t first, std::size_t n, std::uint32_t* out) const
+			{
+				const std::uint32_t gray = first ^ (first >> 1);
+				std::uint32_t x = 0;
+				for (std::size_t k = 0; k < 32; ++k) {
+					if ((gray >> k) & 1)
+						x ^= v[d][k];
+				}
+
+				for (std::size_t i = 0; i < n; ++i) {
+					out[i] = x;
+					if (i + 1 < n)
+						x ^= v[d][std::countr_zero(first + static_cast<std::uint32_t>(i) + 1)];
+				}
+			}
+		};
+
+		/** @return `double` radical inverse of the index in the base */
+		inline double radical_inverse(std::uint64_t index, std::uint32_t base)
+		{
+			const double inv = 1.0 / base;
+			double x = 0.0, f = inv;
+			while (index != 0) {
+				x += static_cast<double>(index % base) * f;
+				index /= base;
+				f *= inv;
+			}
+			return x;
+		}
+	}
+
+
+	/**
+	 * @brief randomized quasi-Monte Carlo integration of a formula over a box
+	 *
+	 * Points of Sobol or Halton sequence are generated in SoA chunks and evaluated by batch evaluation.
+	 * The same points are randomized by independent shifts (digital shift for Sobol, and rotation modulo 1
+	 * for Halton), and the error is estimated from the spread of the estimates of the replicates.
+	 * Chunk sums are reduced in the order of the chunks, so that the result does not depend on the threads.
+	 */
+	template <Details::MathConcept Type = double>
+	class QuasiMonteCarlo
+	{
+	public:
+		static constexpr std::size_t CHUNK = 16 * Program<Type>::BLOCK;
+
+		enum class Sequence
+		{
+			Sobol,
+			Halton,
+		};
+
+		struct Option
+		{
+			Sequence      sequence   = Sequence::Sobol;
+			std::size_t   points     = 1 << 16;  /* the number of points of each replicate */
+			std::size_t   replicates = 16;       /* the number of random shifts */
+			std::uint64_t seed       = 0;
+			std::size_t   threads    = 0;        /* 0 means the number of hardware threads */
+		};
+
+		struct Result
+		{
+			Type        value = Details::num<Type>(0.0);
+			double      error = 0.0;   /* standard error of the mean of the replicates */
+			std::size_t evaluations = 0;
+		};
+
+	private:
+		Program<Type> program;
+
+		struct Worker
+		{
+			typename Program<Type>::Workspace ws;
+			std::vector<Type> xs;           /* SoA points */
+			std::vector<Type> fs;
+			std::vector<std::uint32_t> bits;
+			std::vector<const Type*> columns;
+		};
+
+	public:
+		/**
+		 * @brief compile the integrand
+		 *
+		 * @param formula   integrand like "exp(-(x^2 + y^2))"
+		 * @param variables variable strings of the integration
+		 * @param table     values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		QuasiMonteCarlo(const std::string& formula, const std::vector<std::string>& variables,
+		                const VariableTable<Type>& table = VariableTable<Type>())
+		{
+			program = Syamfp<Type>::compile(formula, variables, table);
+		}
+
+		~QuasiMonteCarlo() = default;
+
+		/**
+		 * @brief integrate over the box
+		 *
+		 * @param bounds (lower, upper) of each variable
+		 * @param option sequence and the number of points
+		 * @return `Result` integral and its standard error
+		 * @throw `std::invalid_argument` if the number of bounds is not equal to the number of variables,
+		 *        or the dimension or the number of points is not supported by the sequence
+		 */
+		Result integrate(const std::vector<std::pair<double, double>>& bounds, const Option& option = Option()) const
+		{
+			using Details::num;
+
+			const std::size_t dim = program.variable_num();
+			if (bounds.size() != dim) {
+				throw std::invalid_argument("QuasiMonteCarlo: the number of bounds must be equal to the number of variables");
+			}
+
+			const bool sobol = (option.sequence == Sequence::Sobol);
+			if (sobol && option.points > (std::size_t(1) << 32)) {
+				throw std::invalid_argument("QuasiMonteCarlo: Sobol sequence has 2^32 points at most");
+			}
+			if (option.points == 0)
+				return Result();
+
+			const Details::SobolSequence generator(sobol ? dim : 0);
+			std::vector<std::uint32_t> primes;
+			for (std::uint32_t p = 2; primes.size() < dim; ++p) {
+				if (std::ranges::all_of(primes, [p](std::uint32_t q) { return p % q != 0; }))
+					primes.push_back(p);
+			}
+
+			/* random shift of each replicate */
+			const std::size_t replicates = std::max<std::size_t>(option.replicates, 1);
+			std::vector<std::uint32_t> digital(replicates * dim);
+			std::vector<double> rotation(replicates * dim);
+			for (std::size_t r = 0; r < replicates; ++r) {
+				Details::CounterRNG rng(option.seed, r);
+				for (std::size_t d = 0; d < dim; ++d) {
+					rotation[r * dim + d] = rng.uniform();
+					digital[r * dim + d]  = static_cast<std::uint32_t>(rotation[r * dim + d] * 4294967296.0);
+				}
+			}
+
+			double volume = 1.0;
+			for (const auto& [lo, hi] : bounds) {
+				volume *= hi - lo;
+			}
+
+			/* sums of each chunk of each replicate */
+			const std::size_t chunks = (option.points + CHUNK - 1) / CHUNK;
+			std::vector<Type> sums(replicates * chunks, num<Type>(0.0));
+			std::vector<Worker> workers(Details::ret_thread_num(option.threads));
+			for (Worker& w : workers) {
+				w.ws = program.make_workspace();
+				w.xs.resize(dim * CHUNK);
+				w.fs.resize(CHUNK);
+				w.bits.resize(CHUNK);
+				w.columns.resize(dim);
+			}
+
+			Details::parallel_for(replicates * chunks, 1, workers.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					Worker& w = workers[worker];
+					for (std::size_t job = begin; job < end; ++job) {
+						const std::size_t r = job / chunks;
+						const std::size_t first = (job % chunks) * CHUNK;
+						const std::size_t n = std::min(CHUNK, option.points - first);
+
+						for (std::size_t d = 0; d < dim; ++d) {
+							Type* x = w.xs.data() + d * CHUNK;
+							const auto& [lo, hi] = bounds[d];
+							if (sobol) {
+								generator.generate(d, static_cast<std::uint32_t>(first), n, w.bits.data());
+								for (std::size_t i = 0; i < n; ++i) {
+									/* center of the cell of 2^-32, so that the end points are never evaluated */
+									const double u = (static_cast<double>(w.bits[i] ^ digital[r * dim + d]) + 0.5) / 4294967296.0;
+									x[i] = num<Type>(lo + (hi - lo) * u);
+								}
+							} else {
+								for (std::size_t i = 0; i < n; ++i) {
+									double u = Details::radical_inverse(first + i + 1, primes[d]) + rotation[r * dim + d];
+									u -= std::floor(u);
+									x[i] = num<Type>(lo + (hi - lo) * u);
+								}
+							}
+							w.columns[d] = x;
+						}
+
+						program.eval_batch(n, w.columns.data(), w.fs.data(), w.ws);
+						Type sum = num<Type>(0.0);
+						for (std::size_t i = 0; i < n; ++i) {
+							sum += w.fs[i];
+						}
+						sums[job] = sum;
+					}
+				});
+
+			/* deterministic reduction in the order of chunks */
+			std::vector<Type> estimates(replicates);
+			Type mean = num<Type>(0.0);
+			for (std::size_t r = 0; r < replicates; ++r) {
+				Type sum = num<Type>(0.0);
+				for (std::size_t c = 0; c < chunks; ++c) {
+					sum += sums[r * chunks + c];
+				}
+				estimates[r] = num<Type>(volume / static_cast<double>(option.points)) * sum;
+				mean += estimates[r];
+			}
+			mean /= num<Type>(replicates);
+
+			using std::abs;
+			double var = 0.0;
+			for (const Type& estimate : estimates) {
+				var += std::pow(static_cast<double>(abs(estimate - mean)), 2);
+			}
+
+			Result result;
+			result.value = mean;
+			result.error = (replicates > 1) ? std::sqrt(var / static_cast<double>(replicates - 1) / static_cast<double>(replicates)) : 0.0;
+			result.evaluations = replicates * option.points;
+			return result;
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_QMC_HPP__ */
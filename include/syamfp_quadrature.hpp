@@ -0,0 +1,358 @@
+/**
+ * @file syamfp_quadrature.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Adaptive quadrature of compiled formulas
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_QUADRATURE_HPP__
+#define __SYAMFP_QUADRATURE_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @brief nodes of 15-point Kronrod rule on [-1, 1]: +-GK15_X[j], and GK15_X[7] = 0 */
+		constexpr std::array<double, 8> GK15_X =
+		{
+			0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+			0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+			0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+			0.207784955007898467600689403773245, 0.000000000000000000000000000000000,
+		};
+
+		constexpr std::array<double, 8> GK15_W =
+		{
+			0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+			0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+			0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+			0.204432940075298892414161999234649, 0.209482141084727828012999174891714,
+		};
+
+		/** @brief weights of 7-point Gauss rule at GK15_X[1], GK15_X[3], GK15_X[5], GK15_X[7] */
+		constexpr std::array<double, 4> G7_W =
+		{
+			0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+			0.381830050505118944950369775488975, 0.417959183673469387755102040816327,
+		};
+
+		/** @brief range of the parameter t of tanh-sinh rule, where the nodes reach the end points in double */
+		constexpr double TANH_SINH_T_MAX = 6.5;
+	}
+
+
+	/**
+	 * @brief adaptive quadrature of a formula of one variable over [a, b]
+	 *
+	 * Gauss-Kronrod: the intervals with the largest error estimates are bisected in each round, and
+	 * all nodes of the new subintervals are evaluated by one batch evaluation. The estimates of the
+	 * other intervals are kept. The rounds do not depend on the number of threads, so the result is deterministic.
+	 *
+	 * Tanh-sinh: the step of the double exponential rule is halved in each level, and only the new nodes are
+	 * evaluated. This is suitable for integrands with singularities at the end points.
+	 */
+	template <Details::MathConcept Type = double>
+	class Quadrature
+	{
+	public:
+		enum class Method
+		{
+			GaussKronrod,
+			TanhSinh,
+		};
+
+		struct Option
+		{
+			Method      method        = Method::GaussKronrod;
+			double      rel_tol       = 0.0;    /* relative tolerance added to the absolute one */
+			std::size_t max_intervals = 10000;  /* Gauss-Kronrod */
+			std::size_t batch         = 64;     /* Gauss-Kronrod: the maximum number of intervals bisected in one round */
+			std::size_t max_level     = 12;     /* tanh-sinh */
+			std::size_t threads       = 0;      /* 0 means the number of hardware threads */
+		};
+
+		struct Result
+		{
+			Type        value = Details::num<Type>(0.0);
+			double      error = 0.0;
+			std::size_t evaluations = 0;
+			bool        converged = false;
+		};
+
+	private:
+		struct Interval
+		{
+			double a, b;
+			Type   value;
+			double error;
+
+			/* std::*_heap makes max heap: the largest error first */
+			bool operator<(const Interval& other) const
+			{
+				return error < other.error;
+			}
+		};
+
+		Program<Type> program;
+
+		static double mag(const Type& value)
+		{
+			using std::abs;
+			return static_cast<double>(abs(value));
+		}
+
+		/** @brief evaluate the formula at every nodes */
+		void evaluate(const std::vector<Type>& xs, std::vector<Type>& fs, std::size_t threads) const
+		{
+			const Type* columns[1] = { xs.data() };
+			fs.resize(xs.size());
+			program.eval_batch(xs.size(), columns, fs.data(), threads);
+		}
+
+		/** @brief apply Gauss-Kronrod rule to the intervals [a, b) of `segments` */
+		void gauss_kronrod(std::vector<Interval>& segments, const Option& option, Result& result) const
+		{
+			using namespace Details;
+
+			std::vector<Type> xs, fs;
+			xs.reserve(15 * segments.size());
+			for (const Interval& seg : segments) {
+				const double c = 0.5 * (seg.a + seg.b);
+				const double h = 0.5 * (seg.b - seg.a);
+				for (std::size_t j = 0; j < 7; ++j) {
+					xs.push_back(Details::num<Type>(c - h * GK15_X[j]));
+					xs.push_back(Details::num<Type>(c + h * GK15_X[j]));
+				}
+				xs.push_back(Details::num<Type>(c));
+			}
+			evaluate(xs, fs, option.threads);
+			result.evaluations += xs.size();
+
+			for (std::size_t s = 0; s < segments.size(); ++s) {
+				const Type* f = fs.data() + 15 * s;
+				const double h = 0.5 * (segments[s].b - segments[s].a);
+
+				Type kronrod = Details::num<Type>(GK15_W[7]) * f[14];
+				Type gauss   = Details::num<Type>(G7_W[3]) * f[14];
+				for (std::size_t j = 0; j < 7; ++j) {
+					const Type pair = f[2 * j] + f[2 * j + 1];
+					kronrod += Details::num<Type>(GK15_W[j]) * pair;
+					if (j % 2 == 1)
+						gauss += Details::num<Type>(G7_W[j / 2]) * pair;
+				}
+				segments[s].value = Details::num<Type>(h) * kronrod;
+				segments[s].error = mag(Details::num<Type>(h) * (kronrod - gauss));
+				if (!std::isfinite(segments[s].error))
+					segments[s].error = std::numeric_limits<double>::infinity();
+			}
+		}
+
+		Result integrate_gk(double a, double b, double tol, const Option& option) const
+		{
+			Result result;
+			std::vector<Interval> segments = { { a, b, Details::num<Type>(0.0), 0.0 } };
+			gauss_kronrod(segments, option, result);
+
+			std::vector<Interval> heap = segments;
+			const double min_width = 64.0 * std::numeric_limits<double>::epsilon() * std::max(std::abs(a), std::abs(b));
+
+			while (true) {
+				Type   value = Details::num<Type>(0.0);
+				double error = 0.0;
+				for (const Interval& seg : heap) {
+					value += seg.value;
+					error += seg.error;
+				}
+				result.value = value;
+				result.error = error;
+
+				const double target = std::max(tol, option.rel_tol * mag(value));
+				if (error <= target) {
+					result.converged = true;
+					break;
+				}
+				if (heap.size() >= option.max_intervals)
+					break;
+
+				/* bisect the worst intervals until the rest satisfies the tolerance */
+				segments.clear();
+				double rest = error;
+				while (!heap.empty() && rest > target && segments.size() < std::max<std::size_t>(option.batch, 1)) {
+					std::pop_heap(heap.begin(), heap.end());
+					const Interval seg = heap.back();
+					if (std::abs(seg.b - seg.a) <= min_width) {
+						std::push_heap(heap.begin(), heap.end());
+						break;  /* the interval cannot be bisected */
+					}
+					heap.pop_back();
+					rest -= seg.error;
+
+					const double mid = 0.5 * (seg.a + seg.b);
+					segments.push_back({ seg.a, mid, Details::num<Type>(0.0), 0.0 });
+					segments.push_back({ mid, seg.b, Details::num<Type>(0.0), 0.0 });
+				}
+				if (segments.empty())
+					break;
+
+				gauss_kronrod(segments, option, result);
+				for (const Interval& seg : segments) {
+					heap.push_back(seg);
+					std::push_heap(heap.begin(), heap.end());
+				}
+			}
+
+			return result;
+		}
+
+		Result integrate_ts(double a, double b, double tol, const Option& option) const
+		{
+			constexpr double HALF_PI = 0.5 * std::numbers::pi;
+
+			Result result;
+			const double half = 0.5 * (b - a);
+			Type   sum      = Details::num<Type>(0.0);  /* sum of f(x) w(t) without the step */
+			Type   previous = Details::num<Type>(0.0);
+			std::vector<Type> xs, fs, ws;
+
+			for (std::size_t level = 0; level <= option.max_level; ++level) {
+				const double h = std::ldexp(1.0, -static_cast<int>(level));
+
+				/* new nodes of this level: all multiples of h at level 0, and odd multiples after that */
+				xs.clear();
+				ws.clear();
+				const std::size_t k_max = static_cast<std::size_t>(Details::TANH_SINH_T_MAX / h);
+				for (std::size_t k = (level == 0) ? 0 : 1; k <= k_max; k += (level == 0) ? 1 : 2) {
+					const double t  = static_cast<double>(k) * h;
+					const double s  = HALF_PI * std::sinh(t);
+					const double e  = std::exp(-2.0 * s);
+					/* distance of the node from the end point, and the weight without the step */
+					const double d  = 2.0 * half * e / (1.0 + e);
+					const double w  = half * HALF_PI * std::cosh(t) * 4.0 * e / ((1.0 + e) * (1.0 + e));
+					if (w == 0.0)
+						break;
+
+					if (k == 0) {
+						xs.push_back(Details::num<Type>(a + half));
+						ws.push_back(Details::num<Type>(w));
+						continue;
+					}
+					if (a + d != a) {
+						xs.push_back(Details::num<Type>(a + d));
+						ws.push_back(Details::num<Type>(w));
+					}
+					if (b - d != b) {
+						xs.push_back(Details::num<Type>(b - d));
+						ws.push_back(Details::num<Type>(w));
+					}
+				}
+				evaluate(xs, fs, option.threads);
+				result.evaluations += xs.size();
+
+				for (std::size_t i = 0; i < xs.size(); ++i) {
+					sum += fs[i] * ws[i];
+				}
+
+				result.value = Details::num<Type>(h) * sum;
+				if (level > 0) {
+					result.error = mag(result.value - previous);
+					const double target = std::max(tol, option.rel_tol * mag(result.value));
+					if (level >= 2 && result.error <= target) {
+						result.converged = true;
+						break;
+					}
+				}
+				previous = result.value;
+			}
+
+			return result;
+		}
+
+	public:
+		/**
+		 * @param program program with one free variable
+		 * @throw `std::invalid_argument` if the program does not have one free variable
+		 */
+		Quadrature(const Program<Type>& program)
+			: program(program)
+		{
+			if (program.variable_num() != 1) {
+				throw std::invalid_argument("Quadrature: program must have one variable");
+			}
+		}
+
+		/**
+		 * @brief compile the integrand
+		 *
+		 * @param formula  integrand like "exp(-x^2)"
+		 * @param variable variable string of integration
+		 * @param table    values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		Quadrature(const std::string& formula, const std::string& variable,
+		           const VariableTable<Type>& table = VariableTable<Type>())
+		{
+			program = Syamfp<Type>::compile(formula, {variable}, table);
+		}
+
+		~Quadrature() = default;
+
+		/**
+		 * @brief integrate over [a, b]
+		 *
+		 * @param a, b   interval of integration
+		 * @param tol    absolute tolerance
+		 * @param option method and limits
+		 * @return `Result` integral and its error estimate. `converged` is false if the limit is reached.
+		 */
+		Result integrate(double a, double b, double tol, const Option& option = Option()) const
+		{
+			if (a == b)
+				return Result{ Details::num<Type>(0.0), 0.0, 0, true };
+
+			if (option.method == Method::TanhSinh)
+				return integrate_ts(a, b, tol, option);
+			return integrate_gk(a, b, tol, option);
+		}
+	};
+
+
+	/**
+	 * @brief integrate the formula over [a, b]
+	 *
+	 * @param formula  integrand like "exp(-x^2)"
+	 * @param variable variable string of integration
+	 * @param a, b     interval of integration
+	 * @param tol      absolute tolerance
+	 * @param table    values of the other variables
+	 * @param option   method and limits
+	 * @return `Quadrature<Type>::Result` integral and its error estimate
+	 * @throw `std::invalid_argument` if the formula is invalid
+	 * @throw `std::runtime_error` if unknown variable is included in formula
+	 */
+	template <Details::MathConcept Type = double>
+	typename Quadrature<Type>::Result integrate(const std::string& formula, const std::string& variable,
+	                                            double a, double b, double tol,
+	                                            const VariableTable<Type>& table = VariableTable<Type>(),
+	                                            const typename Quadrature<Type>::Option& option = typename Quadrature<Type>::Option())
+	{
+		return Quadrature<Type>(formula, variable, table).integrate(a, b, tol, option);
+	}
+}
+
+#endif /* end of __SYAMFP_QUADRATURE_HPP__ */
@@ -0,0 +1,256 @@
+/**
+ * @file syamfp_realtime.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Real-time safe streaming evaluation of formulas of time
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_REALTIME_HPP__
+#define __SYAMFP_REALTIME_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/**
+		 * @brief lock-free single producer single consumer queue with fixed capacity
+		 * @note  the buffer is allocated only in the constructor.
+		 */
+		template <typename T>
+		class SPSCQueue
+		{
+		private:
+			std::vector<T> buffer;
+			std::size_t    mask;
+			alignas(64) std::atomic<std::size_t> head = 0;  /* next element to pop, written by the consumer */
+			alignas(64) std::atomic<std::size_t> tail = 0;  /* next element to push, written by the producer */
+
+		public:
+			/** @param capacity the number of elements, rounded up to a power of two */
+			explicit SPSCQueue(std::size_t capacity)
+				: buffer(std::bit_ceil(std::max<std::size_t>(capacity, 2))), mask(buffer.size() - 1) {}
+
+			SPSCQueue(const SPSCQueue&) = delete;
+			SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+			/** @return `bool` false if the queue is full. Call only from the producer. */
+			bool push(const T& value) noexcept(std::is_nothrow_copy_assignable_v<T>)
+			{
+				const std::size_t t = tail.load(std::memory_order_relaxed);
+				if (t - head.load(std::memory_order_acquire) == buffer.size())
+					return false;
+
+				buffer[t & mask] = value;
+				tail.store(t + 1, std::memory_order_release);
+				return true;
+			}
+
+			/** @return `bool` false if the queue is full. Call only from the producer. */
+			bool push(T&& value) noexcept(std::is_nothrow_move_assignable_v<T>)
+			{
+				const std::size_t t = tail.load(std::memory_order_relaxed);
+				if (t - head.load(std::memory_order_acquire) == buffer.size())
+					return false;
+
+				buffer[t & mask] = std::move(value);
+				tail.store(t + 1, std::memory_order_release);
+				return true;
+			}
+
+			/** @return `bool` false if the queue is empty. Call only from the consumer. */
+			bool pop(T& value) noexcept(std::is_nothrow_move_assignable_v<T>)
+			{
+				const std::size_t h = head.load(std::memory_order_relaxed);
+				if (h == tail.load(std::memory_order_acquire))
+					return false;
+
+				value = std::move(buffer[h & mask]);
+				head.store(h + 1, std::memory_order_release);
+				return true;
+			}
+
+			std::size_t capacity(void) const noexcept { return buffer.size(); }
+		};
+	}
+
+
+	/**
+	 * @brief real-time safe evaluator of formula of time `t`, e.g. control signals in audio thread
+	 *
+	 * render() never allocates, locks nor throws: the buffers are prepared in the constructor,
+	 * and parameters are changed through a lock-free SPSC queue of timestamped events,
+	 * which are applied at the exact sample. Custom functions used in the formula must follow the same rules;
+	 * if one throws anyway, the rest of the block is silence and failed() reports it.
+	 */
+	template <Details::MathConcept Type = double>
+	class RealtimeEvaluator
+	{
+	public:
+		/** @brief change of parameter at the sample time */
+		struct Event
+		{
+			std::size_t   index;  /* parameter index, see parameter_index() */
+			Type          value;
+			std::uint64_t time;   /* sample time */
+		};
+
+	private:
+		Program<Type> program;
+		typename Program<Type>::Workspace ws;
+		std::vector<Type> ts;
+		std::size_t max_block;
+		double inv_rate;
+
+		Details::SPSCQueue<Event> queue;
+		std::atomic<std::uint64_t> now = 0;
+		std::atomic<bool> failure = false;
+		Event pending;
+		bool  has_pending = false;
+
+	public:
+		/**
+		 * @brief prepare all buffers
+		 *
+		 * @param program        program with one free variable (time in seconds)
+		 * @param sample_rate    samples per second
+		 * @param max_block      the number of samples evaluated at once
+		 * @param queue_capacity the number of parameter events which can be pending
+		 * @throw `std::invalid_argument` if the program does not have one free variable
+		 */
+		RealtimeEvaluator(const Program<Type>& program, double sample_rate,
+		                  std::size_t max_block = 1024, std::size_t queue_capacity = 1024)
+			: program(program), ws(program.make_workspace()), ts(std::max<std::size_t>(max_block, 1)),
+			  max_block(std::max<std::size_t>(max_block, 1)), inv_rate(1.0 / sample_rate), queue(queue_capacity)
+		{
+			if (program.variable_num() != 1) {
+				throw std::invalid_argument("RealtimeEvaluator: program must have only time variable");
+			}
+		}
+
+		RealtimeEvaluator(const RealtimeEvaluator&) = delete;
+		RealtimeEvaluator& operator=(const RealtimeEvaluator&) = delete;
+
+		~RealtimeEvaluator() = default;
+
+		/** @return `int` index of the parameter used in schedule(), or `-1` */
+		int parameter_index(const std::string& name) const noexcept
+		{
+			const int slot = program.slot(name);
+			return (slot < static_cast<int>(program.variable_num())) ? -1 : slot - static_cast<int>(program.variable_num());
+		}
+
+		/**
+		 * @brief change the parameter at the sample time. Call only from one control thread.
+		 *
+		 * @param index parameter index made by parameter_index()
+		 * @param value new value
+		 * @param time  sample time. Events must be scheduled in order of time,
+		 *              and an event of the past time is applied at the beginning of the next render().
+		 * @return `bool` false if the queue is full or the index is invalid
+		 */
+		bool schedule(std::size_t index, const Type& value, std::uint64_t time)
+		{
+			if (index >= program.parameters().size())
+				return false;
+			return queue.push(Event{ index, value, time });
+		}
+
+		/** @brief change the parameter by its name. see schedule(std::size_t, const Type&, std::uint64_t) */
+		bool schedule(const std::string& name, const Type& value, std::uint64_t time)
+		{
+			const int index = parameter_index(name);
+			return (index >= 0) && schedule(static_cast<std::size_t>(index), value, time);
+		}
+
+		/** @return `std::uint64_t` sample time of the next render() */
+		std::uint64_t sample_time(void) const noexcept
+		{
+			return now.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * @brief whether the evaluation has thrown since the last call. Call from any thread.
+		 * @return `bool` true if some samples were replaced by silence
+		 */
+		bool failed(void) noexcept
+		{
+			return failure.exchange(false, std::memory_order_acq_rel);
+		}
+
+		/**
+		 * @brief evaluate the next `n` samples
+		 * @param[out] out `out[i]` is the value at sample time `sample_time() + i`.
+		 *                 if a custom function throws, the samples not written yet are 0
+		 */
+		void render(Type* out, std::size_t n) noexcept
+		{
+			const std::uint64_t t0 = now.load(std::memory_order_relaxed);
+			const Type* columns[1] = { ts.data() };
+
+			std::size_t done = 0;
+			try {
+				render_block(t0, columns, out, n, done);
+			} catch (...) {
+				std::fill(out + done, out + n, Details::num<Type>(0.0));
+				failure.store(true, std::memory_order_release);
+			}
+
+			now.store(t0 + n, std::memory_order_release);
+		}
+
+		/** @brief restart the time. Call only from the thread calling render(). */
+		void reset(std::uint64_t time = 0) noexcept
+		{
+			now.store(time, std::memory_order_release);
+		}
+
+	private:
+		/** @brief body of render(). `done` is the number of samples written */
+		void render_block(std::uint64_t t0, const Type* const* columns, Type* out, std::size_t n, std::size_t& done)
+		{
+			while (done < n) {
+				const std::uint64_t t = t0 + done;
+
+				/* apply the events until the current sample */
+				while (true) {
+					if (!has_pending) {
+						if (!queue.pop(pending))
+							break;
+						has_pending = true;
+					}
+					if (pending.time > t)
+						break;
+					program.set_parameter(pending.index, pending.value);
+					has_pending = false;
+				}
+
+				/* evaluate until the next event */
+				std::size_t m = std::min(n - done, max_block);
+				if (has_pending)
+					m = static_cast<std::size_t>(std::min<std::uint64_t>(m, pending.time - t));
+
+				for (std::size_t i = 0; i < m; ++i) {
+					ts[i] = Details::num<Type>(static_cast<double>(t + i) * inv_rate);
+				}
+				program.eval_batch(m, columns, out + done, ws);
+				done += m;
+			}
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_REALTIME_HPP__ */
@@ -0,0 +1,390 @@
+/**
+ * @file syamfp_roots.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Root finding of compiled formulas on an interval
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_ROOTS_HPP__
+#define __SYAMFP_ROOTS_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SYAMFP
+{
+	/**
+	 * @brief all roots of a formula of one variable on [a, b]
+	 *
+	 * The interval is sampled by one batch evaluation, and every sub interval where the sign changes
+	 * becomes a bracket. All brackets are refined together: each iteration evaluates the next points
+	 * of the brackets still running by one batch evaluation, so that the refinement is threaded and
+	 * the number of iterations is that of the slowest bracket.
+	 *
+	 * Brent: inverse quadratic interpolation and bisection.
+	 * Newton: Newton's method with the derivative by automatic differentiation, which falls back to
+	 *         bisection when the step leaves the bracket.
+	 *
+	 * @note roots of even multiplicity are found only if a sample hits them,
+	 *       and two roots in one sub interval cancel each other. increase `samples` for such formulas.
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	class RootFinder
+	{
+	public:
+		enum class Method
+		{
+			Brent,
+			Newton,
+		};
+
+		struct Option
+		{
+			Method      method   = Method::Brent;
+			std::size_t samples  = 1024;  /* the number of sub intervals for bracketing */
+			double      tol      = 0.0;   /* absolute tolerance of the roots added to a few ulps */
+			std::size_t max_iter = 100;
+			std::size_t threads  = 0;     /* 0 means the number of hardware threads */
+		};
+
+	private:
+		/* state of Brent's method: b is the best estimate, and [b, c] is the bracket */
+		struct BrentLane
+		{
+			Type a, b, c, fa, fb, fc, d, e;
+			Type bound;  /* the smaller |f| at the end points of the bracket */
+		};
+
+		/* state of safeguarded Newton's method: f(lo) < 0 < f(hi) */
+		struct NewtonLane
+		{
+			Type lo, hi, x, f, df, dx, dx_old;
+			Type bound;
+		};
+
+		Program<Type> program;
+
+		static Type eps(void)
+		{
+			return Details::num<Type>(std::numeric_limits<double>::epsilon());
+		}
+
+		static bool negative(const Type& value)
+		{
+			return value < Details::num<Type>(0.0);
+		}
+
+		static bool finite(const Type& value)
+		{
+			return std::isfinite(static_cast<double>(value));
+		}
+
+		/** @brief evaluate the formula (and its derivative if `dfs` is not null) at every points */
+		void evaluate(const std::vector<Type>& xs, std::vector<Type>& fs, std::vector<Type>* dfs, std::size_t threads) const
+		{
+			fs.resize(xs.size());
+			if (dfs == nullptr) {
+				const Type* columns[1] = { xs.data() };
+				program.eval_batch(xs.size(), columns, fs.data(), threads);
+				return;
+			}
+
+			dfs->resize(xs.size());
+			std::vector<typename Program<Type>::Workspace> wss(Details::ret_thread_num(threads), program.make_workspace());
+			Details::parallel_for(xs.size(), 16 * Program<Type>::BLOCK, wss.size(),
+				[&](std::size_t begin, std::size_t end, std::size_t worker)
+				{
+					const Type* columns[1] = { xs.data() + begin };
+					program.eval_batch_derivative(end - begin, columns, 0, fs.data() + begin, dfs->data() + begin, wss[worker]);
+				});
+		}
+
+		/**
+		 * @brief one step of Brent's method with the value at the current estimate
+		 * @return `bool` false if the lane converged. otherwise `lane.b` is the next point to evaluate.
+		 */
+		static bool brent_step(BrentLane& lane, double tol)
+		{
+			using std::abs;
+			const Type zero = Details::num<Type>(0.0);
+
+			if (negative(lane.fb) == negative(lane.fc)) {
+				/* the root is between a and b */
+				lane.c  = lane.a;
+				lane.fc = lane.fa;
+				lane.d  = lane.e = lane.b - lane.a;
+			}
+			if (abs(lane.fc) < abs(lane.fb)) {
+				lane.a  = lane.b;  lane.b  = lane.c;  lane.c  = lane.a;
+				lane.fa = lane.fb; lane.fb = lane.fc; lane.fc = lane.fa;
+			}
+
+			const Type tol1 = Details::num<Type>(2.0) * eps() * abs(lane.b) + Details::num<Type>(0.5 * tol);
+			const Type xm   = Details::num<Type>(0.5) * (lane.c - lane.b);
+			if (abs(xm) <= tol1 || lane.fb == zero)
+				return false;
+
+			if (abs(lane.e) >= tol1 && abs(lane.fa) > abs(lane.fb)) {
+				/* inverse quadratic interpolation, or secant if a == c */
+				const Type s = lane.fb / lane.fa;
+				Type p, q;
+				if (lane.a == lane.c) {
+					p = Details::num<Type>(2.0) * xm * s;
+					q = Details::num<Type>(1.0) - s;
+				} else {
+					const Type t = lane.fa / lane.fc;
+					const Type r = lane.fb / lane.fc;
+					p = s * (Details::num<Type>(2.0) * xm * t * (t - r) - (lane.b - lane.a) * (r - Details::num<Type>(1.0)));
+					q = (t - Details::num<Type>(1.0)) * (r - Details::num<Type>(1.0)) * (s - Details::num<Type>(1.0));
+				}
+				if (p > zero)
+					q = -q;
+				p = abs(p);
+
+				const Type limit = std::min(Details::num<Type>(3.0) * xm * q - abs(tol1 * q), abs(lane.e * q));
+				if (Details::num<Type>(2.0) * p < limit) {
+					lane.e = lane.d;
+					lane.d = p / q;
+				} else {
+					lane.d = xm;
+					lane.e = lane.d;
+				}
+			} else {
+				lane.d = xm;
+				lane.e = lane.d;
+			}
+
+			lane.a  = lane.b;
+			lane.fa = lane.fb;
+			if (abs(lane.d) > tol1)
+				lane.b += lane.d;
+			else
+				lane.b += negative(xm) ? -tol1 : tol1;
+			return true;
+		}
+
+		/**
+		 * @brief one step of safeguarded Newton's method with the value and the derivative at `lane.x`
+		 * @return `bool` false if the lane converged. otherwise `lane.x` is the next point to evaluate.
+		 */
+		static bool newton_step(NewtonLane& lane, double tol)
+		{
+			using std::abs;
+			const Type zero = Details::num<Type>(0.0);
+
+			if (lane.f == zero)
+				return false;
+			if (negative(lane.f))
+				lane.lo = lane.x;
+			else
+				lane.hi = lane.x;
+
+			const bool leaves = ((lane.x - lane.hi) * lane.df - lane.f) * ((lane.x - lane.lo) * lane.df - lane.f) > zero;
+			const bool slow   = abs(Details::num<Type>(2.0) * lane.f) > abs(lane.dx_old * lane.df);
+			lane.dx_old = lane.dx;
+			if (leaves || slow || !finite(lane.df)) {
+				lane.dx = Details::num<Type>(0.5) * (lane.hi - lane.lo);
+				lane.x  = lane.lo + lane.dx;
+			} else {
+				lane.dx = lane.f / lane.df;
+				lane.x -= lane.dx;
+			}
+
+			const Type tol1 = Details::num<Type>(4.0) * eps() * abs(lane.x) + Details::num<Type>(tol);
+			return abs(lane.dx) > tol1 && abs(lane.hi - lane.lo) > tol1;
+		}
+
+		void refine_brent(std::vector<BrentLane>& lanes, std::vector<Type>& roots, const Option& option) const
+		{
+			std::vector<std::size_t> active(lanes.size());
+			for (std::size_t i = 0; i < lanes.size(); ++i) {
+				lanes[i].c  = lanes[i].b;
+				lanes[i].fc = lanes[i].fb;
+				active[i]   = i;
+			}
+
+			std::vector<Type> xs, fs;
+			for (std::size_t iter = 0; iter < option.max_iter && !active.empty(); ++iter) {
+				/* compaction: the lanes still running come first */
+				std::size_t running = 0;
+				xs.clear();
+				for (std::size_t i : active) {
+					if (brent_step(lanes[i], option.tol)) {
+						active[running++] = i;
+						xs.push_back(lanes[i].b);
+					}
+				}
+				active.resize(running);
+				if (active.empty())
+					break;
+
+				evaluate(xs, fs, nullptr, option.threads);
+				for (std::size_t k = 0; k < active.size(); ++k) {
+					lanes[active[k]].fb = fs[k];
+				}
+			}
+
+			for (const BrentLane& lane : lanes) {
+				/* a pole looks like a bracket, and its value grows while it is refined */
+				using std::abs;
+				if (finite(lane.fb) && abs(lane.fb) <= lane.bound)
+					roots.push_back(lane.b);
+			}
+		}
+
+		void refine_newton(std::vector<NewtonLane>& lanes, std::vector<Type>& roots, const Option& option) const
+		{
+			std::vector<std::size_t> active(lanes.size());
+			std::vector<Type> xs, fs, dfs;
+			for (std::size_t i = 0; i < lanes.size(); ++i) {
+				active[i] = i;
+				xs.push_back(lanes[i].x);
+			}
+
+			for (std::size_t iter = 0; iter < option.max_iter && !active.empty(); ++iter) {
+				evaluate(xs, fs, &dfs, option.threads);
+				std::size_t running = 0;
+				xs.clear();
+				for (std::size_t k = 0; k < active.size(); ++k) {
+					NewtonLane& lane = lanes[active[k]];
+					lane.f  = fs[k];
+					lane.df = dfs[k];
+					if (newton_step(lane, option.tol)) {
+						active[running++] = active[k];
+						xs.push_back(lane.x);
+					}
+				}
+				active.resize(running);
+			}
+
+			for (const NewtonLane& lane : lanes) {
+				using std::abs;
+				if (finite(lane.f) && abs(lane.f) <= lane.bound)
+					roots.push_back(lane.x);
+			}
+		}
+
+	public:
+		/**
+		 * @param program program with one free variable
+		 * @throw `std::invalid_argument` if the program does not have one free variable
+		 */
+		RootFinder(const Program<Type>& program)
+			: program(program)
+		{
+			if (program.variable_num() != 1) {
+				throw std::invalid_argument("RootFinder: program must have one variable");
+			}
+		}
+
+		/**
+		 * @brief compile the function
+		 *
+		 * @param formula  formula like "cos(x) - x"
+		 * @param variable variable string
+		 * @param table    values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		RootFinder(const std::string& formula, const std::string& variable,
+		           const VariableTable<Type>& table = VariableTable<Type>())
+		{
+			program = Syamfp<Type>::compile(formula, {variable}, table);
+		}
+
+		~RootFinder() = default;
+
+		/**
+		 * @brief find the roots on [a, b]
+		 *
+		 * @param a, b   interval
+		 * @param option method and limits
+		 * @return `std::vector<Type>` roots in ascending order
+		 */
+		std::vector<Type> find(const Type& a, const Type& b, const Option& option = Option()) const
+		{
+			using std::abs;
+			std::vector<Type> roots;
+			if (b < a)
+				return find(b, a, option);
+
+			/* sample for bracketing */
+			const std::size_t samples = std::max<std::size_t>(option.samples, 1);
+			std::vector<Type> xs(samples + 1), fs;
+			for (std::size_t i = 0; i <= samples; ++i) {
+				xs[i] = a + (b - a) * Details::num<Type>(static_cast<double>(i) / static_cast<double>(samples));
+			}
+			xs[samples] = b;
+			evaluate(xs, fs, nullptr, option.threads);
+
+			const Type zero = Details::num<Type>(0.0);
+			std::vector<BrentLane>  brent;
+			std::vector<NewtonLane> newton;
+			for (std::size_t i = 0; i <= samples; ++i) {
+				if (fs[i] == zero) {
+					roots.push_back(xs[i]);
+					continue;
+				}
+				if (i == samples || fs[i + 1] == zero || !finite(fs[i]) || !finite(fs[i + 1]))
+					continue;
+				if (negative(fs[i]) == negative(fs[i + 1]))
+					continue;
+
+				const Type bound = std::min(abs(fs[i]), abs(fs[i + 1]));
+				if (option.method == Method::Brent) {
+					brent.push_back({ xs[i], xs[i + 1], zero, fs[i], fs[i + 1], zero, zero, zero, bound });
+				} else {
+					const bool rising = negative(fs[i]);
+					const Type lo = rising ? xs[i] : xs[i + 1];
+					const Type hi = rising ? xs[i + 1] : xs[i];
+					newton.push_back({ lo, hi, Details::num<Type>(0.5) * (lo + hi), zero, zero, abs(hi - lo), abs(hi - lo), bound });
+				}
+			}
+
+			if (option.method == Method::Brent)
+				refine_brent(brent, roots, option);
+			else
+				refine_newton(newton, roots, option);
+
+			std::sort(roots.begin(), roots.end());
+			return roots;
+		}
+	};
+
+
+	/**
+	 * @brief find all roots of the formula on [a, b]
+	 *
+	 * @param formula  formula like "cos(x) - x"
+	 * @param variable variable string
+	 * @param a, b     interval
+	 * @param table    values of the other variables
+	 * @param option   method and limits
+	 * @return `std::vector<Type>` roots in ascending order
+	 * @throw `std::invalid_argument` if the formula is invalid
+	 * @throw `std::runtime_error` if unknown variable is included in formula
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	std::vector<Type> find_roots(const std::string& formula, const std::string& variable,
+	                             const Type& a, const Type& b,
+	                             const VariableTable<Type>& table = VariableTable<Type>(),
+	                             const typename RootFinder<Type>::Option& option = typename RootFinder<Type>::Option())
+	{
+		return RootFinder<Type>(formula, variable, table).find(a, b, option);
+	}
+}
+
+#endif /* end of __SYAMFP_ROOTS_HPP__ */
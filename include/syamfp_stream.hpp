@@ -0,0 +1,527 @@
+/**
+ * @file syamfp_stream.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Streaming evaluation of recurrences and time-series references
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_STREAM_HPP__
+#define __SYAMFP_STREAM_HPP__
+
+#include "syamfp.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @return `bool` true if the value is a positive integer `n` */
+		template <MathConcept Type>
+		bool is_window_size(const Type& value, int& n)
+		{
+			ValueType re, im = 0;
+			if constexpr (requires { static_cast<ValueType>(value.real()); static_cast<ValueType>(value.imag()); }) {
+				re = static_cast<ValueType>(value.real());
+				im = static_cast<ValueType>(value.imag());
+			} else if constexpr (requires { static_cast<ValueType>(value); }) {
+				re = static_cast<ValueType>(value);
+			} else {
+				return false;
+			}
+
+			if (im != 0 || re < 1 || re > static_cast<ValueType>(1 << 30) || re != static_cast<ValueType>(static_cast<int>(re)))
+				return false;
+
+			n = static_cast<int>(re);
+			return true;
+		}
+
+		/**
+		 * @brief state of a rolling-window function updated in O(1) per sample
+		 *
+		 * sma keeps a running sum recomputed from the ring buffer once per window to bound the drift,
+		 * wmin and wmax keep a monotonic deque in a fixed ring buffer, and wstd keeps Welford's mean and
+		 * sum of squared deviations updated by the entering and leaving samples.
+		 * Before the window is filled, the functions are evaluated over the available samples.
+		 */
+		template <MathConcept Type>
+		class RollingWindow
+		{
+		public:
+			enum class Kind { Sma, Ema, Min, Max, Std };
+
+		private:
+			Kind kind;
+			std::size_t size;
+			std::vector<Type> ring;        /* the last `size` samples */
+			std::size_t count = 0;         /* the number of samples so far */
+			Type sum  = num<Type>(0.0);
+			Type mean = num<Type>(0.0);
+			Type m2   = num<Type>(0.0);
+			std::vector<std::pair<std::size_t, Type>> deque;  /* (time, value) of monotonic deque */
+			std::size_t front = 0;
+			std::size_t length = 0;
+
+			/** @brief push into monotonic deque. `Less` is true if the new value dominates the back. */
+			template <typename Less>
+			Type push_extreme(const Type& x, Less less)
+			{
+				if (length != 0 && deque[front].first + size <= count) {
+					front = (front + 1) % size;
+					length--;
+				}
+				while (length != 0 && !less(deque[(front + length - 1) % size].second, x)) {
+					length--;
+				}
+				deque[(front + length) % size] = { count, x };
+				length++;
+				return deque[front].second;
+			}
+
+		public:
+			RollingWindow(Kind kind, std::size_t size)
+				: kind(kind), size(std::max<std::size_t>(size, 1))
+			{
+				if (kind != Kind::Ema)
+					ring.resize(this->size);
+				if (kind == Kind::Min || kind == Kind::Max)
+					deque.resize(this->size);
+			}
+
+			/** @brief forget all samples */
+			void reset(void)
+			{
+				const Type zero = num<Type>(0.0);
+				std::ranges::fill(ring, zero);
+				count  = 0;
+				sum    = zero;
+				mean   = zero;
+				m2     = zero;
+				front  = 0;
+				length = 0;
+			}
+
+			/**
+			 * @brief update the window by the next sample
+			 * @param x     the next sample
+			 * @param param smoothing factor of ema (ignored by the others)
+			 * @return `Type` value of the function over the window
+			 */
+			Type push(const Type& x, const Type& param)
+			{
+				if (kind == Kind::Ema) {
+					sum = (count == 0) ? x : param * x + (num<Type>(1.0) - param) * sum;
+					count++;
+					return sum;
+				}
+
+				Type& slot = ring[count % size];
+				const Type old = slot;
+				const bool full = (count >= size);
+				slot = x;
+
+				Type result = x;
+				switch (kind)
+				{
+				case Kind::Sma :
+					if (count % size == size - 1) {
+						/* recompute to cancel the accumulated rounding error */
+						sum = num<Type>(0.0);
+						for (const Type& value : ring) {
+							sum += value;
+						}
+					} else {
+						sum += full ? x - old : x;
+					}
+					result = sum / num<Type>(std::min(count + 1, size));
+					break;
+				case Kind::Min :
+					if constexpr (std::totally_ordered<Type>)
+						result = push_extreme(x, [](const Type& a, const Type& b) { return a < b; });
+					break;
+				case Kind::Max :
+					if constexpr (std::totally_ordered<Type>)
+						result = push_extreme(x, [](const Type& a, const Type& b) { return a > b; });
+					break;
+				case Kind::Std :
+					if constexpr (std::totally_ordered<Type>) {
+						if (full) {
+							const Type next = mean + (x - old) / num<Type>(size);
+							m2 += (x - old) * (x - next + old - mean);
+							mean = next;
+						} else {
+							const Type delta = x - mean;
+							mean += delta / num<Type>(count + 1);
+							m2 += delta * (x - mean);
+						}
+						using std::sqrt;
+						const Type zero = num<Type>(0.0);
+						result = sqrt(std::max(m2, zero) / num<Type>(std::min(count + 1, size)));
+					}
+					break;
+				default :
+					break;
+				}
+
+				count++;
+				return result;
+			}
+		};
+	}
+
+
+	/**
+	 * @brief evaluator of formulas referencing the previous samples like "y = 0.9*y[-1] + 0.1*x"
+	 *
+	 * `x[-k]` is the input x of k samples before, and `y[-k]` is the previous output.
+	 * The history of each stream is kept just before the current chunk in one buffer, so that
+	 * a reference `x[-k]` is a column shifted by k. Formulas without output references are
+	 * evaluated by batch evaluation, and recurrences are evaluated sample by sample.
+	 * The history before the first sample is zero.
+	 *
+	 * Rolling-window functions `sma(x, n)`, `ema(x, a)`, `wmin(x, n)`, `wmax(x, n)` and `wstd(x, n)`
+	 * are split from the formula: the argument is compiled into its own program, and its values
+	 * are pushed into the window state of each occurrence. `n` must be a constant positive integer.
+	 */
+	template <Details::MathConcept Type = double>
+	class StreamEvaluator
+	{
+	public:
+		/** @brief the number of samples evaluated at once */
+		static constexpr std::size_t CHUNK = 1024;
+
+	private:
+		/** @brief free variable of a program: the sample `lag` before of the stream, or the output of the window */
+		struct Source
+		{
+			bool        window;
+			std::size_t index;   /* stream (input index, or the number of inputs for the output) or window */
+			std::size_t lag;
+		};
+
+		/** @brief program and its free variables */
+		struct Stage
+		{
+			Program<Type> program;
+			typename Program<Type>::Workspace ws;
+			std::vector<Source> sources;
+			std::vector<const Type*> columns;
+			std::vector<Type> vars;
+		};
+
+		struct Window
+		{
+			Details::RollingWindow<Type> state;
+			Stage arg;
+			Stage param;             /* smoothing factor of ema */
+			std::vector<Type> column;  /* output of the current chunk */
+			std::vector<Type> params;
+		};
+
+		static constexpr const char* WINDOW_PREFIX = "#w";
+
+		std::vector<std::string> inputs;
+		std::string output = "y";
+		std::size_t input_num;
+		std::vector<Window> windows;
+		Stage main;
+		std::vector<std::vector<Type>> buffers;  /* history and current chunk of each stream */
+		std::vector<std::size_t> history;        /* the number of samples kept in each stream */
+		bool recursive = false;
+
+		/** @return `std::size_t` the first index of the sub-expression ending at `end` in rpn */
+		static std::size_t begin_of(const Details::RPNs<Type>& rpn, std::size_t end)
+		{
+			int need = 1;
+			while (need > 0) {
+				if (end == 0) {
+					throw std::invalid_argument("Invalid formula: missing argument");
+				}
+				--end;
+				need--;
+				if (rpn[end].type == Details::TokenType::Operator || rpn[end].type == Details::TokenType::Func1
+				    || rpn[end].type == Details::TokenType::Func2 || rpn[end].type == Details::TokenType::Func3) {
+					need += rpn[end].arg_num;
+				}
+			}
+			return end;
+		}
+
+		/** @brief compile rpn with resolving its variables into sources */
+		Stage compile(const Details::RPNs<Type>& rpn, const VariableTable<Type>& table)
+		{
+			static const std::regex Lagged(R"(^([^\[\]]+)\[([+-]?\d+)\]$)");
+
+			std::vector<std::string> names;
+			for (const Details::Token<Type>& token : rpn) {
+				if (token.type == Details::TokenType::Variable && std::ranges::find(names, token.str) == names.end())
+					names.push_back(token.str);
+			}
+			std::ranges::sort(names);
+
+			Stage stage;
+			std::vector<std::string> variables;
+			for (const std::string& str : names) {
+				if (str.starts_with(WINDOW_PREFIX)) {
+					variables.push_back(str);
+					stage.sources.push_back({ true, std::stoul(str.substr(2)), 0 });
+					continue;
+				}
+
+				std::smatch match;
+				std::string base = str;
+				long lag = 0;
+				if (std::regex_match(str, match, Lagged)) {
+					base = match[1];
+					lag  = -std::stol(match[2]);
+				}
+
+				std::size_t stream;
+				if (auto it = std::ranges::find(inputs, base); it != inputs.end()) {
+					stream = static_cast<std::size_t>(it - inputs.begin());
+				} else if (base == output) {
+					stream = input_num;
+					if (lag == 0) {
+						throw std::invalid_argument("Invalid formula: output " + output + " is referenced without delay");
+					}
+					recursive = true;
+				} else if (lag == 0) {
+					continue;  /* parameter */
+				} else {
+					throw std::runtime_error("Invalid function: unknown stream " + base);
+				}
+
+				if (lag < 0) {
+					throw std::invalid_argument("Invalid formula: future sample is referenced: " + str);
+				}
+				variables.push_back(str);
+				stage.sources.push_back({ false, stream, static_cast<std::size_t>(lag) });
+			}
+
+			stage.program = Program<Type>(rpn, variables, table);
+			stage.ws      = stage.program.make_workspace();
+			stage.columns.resize(stage.sources.size());
+			stage.vars.resize(stage.sources.size());
+			return stage;
+		}
+
+		/** @return `const Type*` value of the source at i-th sample of the current chunk */
+		const Type* locate(const Source& source, std::size_t i) const
+		{
+			if (source.window)
+				return windows[source.index].column.data() + i;
+			return buffers[source.index].data() + history[source.index] + i - source.lag;
+		}
+
+		/** @brief evaluate the stage for `m` samples of the current chunk */
+		void eval_chunk(Stage& stage, std::size_t m, Type* out)
+		{
+			for (std::size_t k = 0; k < stage.sources.size(); ++k) {
+				stage.columns[k] = locate(stage.sources[k], 0);
+			}
+			stage.program.eval_batch(m, stage.columns.data(), out, stage.ws);
+		}
+
+		/** @brief evaluate the stage at i-th sample of the current chunk */
+		Type eval_sample(Stage& stage, std::size_t i)
+		{
+			for (std::size_t k = 0; k < stage.sources.size(); ++k) {
+				stage.vars[k] = *locate(stage.sources[k], i);
+			}
+			return stage.program.eval(stage.vars.data(), stage.ws);
+		}
+
+	public:
+		/**
+		 * @brief compile the formula
+		 *
+		 * @param formula formula like "y = 0.9*y[-1] + 0.1*x". The output name is "y" if the left side is omitted.
+		 * @param inputs  input stream names
+		 * @param table   values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid, e.g. a reference of the future or the current output
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		StreamEvaluator(const std::string& formula, const std::vector<std::string>& inputs,
+		                const VariableTable<Type>& table = VariableTable<Type>())
+			: inputs(inputs), input_num(inputs.size())
+		{
+			using Kind = typename Details::RollingWindow<Type>::Kind;
+			static const std::unordered_map<std::string, Kind> KINDS =
+			{
+				{ "sma",  Kind::Sma },
+				{ "ema",  Kind::Ema },
+				{ "wmin", Kind::Min },
+				{ "wmax", Kind::Max },
+				{ "wstd", Kind::Std },
+			};
+
+			std::string expr = formula;
+			if (std::size_t eq = formula.find('='); eq != std::string::npos) {
+				static const std::regex Name(R"(^\s*([^\s\[\]]+)\s*$)");
+				std::smatch match;
+				const std::string left = formula.substr(0, eq);
+				if (!std::regex_match(left, match, Name)) {
+					throw std::invalid_argument("Invalid formula: left side must be an output name: " + formula);
+				}
+				output = match[1];
+				expr   = formula.substr(eq + 1);
+			}
+
+			Syamfp<Type> parser;
+			if (parser.parse(expr, table) != 0) {
+				throw std::invalid_argument("Invalid formula: " + formula);
+			}
+
+			/* split window functions into their own programs. inner windows come first in rpn */
+			Details::RPNs<Type> rpn;
+			for (const Details::Token<Type>& token : Details::make_rpn<Type>(expr)) {
+				auto kind = KINDS.find(token.str);
+				if (token.type != Details::TokenType::Func2 || kind == KINDS.end()) {
+					rpn.push_back(token);
+					continue;
+				}
+
+				if (kind->second != Kind::Sma && kind->second != Kind::Ema && !std::totally_ordered<Type>) {
+					throw std::invalid_argument("Invalid formula: " + token.str + " is available only for ordered type");
+				}
+
+				const std::size_t end2   = rpn.size();
+				const std::size_t begin2 = begin_of(rpn, end2);
+				const std::size_t begin1 = begin_of(rpn, begin2);
+				const Details::RPNs<Type> arg1(rpn.begin() + begin1, rpn.begin() + begin2);
+				const Details::RPNs<Type> arg2(rpn.begin() + begin2, rpn.end());
+
+				std::size_t size = 1;
+				if (kind->second != Kind::Ema) {
+					int n = 0;
+					if (arg2.size() != 1 || (arg2[0].type != Details::TokenType::Real && arg2[0].type != Details::TokenType::Constant)
+					    || !Details::is_window_size(arg2[0].value, n)) {
+						throw std::invalid_argument("Invalid formula: window size of " + token.str + " must be a positive integer");
+					}
+					size = static_cast<std::size_t>(n);
+				}
+
+				Window window{ Details::RollingWindow<Type>(kind->second, size), compile(arg1, table), Stage(), std::vector<Type>(CHUNK), {} };
+				if (kind->second == Kind::Ema) {
+					window.param = compile(arg2, table);
+					window.params.resize(CHUNK);
+				}
+
+				rpn.resize(begin1);
+				rpn.push_back(Details::Token<Type>(WINDOW_PREFIX + std::to_string(windows.size())));
+				windows.push_back(std::move(window));
+			}
+			main = compile(rpn, table);
+
+			/* history of each stream */
+			history.assign(input_num + 1, 0);
+			auto extend = [&](const Stage& stage)
+			{
+				for (const Source& source : stage.sources) {
+					if (!source.window)
+						history[source.index] = std::max(history[source.index], source.lag);
+				}
+			};
+			extend(main);
+			for (const Window& window : windows) {
+				extend(window.arg);
+				extend(window.param);
+			}
+			buffers.resize(input_num + 1);
+			for (std::size_t s = 0; s <= input_num; ++s) {
+				buffers[s].assign(history[s] + CHUNK, Details::num<Type>(0.0));
+			}
+		}
+
+		~StreamEvaluator() = default;
+
+		/**
+		 * @brief evaluate the next `n` samples, continuing the previous call
+		 *
+		 * @param n      the number of samples
+		 * @param inputs `inputs[k][i]` is the i-th sample of k-th input
+		 * @param out    `out[i]` is the i-th output
+		 */
+		void process(std::size_t n, const Type* const* inputs, Type* out)
+		{
+			Type* y = buffers[input_num].data() + history[input_num];
+
+			for (std::size_t base = 0; base < n; base += CHUNK) {
+				const std::size_t m = std::min(CHUNK, n - base);
+				for (std::size_t s = 0; s < input_num; ++s) {
+					std::copy_n(inputs[s] + base, m, buffers[s].data() + history[s]);
+				}
+
+				if (recursive) {
+					for (std::size_t i = 0; i < m; ++i) {
+						for (Window& w : windows) {
+							const Type param = w.params.empty() ? Type() : eval_sample(w.param, i);
+							w.column[i] = w.state.push(eval_sample(w.arg, i), param);
+						}
+						y[i] = eval_sample(main, i);
+					}
+				} else {
+					for (Window& w : windows) {
+						eval_chunk(w.arg, m, w.column.data());
+						if (!w.params.empty())
+							eval_chunk(w.param, m, w.params.data());
+						for (std::size_t i = 0; i < m; ++i) {
+							w.column[i] = w.state.push(w.column[i], w.params.empty() ? Type() : w.params[i]);
+						}
+					}
+					eval_chunk(main, m, y);
+				}
+				std::copy_n(y, m, out + base);
+
+				/* keep the last samples as the history of the next chunk */
+				for (std::size_t s = 0; s <= input_num; ++s) {
+					std::copy_n(buffers[s].begin() + m, history[s], buffers[s].begin());
+				}
+			}
+		}
+
+		/** @brief evaluate the next `n` samples of the formula with one input */
+		void process(std::size_t n, const Type* input, Type* out)
+		{
+			const Type* inputs[1] = { input };
+			process(n, inputs, out);
+		}
+
+		/** @brief evaluate the next sample. @param inputs the current sample of each input */
+		Type step(const Type* inputs)
+		{
+			std::vector<const Type*> ptrs(input_num);
+			for (std::size_t s = 0; s < input_num; ++s) {
+				ptrs[s] = inputs + s;
+			}
+			Type out;
+			process(1, ptrs.data(), &out);
+			return out;
+		}
+
+		/** @brief clear the history to zero and the windows to empty */
+		void reset(void)
+		{
+			for (std::vector<Type>& buffer : buffers) {
+				std::ranges::fill(buffer, Details::num<Type>(0.0));
+			}
+			for (Window& window : windows) {
+				window.state.reset();
+			}
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_STREAM_HPP__ */
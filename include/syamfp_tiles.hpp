@@ -0,0 +1,327 @@
+/**
+ * @file syamfp_tiles.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Progressive and cancellable tile scheduler for interactive rendering
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef __SYAMFP_TILES_HPP__
+#define __SYAMFP_TILES_HPP__
+
+#include "syamfp.hpp"
+
+#include <array>
+#include <atomic>
+#include <complex>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @brief pixel pattern of Adam7 interlace in 8x8 block: origin x, origin y, step x, step y */
+		constexpr std::array<std::array<std::size_t, 4>, 7> ADAM7_PASS =
+		{{
+			{ 0, 0, 8, 8 },
+			{ 4, 0, 8, 8 },
+			{ 0, 4, 4, 8 },
+			{ 2, 0, 4, 4 },
+			{ 0, 2, 2, 4 },
+			{ 1, 0, 2, 2 },
+			{ 0, 1, 1, 2 },
+		}};
+
+		/** @brief size of the block which each pixel of the pass covers until the next pass */
+		constexpr std::array<std::array<std::size_t, 2>, 7> ADAM7_BLOCK =
+		{{
+			{ 8, 8 },
+			{ 4, 8 },
+			{ 4, 4 },
+			{ 2, 4 },
+			{ 2, 2 },
+			{ 1, 2 },
+			{ 1, 1 },
+		}};
+	}
+
+
+	/**
+	 * @brief progressive tile renderer of a formula over a pixel grid
+	 *
+	 * The view is split into tiles, and each tile is evaluated in 7 passes of Adam7 interlace,
+	 * so that a coarse preview of the whole view arrives first. Pending tiles are ordered by
+	 * (pass, distance from the focus pixel), and they are discarded immediately when the view changes.
+	 *
+	 * The program takes the pixel position as one complex variable `z`, or as two variables `x` and `y`.
+	 * Tiles are delivered to the callback from the worker threads.
+	 */
+	template <Details::MathConcept Type = std::complex<double>>
+	class TileScheduler
+	{
+	public:
+		static constexpr std::size_t PASS_NUM = Details::ADAM7_PASS.size();
+
+		struct View
+		{
+			Type        center     = Details::num<Type>(0.0);
+			double      pixel_size = 1.0;  /* width of one pixel */
+			std::size_t width      = 0;
+			std::size_t height     = 0;
+		};
+
+		/** @brief evaluated pixels of one pass of one tile */
+		struct Tile
+		{
+			std::size_t generation;       /* incremented at each set_view(). stale tiles can be discarded by this */
+			std::size_t x, y;             /* upper left pixel of the tile */
+			std::size_t width, height;
+			std::size_t pass;             /* 0, 1, ..., PASS_NUM - 1 */
+			std::size_t block_width;      /* each pixel of this pass can be drawn as a block of this size for preview */
+			std::size_t block_height;
+			std::vector<std::size_t> pixels; /* x + y * view.width */
+			std::vector<Type>        values;
+		};
+
+		using Callback = std::function<void(const Tile&)>;
+
+	private:
+		struct Item
+		{
+			std::size_t x, y, width, height, pass;
+			double      distance;
+
+			/* std::*_heap makes max heap, so that the highest priority must be the greatest */
+			bool operator<(const Item& other) const
+			{
+				if (pass != other.pass)
+					return pass > other.pass;
+				return distance > other.distance;
+			}
+		};
+
+		Program<Type> program;
+		Callback      callback;
+		std::size_t   tile_size;
+
+		std::mutex              mtx;
+		std::condition_variable cv;       /* notified when items are pushed or stopped */
+		std::condition_variable idle_cv;  /* notified when all items are finished */
+		std::vector<Item>       queue;    /* heap */
+		View                    view;
+		double                  focus_x = 0.0;
+		double                  focus_y = 0.0;
+		std::atomic<std::size_t> generation = 0;
+		std::size_t             running = 0;
+		bool                    stop    = false;
+		std::vector<std::thread> workers;
+
+		double distance(const Item& item) const
+		{
+			const double dx = static_cast<double>(item.x) + 0.5 * static_cast<double>(item.width)  - focus_x;
+			const double dy = static_cast<double>(item.y) + 0.5 * static_cast<double>(item.height) - focus_y;
+			return dx * dx + dy * dy;
+		}
+
+		/** @return `Type` position of the pixel in the complex plane */
+		static Type position(const View& v, std::size_t px, std::size_t py)
+		{
+			const double x = (static_cast<double>(px) - 0.5 * static_cast<double>(v.width))  * v.pixel_size;
+			const double y = (0.5 * static_cast<double>(v.height) - static_cast<double>(py)) * v.pixel_size;
+			return v.center + static_cast<Type>(std::complex<Details::ValueType>(x, y));
+		}
+
+		/** @brief evaluate one item. @return `bool` false if cancelled */
+		bool process(const Item& item, const View& v, std::size_t gen,
+		             typename Program<Type>::Workspace& ws, Tile& tile) const
+		{
+			const auto& [ox, oy, sx, sy] = Details::ADAM7_PASS[item.pass];
+
+			tile.generation   = gen;
+			tile.x            = item.x;
+			tile.y            = item.y;
+			tile.width        = item.width;
+			tile.height       = item.height;
+			tile.pass         = item.pass;
+			tile.block_width  = Details::ADAM7_BLOCK[item.pass][0];
+			tile.block_height = Details::ADAM7_BLOCK[item.pass][1];
+			tile.pixels.clear();
+			for (std::size_t py = item.y + oy; py < item.y + item.height; py += sy) {
+				for (std::size_t px = item.x + ox; px < item.x + item.width; px += sx) {
+					tile.pixels.push_back(px + py * v.width);
+				}
+			}
+
+			/* positions in SoA */
+			const std::size_t n = tile.pixels.size();
+			std::vector<Type> zs(n), ys;
+			for (std::size_t i = 0; i < n; ++i) {
+				zs[i] = position(v, tile.pixels[i] % v.width, tile.pixels[i] / v.width);
+			}
+			if (program.variable_num() == 2) {
+				if constexpr (requires(Type a) { static_cast<Type>(a.real()); static_cast<Type>(a.imag()); }) {
+					ys.resize(n);
+					for (std::size_t i = 0; i < n; ++i) {
+						ys[i] = static_cast<Type>(zs[i].imag());
+						zs[i] = static_cast<Type>(zs[i].real());
+					}
+				}
+			}
+
+			/* evaluate with checking cancellation */
+			constexpr std::size_t CHUNK = 4 * Program<Type>::BLOCK;
+			tile.values.resize(n);
+			for (std::size_t begin = 0; begin < n; begin += CHUNK) {
+				if (generation.load(std::memory_order_relaxed) != gen)
+					return false;
+
+				const Type* columns[2] = { zs.data() + begin, ys.empty() ? nullptr : ys.data() + begin };
+				program.eval_batch(std::min(CHUNK, n - begin), columns, tile.values.data() + begin, ws);
+			}
+			return generation.load(std::memory_order_relaxed) == gen;
+		}
+
+		void work(void)
+		{
+			typename Program<Type>::Workspace ws = program.make_workspace();
+			Tile tile;
+
+			std::unique_lock<std::mutex> lock(mtx);
+			while (true) {
+				cv.wait(lock, [&] { return stop || !queue.empty(); });
+				if (stop)
+					return;
+
+				std::pop_heap(queue.begin(), queue.end());
+				const Item item = queue.back();
+				queue.pop_back();
+				const View v = view;
+				const std::size_t gen = generation.load();
+				running++;
+				lock.unlock();
+
+				if (process(item, v, gen, ws, tile) && callback)
+					callback(tile);
+
+				lock.lock();
+				running--;
+				if (queue.empty() && running == 0)
+					idle_cv.notify_all();
+			}
+		}
+
+	public:
+		/**
+		 * @brief start worker threads
+		 *
+		 * @param program   program with one complex variable (pixel position) or two variables (x, y)
+		 * @param callback  function called with each evaluated tile. This is called from worker threads.
+		 * @param tile_size width and height of tiles, rounded up to a multiple of 8
+		 * @param threads   the number of worker threads. `0` means the number of hardware threads.
+		 * @throw `std::invalid_argument` if the number of variables of the program is not 1 or 2
+		 */
+		TileScheduler(const Program<Type>& program, Callback callback, std::size_t tile_size = 64, std::size_t threads = 0)
+			: program(program), callback(std::move(callback)), tile_size((std::max<std::size_t>(tile_size, 1) + 7) / 8 * 8)
+		{
+			if (program.variable_num() != 1 && program.variable_num() != 2) {
+				throw std::invalid_argument("TileScheduler: program must have 1 or 2 variables");
+			}
+			if constexpr (!requires(Type a) { static_cast<Type>(a.real()); static_cast<Type>(a.imag()); }) {
+				if (program.variable_num() == 2) {
+					throw std::invalid_argument("TileScheduler: 2 variables are available only for complex number");
+				}
+			}
+
+			for (std::size_t n = Details::ret_thread_num(threads); n > 0; --n) {
+				workers.emplace_back(&TileScheduler::work, this);
+			}
+		}
+
+		TileScheduler(const TileScheduler&) = delete;
+		TileScheduler& operator=(const TileScheduler&) = delete;
+
+		~TileScheduler()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				stop = true;
+				generation++;
+			}
+			cv.notify_all();
+			for (std::thread& th : workers) {
+				th.join();
+			}
+		}
+
+		/**
+		 * @brief cancel all pending tiles and start rendering of the new view
+		 * @param focus_x, focus_y pixel near which tiles are rendered first. Negative means the center.
+		 * @return `std::size_t` generation of the tiles of this view
+		 */
+		std::size_t set_view(const View& v, double focus_x = -1.0, double focus_y = -1.0)
+		{
+			std::size_t gen;
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				gen = ++generation;
+				view = v;
+				this->focus_x = (focus_x < 0.0) ? 0.5 * static_cast<double>(v.width)  : focus_x;
+				this->focus_y = (focus_y < 0.0) ? 0.5 * static_cast<double>(v.height) : focus_y;
+
+				queue.clear();
+				for (std::size_t pass = 0; pass < PASS_NUM; ++pass) {
+					for (std::size_t y = 0; y < v.height; y += tile_size) {
+						for (std::size_t x = 0; x < v.width; x += tile_size) {
+							Item item = { x, y, std::min(tile_size, v.width - x), std::min(tile_size, v.height - y), pass, 0.0 };
+							item.distance = distance(item);
+							queue.push_back(item);
+						}
+					}
+				}
+				std::make_heap(queue.begin(), queue.end());
+				if (queue.empty() && running == 0)
+					idle_cv.notify_all();
+			}
+			cv.notify_all();
+			return gen;
+		}
+
+		/** @brief render tiles near the pixel first. e.g. call this when the cursor moves */
+		void set_focus(double focus_x, double focus_y)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			this->focus_x = focus_x;
+			this->focus_y = focus_y;
+			for (Item& item : queue) {
+				item.distance = distance(item);
+			}
+			std::make_heap(queue.begin(), queue.end());
+		}
+
+		/** @brief cancel all pending and running tiles */
+		void cancel(void)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			generation++;
+			queue.clear();
+			if (running == 0)
+				idle_cv.notify_all();
+		}
+
+		/** @brief wait until all tiles of the current view are finished or cancelled */
+		void wait(void)
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			idle_cv.wait(lock, [&] { return queue.empty() && running == 0; });
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_TILES_HPP__ */
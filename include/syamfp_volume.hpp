@@ -0,0 +1,301 @@
+/**
+ * @file syamfp_volume.hpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief Out-of-core evaluation of formulas of three variables over volumes streamed to a file
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * @note POSIX only (pwrite).
+ */
+
+#ifndef __SYAMFP_VOLUME_HPP__
+#define __SYAMFP_VOLUME_HPP__
+
+#include "syamfp.hpp"
+#include "syamfp_mmap.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <concepts>
+#include <future>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace SYAMFP
+{
+	namespace Details
+	{
+		/** @brief file opened for writing. the file is closed by the destructor */
+		class OutputFile
+		{
+		private:
+			int fd = -1;
+
+		public:
+			/**
+			 * @brief create or truncate the file and resize it to `size` bytes
+			 * @throw `std::runtime_error` if the file cannot be created
+			 */
+			OutputFile(const std::string& path, std::size_t size)
+			{
+				fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+				if (fd < 0) {
+					throw std::runtime_error("OutputFile: cannot open " + path);
+				}
+				if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+					::close(fd);
+					fd = -1;
+					throw std::runtime_error("OutputFile: cannot resize " + path);
+				}
+			}
+
+			OutputFile(const OutputFile&) = delete;
+			OutputFile& operator=(const OutputFile&) = delete;
+
+			~OutputFile()
+			{
+				if (fd >= 0)
+					::close(fd);
+			}
+
+			/**
+			 * @brief write all bytes at the offset
+			 * @throw `std::runtime_error` if the write fails
+			 */
+			void write(const void* data, std::size_t bytes, std::size_t offset) const
+			{
+				const char* p = static_cast<const char*>(data);
+				while (bytes > 0) {
+					const ssize_t written = ::pwrite(fd, p, bytes, static_cast<off_t>(offset));
+					if (written < 0) {
+						if (errno == EINTR)
+							continue;
+						throw std::runtime_error("OutputFile: cannot write");
+					}
+					p      += written;
+					bytes  -= static_cast<std::size_t>(written);
+					offset += static_cast<std::size_t>(written);
+				}
+			}
+		};
+	}
+
+
+	/**
+	 * @brief formula of three variables evaluated over a uniform grid of a volume, slab by slab
+	 *
+	 * The volume is divided into slabs of z-planes. Each slab is evaluated by the threaded eval_batch(),
+	 * and written to the file by another thread while the next slab is evaluated into the other buffer,
+	 * so the memory is two slabs whatever the size of the volume. The minimum, the maximum and
+	 * the histogram of the values are accumulated by the writer.
+	 *
+	 * The file is .npy of shape (nz, ny, nx) or raw values in the same order: x is the fastest.
+	 */
+	template <Details::MathConcept Type = double>
+	requires std::totally_ordered<Type>
+	class VolumeEvaluator
+	{
+	public:
+		using Format = typename MappedArray<double>::Format;
+
+		struct Axis
+		{
+			double      min, max;
+			std::size_t points;  /* the number of grid points including both ends. at least 1 */
+		};
+
+		struct Option
+		{
+			std::size_t slab      = 0;             /* z-planes per slab. 0 means about 4M points per slab */
+			std::size_t threads   = 0;             /* 0 means the number of hardware threads */
+			Format      format    = Format::Auto;  /* .npy if the path ends with ".npy", otherwise raw */
+			std::size_t bins      = 0;             /* bins of the histogram. 0 means no histogram */
+			double      histogram_min = 0.0;
+			double      histogram_max = 1.0;
+		};
+
+		/** @brief summary of the values. NaN is counted separately */
+		struct Summary
+		{
+			Type                     min = static_cast<Type>(std::numeric_limits<double>::infinity());
+			Type                     max = static_cast<Type>(-std::numeric_limits<double>::infinity());
+			std::size_t              count = 0;      /* values other than NaN */
+			std::size_t              nan   = 0;
+			std::vector<std::size_t> histogram;      /* histogram[b] is the number of values in the b-th bin */
+			std::size_t              below = 0;      /* values out of the range of the histogram */
+			std::size_t              above = 0;
+		};
+
+	private:
+		static constexpr std::size_t SLAB_POINTS = std::size_t(1) << 22;
+
+		Program<Type>     program;
+		std::vector<Axis> axes;
+
+		static double coordinate(const Axis& a, std::size_t i)
+		{
+			return (a.points == 1) ? a.min : a.min + (a.max - a.min) * static_cast<double>(i) / static_cast<double>(a.points - 1);
+		}
+
+		void check(void) const
+		{
+			if (program.variable_num() != 3 || axes.size() != 3) {
+				throw std::invalid_argument("VolumeEvaluator: three variables and three axes are needed");
+			}
+			for (const Axis& a : axes) {
+				if (a.points == 0) {
+					throw std::invalid_argument("VolumeEvaluator: an axis has no point");
+				}
+			}
+		}
+
+		static void accumulate(Summary& summary, const Type* values, std::size_t n, const Option& option)
+		{
+			const double scale = static_cast<double>(option.bins) / (option.histogram_max - option.histogram_min);
+			for (std::size_t i = 0; i < n; ++i) {
+				const Type v = values[i];
+				if (v != v) {
+					++summary.nan;
+					continue;
+				}
+				++summary.count;
+				if (v < summary.min)
+					summary.min = v;
+				if (summary.max < v)
+					summary.max = v;
+
+				if (option.bins == 0)
+					continue;
+				const double u = (static_cast<double>(v) - option.histogram_min) * scale;
+				if (u < 0.0) {
+					++summary.below;
+				} else if (static_cast<double>(v) > option.histogram_max) {
+					++summary.above;
+				} else {
+					/* the maximum belongs to the last bin */
+					++summary.histogram[std::min(static_cast<std::size_t>(u), option.bins - 1)];
+				}
+			}
+		}
+
+	public:
+		/**
+		 * @param program program of which free variables are x, y and z
+		 * @param axes    grid of x, y and z
+		 * @throw `std::invalid_argument` if the axes do not match the free variables
+		 */
+		VolumeEvaluator(const Program<Type>& program, const std::vector<Axis>& axes)
+			: program(program), axes(axes)
+		{
+			check();
+		}
+
+		/**
+		 * @brief compile the formula
+		 *
+		 * @param formula   formula like "sin(x)*cos(y) + z"
+		 * @param variables variable strings of the axes in the order of x, y and z
+		 * @param axes      grid of each variable
+		 * @param table     values of the other variables
+		 * @throw `std::invalid_argument` if the formula is invalid, or the axes do not match the variables
+		 * @throw `std::runtime_error` if unknown variable is included in formula
+		 */
+		VolumeEvaluator(const std::string& formula, const std::vector<std::string>& variables, const std::vector<Axis>& axes,
+		                const VariableTable<Type>& table = VariableTable<Type>())
+			: axes(axes)
+		{
+			program = Syamfp<Type>::compile(formula, variables, table);
+			check();
+		}
+
+		~VolumeEvaluator() = default;
+
+		/**
+		 * @brief evaluate the volume and write it to the file
+		 *
+		 * @param output file of the values, which is created or overwritten. empty string writes no file
+		 * @param option size of slabs, threads, format and histogram
+		 * @return `Summary` minimum, maximum and histogram of the values
+		 * @throw `std::invalid_argument` if the histogram is invalid, or .npy is requested for a type other than double
+		 * @throw `std::runtime_error` if the file cannot be written
+		 */
+		Summary run(const std::string& output, const Option& option = Option()) const
+		{
+			if (option.bins != 0 && !(option.histogram_min < option.histogram_max)) {
+				throw std::invalid_argument("VolumeEvaluator: the range of the histogram is empty");
+			}
+
+			const std::size_t nx = axes[0].points, ny = axes[1].points, nz = axes[2].points;
+			const std::size_t plane = nx * ny;
+			const std::size_t slab  = std::min(nz, (option.slab != 0) ? option.slab : std::max<std::size_t>(1, SLAB_POINTS / plane));
+
+			/* header and file */
+			std::string header;
+			const bool npy = option.format == Format::Npy
+			              || (option.format == Format::Auto && output.size() >= 4 && output.compare(output.size() - 4, 4, ".npy") == 0);
+			if (npy) {
+				if constexpr (std::is_same_v<Type, double>) {
+					header = Details::npy_header<Type>({ nz, ny, nx });
+				} else {
+					throw std::invalid_argument("VolumeEvaluator: .npy is supported for double only");
+				}
+			}
+			std::unique_ptr<Details::OutputFile> out;
+			if (!output.empty()) {
+				out = std::make_unique<Details::OutputFile>(output, header.size() + plane * nz * sizeof(Type));
+				out->write(header.data(), header.size(), 0);
+			}
+
+			/* x and y are the same in every slab */
+			std::vector<Type> xs(slab * plane), ys(slab * plane), zs(slab * plane);
+			for (std::size_t j = 0; j < ny; ++j) {
+				for (std::size_t i = 0; i < nx; ++i) {
+					xs[j * nx + i] = Details::num<Type>(coordinate(axes[0], i));
+					ys[j * nx + i] = Details::num<Type>(coordinate(axes[1], j));
+				}
+			}
+			for (std::size_t k = 1; k < slab; ++k) {
+				std::copy(xs.begin(), xs.begin() + plane, xs.begin() + k * plane);
+				std::copy(ys.begin(), ys.begin() + plane, ys.begin() + k * plane);
+			}
+			const Type* cols[3] = { xs.data(), ys.data(), zs.data() };
+
+			Summary summary;
+			summary.histogram.assign(option.bins, 0);
+
+			/* double buffer: one slab is evaluated while the other is written */
+			std::vector<Type> buffers[2] = { std::vector<Type>(slab * plane), std::vector<Type>(slab * plane) };
+			std::future<void> pending;
+			for (std::size_t begin = 0, s = 0; begin < nz; begin += slab, s ^= 1) {
+				const std::size_t planes = std::min(slab, nz - begin);
+				for (std::size_t k = 0; k < planes; ++k) {
+					std::fill_n(zs.begin() + k * plane, plane, Details::num<Type>(coordinate(axes[2], begin + k)));
+				}
+				program.eval_batch(planes * plane, cols, buffers[s].data(), option.threads);
+
+				if (pending.valid())
+					pending.get();  /* the other buffer is free, and the summary is not used by the writer */
+				pending = std::async(std::launch::async, [&, s, begin, planes]
+				{
+					const std::size_t n = planes * plane;
+					accumulate(summary, buffers[s].data(), n, option);
+					if (out)
+						out->write(buffers[s].data(), n * sizeof(Type), header.size() + begin * plane * sizeof(Type));
+				});
+			}
+			if (pending.valid())
+				pending.get();
+			return summary;
+		}
+	};
+}
+
+#endif /* end of __SYAMFP_VOLUME_HPP__ */
@@ -0,0 +1,127 @@
+/**
+ * @file array_consistency.cpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief eval() and eval_batch() must agree on formulas with array variables and vectors
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * Short arrays (up to 4 components) are evaluated by blocks in eval_batch(), and longer ones element by element,
+ * so both paths are compared against eval() and eval_derivative(). The exit status is the number of failures.
+ *
+ * build: g++ -std=c++20 -O2 -pthread -Iinclude tests/array_consistency.cpp -o array-consistency
+ */
+
+#include "syamfp.hpp"
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	template <typename Type>
+	double distance(const Type& a, const Type& b)
+	{
+		using std::abs;
+		const double scale = std::max(1.0, static_cast<double>(abs(a)));
+		return static_cast<double>(abs(a - b)) / scale;
+	}
+
+	template <typename Type>
+	Type sample(std::size_t i, int k)
+	{
+		const double v = 0.37 * static_cast<double>(i) - 1.3 + 0.5 * k;
+		if constexpr (std::is_same_v<Type, double>)
+			return v;
+		else
+			return Type(v, 0.2 * k - 0.11 * static_cast<double>(i % 5));
+	}
+
+	/** @return `int` 1 if the evaluations do not agree */
+	template <typename Type>
+	int check(const std::string& formula, const SYAMFP::VariableTable<Type>& table)
+	{
+		constexpr double TOLERANCE = 1e-12;
+		constexpr std::size_t N = 150;  /* more than two blocks, and a partial one */
+
+		SYAMFP::Syamfp<Type> parser;
+		if (parser.parse(formula, table) != 0) {
+			std::printf("FAIL parse: %s\n", formula.c_str());
+			return 1;
+		}
+		const auto program = parser.ret_program({ "x", "y" });
+		auto ws = program.make_workspace();
+
+		std::vector<Type> xs(N), ys(N), out(N), threaded(N), value(N), dout(N);
+		for (std::size_t i = 0; i < N; ++i) {
+			xs[i] = sample<Type>(i, 0);
+			ys[i] = sample<Type>(i, 1);
+		}
+		const Type* columns[] = { xs.data(), ys.data() };
+		program.eval_batch(N, columns, out.data(), ws);
+		program.eval_batch(N, columns, threaded.data(), 3);
+		program.eval_batch_derivative(N, columns, 0, value.data(), dout.data(), ws);
+
+		double worst = 0.0;
+		for (std::size_t i = 0; i < N; ++i) {
+			const Type vars[] = { xs[i], ys[i] };
+			Type derivative;
+			const Type expected = program.eval(vars, ws);
+			const Type with_derivative = program.eval_derivative(vars, 0, ws, derivative);
+			worst = std::max({ worst, distance(expected, out[i]), distance(expected, threaded[i]),
+			                   distance(expected, value[i]), distance(expected, with_derivative), distance(derivative, dout[i]) });
+		}
+		if (!(worst <= TOLERANCE)) {
+			std::printf("FAIL %s: relative difference %g\n", formula.c_str(), worst);
+			return 1;
+		}
+		return 0;
+	}
+
+	template <typename Type>
+	int check_all(void)
+	{
+		SYAMFP::VariableTable<Type> table;
+		table.add_array("a", { sample<Type>(1, 2), sample<Type>(2, 3), sample<Type>(3, 1) });
+		table.add_array("b", { sample<Type>(4, 1), sample<Type>(5, 2), sample<Type>(6, 3) });
+		table.add_array("w", { sample<Type>(1, 1), sample<Type>(2, 2), sample<Type>(3, 3), sample<Type>(4, 4),
+		                       sample<Type>(5, 1), sample<Type>(6, 2), sample<Type>(7, 3), sample<Type>(8, 4) });
+
+		std::vector<std::string> formulas =
+		{
+			/* a scalar first operand shares the register with the result */
+			"dot(x, vec3(1, 2, 3))",
+			"dot(x*y, a) + dot(a, y)",
+			"sum(x + a) * sum(y * b)",
+			"sum(x) + dot(x, x)",
+			"dot(a * x, b - y) + sum(sin(a * y))",
+			"vx(vec3(x, y, 1)) + vy(vec3(x, y, 1)) * vz(vec3(x, y, 1))",
+			"dot(cross(vec3(x, y, 1), a), vec3(y, x, 2))",
+			"vz(cross(a, vec3(x, y, x*y))) + vw(vec4(x, y, 1, x - y))",
+			"dot(vec2(x, y), vec2(y, x)) + x",
+			"dot(w * x, w) + sum(exp(w * y * 0.1))",
+			"dot(x, w) + sum(w)",
+		};
+		if constexpr (std::totally_ordered<Type>) {
+			formulas.push_back("max(a * x) + norm2(b - y) + length(vec3(x, y, 1))");
+			formulas.push_back("max(x) + norm2(x) + max(w * y) + norm2(w + x)");
+		}
+
+		int failures = 0;
+		for (const std::string& formula : formulas) {
+			failures += check<Type>(formula, table);
+		}
+		return failures;
+	}
+}
+
+int main()
+{
+	const int failures = check_all<double>() + check_all<std::complex<double>>();
+	std::printf("%d failure(s)\n", failures);
+	return failures;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file dd_real.cpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief functions of dd_real must be accurate to about 106 bits, and overflow to inf instead of NaN
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * The expected values are rounded from 113-bit (quadruple precision) results at the same arguments.
+ * The arguments are chosen where the formulas lose digits by cancellation or overflow.
+ * The exit status is the number of failures.
+ *
+ * build: g++ -std=c++20 -O2 -Iinclude tests/dd_real.cpp -o dd-real
+ */
+
+#include "syamfp_dd.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace
+{
+	using SYAMFP::dd_real;
+
+	struct Case
+	{
+		const char* name;
+		dd_real     (*function)(const dd_real&);
+		dd_real     x;
+		dd_real     expected;
+	};
+
+	/** @return `int` 1 if the relative error exceeds the tolerance */
+	int check(const Case& c)
+	{
+		constexpr double TOLERANCE = 1e-29;  /* 2^-104 times the condition number of exp and cosh near 709 */
+
+		const dd_real got   = c.function(c.x);
+		const dd_real error = (got - c.expected) / c.expected;
+		if (!(std::abs(error.hi) <= TOLERANCE)) {
+			std::printf("FAIL %s(%.17g): relative error %g\n", c.name, c.x.hi, error.hi);
+			return 1;
+		}
+		return 0;
+	}
+
+	/** @return `int` 1 if the value is not `expected` (inf, 0 or NaN) */
+	int check_special(const char* name, const dd_real& got, double expected)
+	{
+		const bool ok = std::isnan(expected) ? std::isnan(got.hi) : got.hi == expected;
+		if (!ok) {
+			std::printf("FAIL %s: %g instead of %g\n", name, got.hi, expected);
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main()
+{
+	const Case cases[] =
+	{
+		{ "asinh", SYAMFP::asinh, { 0x1.79ca10c924223p-67, 0x1.75447a5d8e536p-121 }, { 0x1.79ca10c924223p-67, 0x1.75447a5d8e536p-121 } },
+			{ "asinh", SYAMFP::asinh, { -0x1.b7cdfd9d7bdbbp-34, 0x1.20a5465df8d2cp-88 }, { -0x1.b7cdfd9d7bdbbp-34, 0x1.20a8a7bff8a4bp-88 } },
+			{ "asinh", SYAMFP::asinh, { 0x1.47ae147ae147bp-7, -0x1.eb851eb851eb8p-63 }, { 0x1.47acae9508b07p-7, -0x1.84728368e6f13p-61 } },
+			{ "asinh", SYAMFP::asinh, { 0x1.cp+1, 0x0p+0 }, { 0x1.f73974f2d01d6p+0, 0x1.e69849e1ec90bp-55 } },
+			{ "asinh", SYAMFP::asinh, { 0x1.4e718d7d7625ap+664, 0x1.6cb428f8ac016p+609 }, { 0x1.cd35cd6cad20fp+8, -0x1.afadf9afc11bdp-46 } },
+			{ "acosh", SYAMFP::acosh, { 0x1.000000006df38p+0, -0x1.3142122a414a9p-57 }, { 0x1.da88051e97436p-17, -0x1.a6657b4d0b24bp-71 } },
+			{ "acosh", SYAMFP::acosh, { 0x1p+0, 0x1.ef2d0f6p-84 }, { 0x1.f7848af97b7d6p-42, 0x1.6c13fb1f1028ep-97 } },
+			{ "acosh", SYAMFP::acosh, { 0x1.8p+0, 0x0p+0 }, { 0x1.ecc2caec5160ap-1, -0x1.ad07ef7ed5a5dp-55 } },
+			{ "acosh", SYAMFP::acosh, { 0x1.4e718d7d7625ap+664, 0x1.6cb428f8ac016p+609 }, { 0x1.cd35cd6cad20fp+8, -0x1.afadf9afc11bdp-46 } },
+			{ "atanh", SYAMFP::atanh, { 0x1.79ca10c924223p-67, 0x1.75447a5d8e536p-121 }, { 0x1.79ca10c924223p-67, 0x1.75447a5d8e536p-121 } },
+			{ "atanh", SYAMFP::atanh, { -0x1.eb851eb851eb8p-6, -0x1.47ae147ae147bp-60 }, { -0x1.ebaae39e3f9f3p-6, 0x1.395590be4d3f9p-60 } },
+			{ "atanh", SYAMFP::atanh, { 0x1.3333333333333p-2, 0x1.999999999999ap-57 }, { 0x1.3cf2b50617c95p-2, 0x1.44ec92a422acdp-56 } },
+			{ "atanh", SYAMFP::atanh, { -0x1.fffffca501acbp-1, 0x1.e57a42bc3d329p-55 }, { -0x1.0cfad9b5fbcadp+3, -0x1.c3582d380c5d5p-53 } },
+			{ "exp", SYAMFP::exp, { 0x1.62cp+9, 0x0p+0 }, { 0x1.81e9b4b52d0c9p+1023, -0x1.40367ff946b15p+964 } },
+			{ "exp", SYAMFP::exp, { -0x1.5555555555555p-2, -0x1.5555555555555p-56 }, { 0x1.6edd3122f2ea5p-1, -0x1.763a67b363af1p-56 } },
+			{ "log", SYAMFP::log, { 0x1.7e43c8800759cp+996, -0x1.698fdc7ace0cap+942 }, { 0x1.5963447f87fb5p+9, 0x1.aada9dc2fafd5p-46 } },
+			{ "log", SYAMFP::log, { 0x1.87e92154ef7acp-665, 0x1.f97db7f888221p-721 }, { -0x1.cc845b54b54f2p+8, 0x1.8e18ec28ae01dp-46 } },
+			{ "log", SYAMFP::log, { 0x1.0000000001198p+0, -0x1.99fb4857bb9ap-54 }, { 0x1.19799812de065p-40, 0x1.c1995dfe190d7p-95 } },
+			{ "sinh", SYAMFP::sinh, { -0x1.e2p+5, 0x0p+0 }, { -0x1.e52e13371119cp+85, -0x1.5d1d26ca041d4p+23 } },
+			{ "sinh", SYAMFP::sinh, { 0x1.5798ee2308c3ap-27, -0x1.03023df2d4c94p-82 }, { 0x1.5798ee2308c3ap-27, -0x1.a57bbc5e76bcep-85 } },
+			{ "cosh", SYAMFP::cosh, { 0x1.62f3333333333p+9, 0x1.999999999999ap-46 }, { 0x1.1fdb71f93362dp+1023, 0x1.b518bfb44d10ap+967 } },
+			{ "tanh", SYAMFP::tanh, { 0x1.8p-1, 0x0p+0 }, { 0x1.45323e552f228p-1, 0x1.39d5832bf78fbp-56 } },
+	};
+
+	int failures = 0;
+	for (const Case& c : cases) {
+		failures += check(c);
+	}
+
+	constexpr double INF = std::numeric_limits<double>::infinity();
+	const double NaN = std::numeric_limits<double>::quiet_NaN();
+	failures += check_special("1/0", dd_real(1.0) / dd_real(0.0), INF);
+	failures += check_special("-1/0", dd_real(-1.0) / 0.0, -INF);
+	failures += check_special("0/0", dd_real(0.0) / dd_real(0.0), NaN);
+	failures += check_special("1/inf", dd_real(1.0) / dd_real(INF), 0.0);
+	failures += check_special("pow(0, -1)", SYAMFP::pow(dd_real(0.0), dd_real(-1.0)), INF);
+	failures += check_special("pow(0, -0.5)", SYAMFP::pow(dd_real(0.0), dd_real(-0.5)), INF);
+	failures += check_special("cosh(-800)", SYAMFP::cosh(dd_real(-800.0)), INF);
+	failures += check_special("sinh(-800)", SYAMFP::sinh(dd_real(-800.0)), -INF);
+	failures += check_special("exp(709.79)", SYAMFP::exp(dd_real(709.79)), INF);
+	failures += check_special("exp(-800)", SYAMFP::exp(dd_real(-800.0)), 0.0);
+	failures += check_special("atanh(1)", SYAMFP::atanh(dd_real(1.0)), INF);
+	failures += check_special("acosh(0.5)", SYAMFP::acosh(dd_real(0.5)), NaN);
+	failures += check_special("log(0)", SYAMFP::log(dd_real(0.0)), -INF);
+	failures += check_special("log(inf)", SYAMFP::log(dd_real(INF)), INF);
+	if (!std::isfinite(SYAMFP::exp(dd_real(709.78)).hi)) {
+		std::printf("FAIL exp(709.78) overflows\n");
+		failures++;
+	}
+
+	std::printf("%d failure(s)\n", failures);
+	return failures;
+}
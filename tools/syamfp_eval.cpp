@@ -0,0 +1,520 @@
+/**
+ * @file syamfp_eval.cpp
+ * @author KATOI (y.yagi@gmail.com)
+ * @brief syamfp-eval: evaluate formulas over the columns of CSV
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * The input is processed by a pipeline of three stages connected by bounded lock-free queues:
+ * the reader parses CSV into chunks of columns, the evaluator runs the batch evaluation with threads,
+ * and the main thread formats and writes the results. The chunks are recycled through the third queue,
+ * so the memory is bounded and a slow stage stops the others (backpressure).
+ *
+ * build: g++ -std=c++20 -O2 -pthread -Iinclude tools/syamfp_eval.cpp -o syamfp-eval
+ */
+
+#include "syamfp.hpp"
+#include "syamfp_realtime.hpp"
+
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const char* USAGE =
+		"Usage: syamfp-eval [options] [name=]formula ...\n"
+		"Evaluate formulas over the columns of CSV. Variables are bound to the columns of the same name.\n"
+		"\n"
+		"  -i FILE       input CSV with a header line (default: stdin)\n"
+		"  -o FILE       output CSV (default: stdout)\n"
+		"  -d CHAR       delimiter (default: ,)\n"
+		"  -D NAME=VALUE value of a variable which is not a column\n"
+		"  -k            copy the input columns to the output\n"
+		"  -t N          the number of evaluation threads (default: hardware threads)\n"
+		"  -c N          rows per chunk (default: 65536)\n"
+		"  -q N          chunks in each queue (default: 4)\n"
+		"  -h            show this help\n";
+
+	struct Options
+	{
+		std::string              input;
+		std::string              output;
+		char                     delimiter = ',';
+		bool                     keep      = false;
+		std::size_t              threads   = 0;
+		std::size_t              rows      = 65536;
+		std::size_t              depth     = 4;
+		std::vector<std::string> names;     /* output columns */
+		std::vector<std::string> formulas;
+		SYAMFP::VariableTable<double> table;
+	};
+
+	/** @brief rows of the input and the results, passed through the pipeline */
+	struct Chunk
+	{
+		std::size_t                      rows = 0;
+		bool                             last = false; /* no rows follow */
+		std::string                      text;         /* input lines without line feeds, kept by -k */
+		std::vector<std::size_t>         ends;         /* end of each line in text */
+		std::vector<std::vector<double>> columns;      /* bound columns */
+		std::vector<std::vector<double>> results;      /* results of formulas */
+		std::string                      out;          /* formatted output */
+	};
+
+	/**
+	 * @brief lock-free queue with blocking wait
+	 *
+	 * A stage waiting for a slow stage spins for a while and then sleeps on `version`,
+	 * which is incremented and notified by every push and pop.
+	 */
+	struct Queue
+	{
+		static constexpr int SPIN = 64;  /* tries before sleeping */
+
+		SYAMFP::Details::SPSCQueue<Chunk*> queue;
+		std::atomic<std::uint32_t>         version = 0;
+
+		explicit Queue(std::size_t capacity)
+			: queue(capacity) {}
+
+		void changed(void)
+		{
+			version.fetch_add(1, std::memory_order_release);
+			version.notify_all();
+		}
+	};
+
+	void push_wait(Queue& queue, Chunk* chunk)
+	{
+		for (int k = 0;; ++k) {
+			/* the version is read before trying, so a pop after the failure wakes up the wait */
+			const std::uint32_t version = queue.version.load(std::memory_order_acquire);
+			if (queue.queue.push(chunk))
+				break;
+			if (k < Queue::SPIN) {
+				std::this_thread::yield();
+			} else {
+				queue.version.wait(version, std::memory_order_acquire);
+			}
+		}
+		queue.changed();
+	}
+
+	Chunk* pop_wait(Queue& queue)
+	{
+		Chunk* chunk;
+		for (int k = 0;; ++k) {
+			const std::uint32_t version = queue.version.load(std::memory_order_acquire);
+			if (queue.queue.pop(chunk))
+				break;
+			if (k < Queue::SPIN) {
+				std::this_thread::yield();
+			} else {
+				queue.version.wait(version, std::memory_order_acquire);
+			}
+		}
+		queue.changed();
+		return chunk;
+	}
+
+	/** @brief reader of lines with its own buffer */
+	class LineReader
+	{
+	private:
+		std::FILE*        file;
+		std::vector<char> buffer;
+		std::size_t       begin = 0;
+		std::size_t       end   = 0;
+		bool              eof   = false;
+
+	public:
+		explicit LineReader(std::FILE* file)
+			: file(file), buffer(1 << 20) {}
+
+		/**
+		 * @brief read next line without the line feed
+		 * @return `bool` false at the end of the input
+		 * @throw `std::runtime_error` if reading fails
+		 */
+		bool next(std::string_view& line)
+		{
+			while (true) {
+				const char* first = buffer.data() + begin;
+				const char* lf    = static_cast<const char*>(std::memchr(first, '\n', end - begin));
+				if (lf != nullptr) {
+					line  = std::string_view(first, lf - first);
+					begin = (lf - buffer.data()) + 1;
+					break;
+				}
+				if (eof) {
+					if (begin == end)
+						return false;
+					line  = std::string_view(first, end - begin);
+					begin = end;
+					break;
+				}
+
+				/* move the partial line to the front, and grow the buffer for long lines */
+				std::memmove(buffer.data(), first, end - begin);
+				end  -= begin;
+				begin = 0;
+				if (end == buffer.size())
+					buffer.resize(buffer.size() * 2);
+				const std::size_t n = std::fread(buffer.data() + end, 1, buffer.size() - end, file);
+				if (n == 0) {
+					if (std::ferror(file))
+						throw std::runtime_error("failed to read the input");
+					eof = true;
+				}
+				end += n;
+			}
+
+			if (!line.empty() && line.back() == '\r')
+				line.remove_suffix(1);
+			return true;
+		}
+	};
+
+	/** @brief split the line into fields. the delimiters in double quotes are not separators */
+	void split(std::string_view line, char delimiter, std::vector<std::string_view>& fields)
+	{
+		fields.clear();
+		std::size_t start = 0;
+		bool quoted = false;
+		for (std::size_t i = 0; i < line.size(); ++i) {
+			if (line[i] == '"') {
+				quoted = !quoted;
+			} else if (line[i] == delimiter && !quoted) {
+				fields.push_back(line.substr(start, i - start));
+				start = i + 1;
+			}
+		}
+		fields.push_back(line.substr(start));
+	}
+
+	/** @return `double` value of the field. empty and invalid fields are NaN */
+	double to_number(std::string_view field)
+	{
+		while (!field.empty() && (field.front() == ' ' || field.front() == '"' || field.front() == '+'))
+			field.remove_prefix(1);
+		while (!field.empty() && (field.back() == ' ' || field.back() == '"'))
+			field.remove_suffix(1);
+
+		double value = std::numeric_limits<double>::quiet_NaN();
+		auto [ptr, err] = std::from_chars(field.data(), field.data() + field.size(), value);
+		if (err != std::errc() || ptr != field.data() + field.size())
+			return std::numeric_limits<double>::quiet_NaN();
+		return value;
+	}
+
+	/** @return `std::string` the field quoted if it includes the delimiter or quotes */
+	std::string quote(const std::string& str, char delimiter)
+	{
+		if (str.find(delimiter) == std::string::npos && str.find('"') == std::string::npos)
+			return str;
+
+		std::string result = "\"";
+		for (char c : str) {
+			result += c;
+			if (c == '"')
+				result += '"';
+		}
+		return result + "\"";
+	}
+
+	/** @return `bool` false if the arguments are invalid */
+	bool parse_options(int argc, char** argv, Options& option)
+	{
+		for (int i = 1; i < argc; ++i) {
+			const std::string arg = argv[i];
+			if (arg.size() == 2 && arg[0] == '-' && std::strchr("iodDtcq", arg[1]) != nullptr) {
+				if (i + 1 >= argc)
+					return false;
+				const std::string value = argv[++i];
+				switch (arg[1])
+				{
+				case 'i' : option.input  = value; break;
+				case 'o' : option.output = value; break;
+				case 'd' :
+					if (value.size() != 1)
+						return false;
+					option.delimiter = value[0];
+					break;
+				case 'D' :
+				{
+					const std::size_t eq = value.find('=');
+					if (eq == std::string::npos || eq == 0)
+						return false;
+					option.table.add(value.substr(0, eq), to_number(value.substr(eq + 1)));
+					break;
+				}
+				case 't' : option.threads = std::stoul(value); break;
+				case 'c' : option.rows    = std::max<std::size_t>(std::stoul(value), 1); break;
+				case 'q' : option.depth   = std::max<std::size_t>(std::stoul(value), 1); break;
+				default  : return false;
+				}
+			} else if (arg == "-k") {
+				option.keep = true;
+			} else if (arg == "-h") {
+				return false;
+			} else {
+				/* "name=formula": the name is an identifier before the first "=" */
+				const std::size_t eq = arg.find('=');
+				const bool named = eq != std::string::npos && eq > 0
+					&& arg.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_") == eq;
+				option.names.push_back(named ? arg.substr(0, eq) : arg);
+				option.formulas.push_back(named ? arg.substr(eq + 1) : arg);
+			}
+		}
+		return !option.formulas.empty();
+	}
+
+	/** @brief output of the results of a chunk */
+	void format(const Options& option, Chunk& chunk)
+	{
+		chunk.out.clear();
+		char number[32];
+		std::size_t start = 0;
+		for (std::size_t r = 0; r < chunk.rows; ++r) {
+			bool first = true;
+			if (option.keep) {
+				chunk.out.append(chunk.text, start, chunk.ends[r] - start);
+				start = chunk.ends[r];
+				first = false;
+			}
+			for (const std::vector<double>& result : chunk.results) {
+				if (!first)
+					chunk.out += option.delimiter;
+				first = false;
+				auto [ptr, err] = std::to_chars(number, number + sizeof(number), result[r]);
+				chunk.out.append(number, ptr - number);
+			}
+			chunk.out += '\n';
+		}
+	}
+
+	int run(const Options& option)
+	{
+		std::FILE* in  = option.input.empty()  ? stdin  : std::fopen(option.input.c_str(), "rb");
+		if (in == nullptr)
+			throw std::runtime_error("cannot open " + option.input);
+		std::FILE* out = option.output.empty() ? stdout : std::fopen(option.output.c_str(), "wb");
+		if (out == nullptr)
+			throw std::runtime_error("cannot open " + option.output);
+
+		/* bind the columns of the header to the variables */
+		LineReader reader(in);
+		std::string_view line;
+		if (!reader.next(line))
+			throw std::runtime_error("the input has no header line");
+		const std::string header(line);
+		std::vector<std::string_view> fields;
+		split(header, option.delimiter, fields);
+
+		std::vector<std::string> columns;  /* names of the fields */
+		for (std::string_view field : fields) {
+			while (!field.empty() && field.front() == ' ')
+				field.remove_prefix(1);
+			while (!field.empty() && field.back() == ' ')
+				field.remove_suffix(1);
+			if (field.size() >= 2 && field.front() == '"' && field.back() == '"')
+				field = field.substr(1, field.size() - 2);
+			columns.emplace_back(field);
+		}
+
+		std::vector<std::size_t>              bound;     /* field index of each bound column */
+		std::vector<SYAMFP::Program<double>>  programs;
+		std::vector<std::vector<std::size_t>> arguments; /* bound column of each free variable of the programs */
+		for (const std::string& formula : option.formulas) {
+			SYAMFP::Syamfp<double> parser;
+			if (parser.parse(formula, option.table) != 0) {
+				throw std::invalid_argument("invalid formula: " + formula);
+			}
+
+			std::vector<std::string> variables;
+			std::vector<std::size_t> args;
+			for (std::size_t k = 0; k < columns.size(); ++k) {
+				if (!parser.ret_variables().contains(columns[k]))
+					continue;
+				auto it = std::ranges::find(bound, k);
+				if (it == bound.end()) {
+					bound.push_back(k);
+					it = bound.end() - 1;
+				}
+				variables.push_back(columns[k]);
+				args.push_back(static_cast<std::size_t>(it - bound.begin()));
+			}
+			try {
+				programs.push_back(parser.ret_program(variables));
+			} catch (const std::runtime_error&) {
+				throw std::runtime_error("some variables of " + formula + " are neither columns nor given by -D");
+			}
+			arguments.push_back(args);
+		}
+
+		/* header of the output */
+		std::string head = option.keep ? header : std::string();
+		for (std::size_t p = 0; p < option.names.size(); ++p) {
+			if (option.keep || p > 0)
+				head += option.delimiter;
+			head += quote(option.names[p], option.delimiter);
+		}
+		head += '\n';
+		std::fwrite(head.data(), 1, head.size(), out);
+
+		/* chunks: depth in each of the queues and one in each stage */
+		const std::size_t total = 3 * option.depth + 3;
+		std::vector<std::unique_ptr<Chunk>> chunks;
+		Queue free_queue(total), parsed(option.depth), evaluated(option.depth);
+		for (std::size_t k = 0; k < total; ++k) {
+			chunks.push_back(std::make_unique<Chunk>());
+			chunks.back()->columns.resize(bound.size());
+			chunks.back()->results.resize(programs.size());
+			push_wait(free_queue, chunks.back().get());
+		}
+
+		std::exception_ptr read_error, eval_error;    /* read by the main thread after join() */
+		std::atomic<bool>  stop        = false;       /* set if writing or evaluation fails */
+		std::atomic<bool>  eval_failed = false;       /* set before the failed chunk is pushed */
+
+		std::thread read_stage([&]
+		{
+			std::vector<std::string_view> fields;
+			bool last = false;
+			while (!last) {
+				Chunk* chunk = pop_wait(free_queue);
+				chunk->rows = 0;
+				chunk->text.clear();
+				chunk->ends.clear();
+				for (std::vector<double>& column : chunk->columns) {
+					column.resize(option.rows);
+				}
+
+				try {
+					while (chunk->rows < option.rows && !stop) {
+						std::string_view line;
+						if (!reader.next(line)) {
+							last = true;
+							break;
+						}
+						if (line.empty())
+							continue;
+
+						split(line, option.delimiter, fields);
+						for (std::size_t k = 0; k < bound.size(); ++k) {
+							chunk->columns[k][chunk->rows] = (bound[k] < fields.size())
+								? to_number(fields[bound[k]])
+								: std::numeric_limits<double>::quiet_NaN();
+						}
+						if (option.keep) {
+							chunk->text.append(line);
+							chunk->ends.push_back(chunk->text.size());
+						}
+						chunk->rows++;
+					}
+				} catch (...) {
+					read_error = std::current_exception();
+					last = true;
+				}
+
+				last = last || stop;
+				chunk->last = last;
+				push_wait(parsed, chunk);
+			}
+		});
+
+		std::thread eval_stage([&]
+		{
+			bool last = false;
+			while (!last) {
+				Chunk* chunk = pop_wait(parsed);
+				last = chunk->last;
+				try {
+					if (!eval_failed && chunk->rows > 0) {
+						for (std::size_t p = 0; p < programs.size(); ++p) {
+							std::vector<const double*> cols;
+							for (std::size_t k : arguments[p]) {
+								cols.push_back(chunk->columns[k].data());
+							}
+							chunk->results[p].resize(chunk->rows);
+							programs[p].eval_batch(chunk->rows, cols.data(), chunk->results[p].data(), option.threads);
+						}
+					}
+				} catch (...) {
+					eval_error = std::current_exception();
+					eval_failed = true;
+					stop = true;
+				}
+				push_wait(evaluated, chunk);
+			}
+		});
+
+		/* format and write in this thread */
+		bool last = false;
+		bool write_error = false;
+		while (!last) {
+			Chunk* chunk = pop_wait(evaluated);
+			last = chunk->last;
+			if (!eval_failed && !write_error) {
+				format(option, *chunk);
+				if (std::fwrite(chunk->out.data(), 1, chunk->out.size(), out) != chunk->out.size()) {
+					write_error = true;
+					stop = true;
+				}
+			}
+			push_wait(free_queue, chunk);
+		}
+		read_stage.join();
+		eval_stage.join();
+
+		if (std::fflush(out) != 0)
+			write_error = true;
+		if (in != stdin)
+			std::fclose(in);
+		if (out != stdout)
+			std::fclose(out);
+
+		if (read_error)
+			std::rethrow_exception(read_error);
+		if (eval_error)
+			std::rethrow_exception(eval_error);
+		if (write_error)
+			throw std::runtime_error("failed to write the output");
+		return 0;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	Options option;
+	try {
+		if (!parse_options(argc, argv, option)) {
+			std::fputs(USAGE, stderr);
+			return 2;
+		}
+	} catch (const std::exception&) {
+		std::fputs(USAGE, stderr);
+		return 2;
+	}
+
+	try {
+		return run(option);
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "syamfp-eval: %s\n", e.what());
+		return 1;
+	}
+}